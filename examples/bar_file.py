@@ -0,0 +1,28 @@
+import os
+import tempfile
+
+import raycandle
+from raycandle import cmnfunc as cfc
+
+PATH = os.path.join(tempfile.gettempdir(), "raycandle_example.bars")
+SECONDS = 60
+
+
+def main(_=None):
+    if not os.path.exists(PATH):  # written once, mapped by every later run
+        df = raycandle.fake_stock_data(2_000_000, SECONDS)
+        df["sma200"] = df["c"].rolling(200, min_periods=1).mean()
+        raycandle.BarFile.write(PATH, df[cfc.COLUMNS + ["sma200"]], SECONDS)
+    bars = raycandle.BarFile.open(PATH)
+    fig = raycandle.Figure()
+    fig.attach_bar_file(bars)
+    fig.ax[0].plot(raycandle.BarFileCandle(bars, "o", label="ohlc"))
+    fig.ax[0].plot(raycandle.BarFileLine(bars, "sma200", label="sma200"))
+    fig.show_legend()
+    fig.set_title(f"{bars.rows} bars mapped from {PATH}")
+    fig.show()
+    bars.close()
+
+
+if __name__ == "__main__":
+    main()
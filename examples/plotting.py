@@ -46,12 +46,30 @@ def candlestick_chart(name):
     """Basic candlestick chart."""
     print(f"running example {name!r}")
     fig = raycandle.Figure("ab\ncd")
-    fig.ax[0].plot(raycandle.Candle(df))
+    candle = fig.ax[0].plot(raycandle.Candle(df))
+    volume = ((df["h"] - df["l"]) * 1000).rename("volume")  # a stand in
+    fig.ax[2].plot(raycandle.Bar(volume, color_by=candle, label="Volume"))
     fig.set_title("Candlesticks")
     fig.show_cursors()
     fig.show()
 
 
+def depth_heatmap(name):
+    """Order book depth behind candlesticks."""
+    print(f"running example {name!r}")
+    fig = raycandle.Figure("a")
+    fig.ax[0].plot(raycandle.Candle(df))
+    step = (df["h"].max() - df["l"].min()) / 100
+    levels = df["l"].min() + step * np.arange(100)
+    # a stand in: depth resting around the close
+    depth = np.exp(-(((levels[None, :] - df["c"].to_numpy()[:, None]) / (20 * step)) ** 2))
+    depth = pd.DataFrame(depth, index=df.index, columns=[f"d{i}" for i in range(100)])
+    fig.ax[0].plot(raycandle.Heatmap(depth, levels[0], step, label="Depth"))
+    fig.set_title("Depth")
+    fig.show_cursors()
+    fig.show()
+
+
 def indicators_demo(name):
     """Demonstrate basic technical indicators."""
     print(f"running example {name!r}")
@@ -63,7 +81,9 @@ def indicators_demo(name):
     fig.ax[1].plot(raycandle.sma(df["c"], 10), label="SMA(10)")
     fig.ax[1].plot(raycandle.sma(df["c"], 20), label="SMA(20)")
 
-    for x in raycandle.macd(df["c"]):
+    signal, md = raycandle.macd(df["c"])
+    fig.ax[3].plot(raycandle.Bar((md - signal).rename("hist"), label="MACD hist"))
+    for x in (signal, md):
         fig.ax[3].plot(x, label="MACD")
 
     fig.show_legend()
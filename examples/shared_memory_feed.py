@@ -0,0 +1,48 @@
+import multiprocessing
+import time
+
+import raycandle
+from raycandle import cmnfunc as cfc
+
+FEED = "raycandle_example"
+SECONDS = 600
+
+
+def produce():
+    """
+    a separate process publishing bars; it could as well be a C program
+    using feed_create/feed_publish
+    """
+    df = raycandle.fake_stock_data(5000, SECONDS)
+    df["sma20"] = df["c"].rolling(20, min_periods=1).mean()
+    feed = raycandle.Feed.create(FEED, cols=5, capacity=1 << 16, timeframe=SECONDS)
+    for x, row in zip(df.index, df[cfc.COLUMNS + ["sma20"]].to_numpy()):
+        feed.publish(x, row)
+        feed.update_last(row)  # e.g a forming candle
+        time.sleep(0.05)
+
+
+def main(_=None):
+    producer = multiprocessing.Process(target=produce, daemon=True)
+    producer.start()
+    while True:  # until the producer published its first bar
+        try:
+            feed = raycandle.Feed.open(FEED)
+            if feed.published > 0:
+                break
+            feed.close()
+        except OSError:
+            pass
+        time.sleep(0.1)
+    fig = raycandle.Figure()
+    fig.attach_feed(feed)
+    fig.ax[0].plot(raycandle.FeedCandle(0, label="ohlc"))
+    fig.ax[0].plot(raycandle.FeedLine(4, label="sma20"))
+    fig.show_legend()
+    fig.set_title("bars published by another process through shared memory")
+    fig.show()
+    feed.unlink()
+
+
+if __name__ == "__main__":
+    main()
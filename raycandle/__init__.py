@@ -4,8 +4,11 @@ raycandle
 A simple library for plotting candlesticks using raylib with an api that might look similar to matplotlib.
 """
 
-from .artists import Candle, Line
+from .artists import Bar, Candle, Heatmap, Line
 from .axes import Axes
 from .cmnfunc import *
 from .defines import *
+from .bar_file import BarFile, BarFileBar, BarFileCandle, BarFileLine
+from .feed import Feed, FeedBar, FeedCandle, FeedLine
 from .figure import Collector, Figure
+from .indicators import compute_indicator
@@ -4,10 +4,10 @@ import numpy as np
 import pandas as pd
 from typing_extensions import override
 
-from .bases import RC_Artist, ascii_encode, window_not_closed
+from .bases import RC_Artist, ascii_encode, numpy_values, numpy_view, window_not_closed
 from .defines import *
 
-__all__ = ["Line", "Candle"]
+__all__ = ["Line", "Candle", "Bar", "Heatmap"]
 
 
 class Line(RC_Artist):
@@ -20,7 +20,7 @@ class Line(RC_Artist):
         label: str = None,
         label_from_data: bool = False,
     ):
-        self.ydata = line.to_numpy(dtype=np.float64)
+        self.ydata = numpy_values(line)  # read in place, see `RC_Artist.set_data`
         if line_type == LineType.S_LINE:
             self.xdata = line.index.to_numpy(dtype=np.float64)
         self.line_type = line_type
@@ -39,14 +39,13 @@ class Line(RC_Artist):
     def _get_create_args(self) -> tuple[Any]:
         self.config = self._rc_api.ffi.new("LineData*")
         self.config.line_type = self.line_type
-        self.config.data = self._rc_api.ffi.NULL
-        self._ydata_pointer = self._rc_api.ffi.cast("double*", self.ydata.ctypes.data)
+        self.config.points = self._rc_api.ffi.NULL
         self._label = (
             self._rc_api.cstr(self.label)
             if self.label is not None
             else self._rc_api.ffi.NULL
         )
-        gdata = {"cols": 1, "ydata": self._ydata_pointer, "label": self._label}
+        gdata = numpy_view(self._rc_api, self.ydata, self._label)
         self._color_ptr = self._rc_api.ffi.cast(
             "CFFI_Color*",
             self.color.ctypes.data if self.color is not None else self._rc_api.ffi.NULL,
@@ -54,7 +53,7 @@ class Line(RC_Artist):
         return (
             ArtistType.LINE,
             gdata,
-            (np.nanmin(self.ydata), np.nanmax(self.ydata)),
+            self._rc_api.ffi.NULL,  # limits come from the artist's range index
             self.thick,
             self._color_ptr,
             self.config,
@@ -65,12 +64,17 @@ class Line(RC_Artist):
     def set_data(self, data: pd.Series) -> None:
         if not hasattr(self, "xdata"):
             raise Exception("cannot set data for non segmented line")
-        if len(data) != len(self.xdata):
+        if len(data) != self._rc_api.lib.figure_base_len(self._rc_api.fig):
             raise Exception("length mismatch")
-        self.ydata = data.to_numpy(dtype=np.float64)
-        self.__artist__.gdata.ydata = self._rc_api.ffi.cast(
-            "double*", self.ydata.ctypes.data
+        published = self.ydata
+        self.ydata = numpy_values(data)
+        self._rc_api.lib.artist_set_view(
+            self.__artist__,
+            numpy_view(self._rc_api, self.ydata, self.__artist__.gdata.label),
         )
+        # drawn until the next change is published; the one before it may still be
+        # drawn until artist_set_view returns
+        self._published = published
 
 
 class Candle(RC_Artist):
@@ -89,7 +93,7 @@ class Candle(RC_Artist):
             raise Exception("len of candle columns should be 4")
         self.__data_names__ = df.columns
         self.xdata = df.index.to_numpy(dtype=np.float64)
-        self.ydata = df.to_numpy(dtype=np.float64).flatten(order="F")
+        self.ydata = numpy_values(df)  # read in place, see `RC_Artist.set_data`
         if label_from_data and label is None:
             label = f"Candlestick({','.join([str(x) for x in df.columns])})"
         self.label = label
@@ -107,12 +111,7 @@ class Candle(RC_Artist):
             if self.label is not None
             else self._rc_api.ffi.NULL
         )
-        self._ydata_pointer = self._rc_api.ffi.cast("double*", self.ydata.ctypes.data)
-        gdata = (
-            4,
-            self._ydata_pointer,
-            self._label,
-        )
+        gdata = numpy_view(self._rc_api, self.ydata, self._label)
         self._color_pointer = self._rc_api.ffi.cast(
             "CFFI_Color*",
             self.color.ctypes.data if self.color is not None else self._rc_api.ffi.NULL,
@@ -120,7 +119,7 @@ class Candle(RC_Artist):
         return (
             ArtistType.CANDLE,
             gdata,
-            [np.nanmin(self.ydata), np.nanmax(self.ydata)],
+            self._rc_api.ffi.NULL,  # limits come from the artist's range index
             self.thick,
             self._color_pointer,
             self._rc_api.ffi.NULL,
@@ -128,11 +127,161 @@ class Candle(RC_Artist):
 
     @override
     def set_data(self, data: pd.DataFrame) -> None:
-        if len(data) != len(self.xdata):
+        if len(data) != self._rc_api.lib.figure_base_len(self._rc_api.fig):
             raise Exception("length mismatch")
         if (len(data.columns)) != 4:
             raise Exception("len of candle columns should be 4")
-        self.ydata = data.to_numpy(dtype=np.float64).flatten(order="F")
-        self.__artist__.gdata.ydata = self._rc_api.ffi.cast(
-            "double*", self.ydata.ctypes.data
+        published = self.ydata
+        self.ydata = numpy_values(data)
+        self._rc_api.lib.artist_set_view(
+            self.__artist__,
+            numpy_view(self._rc_api, self.ydata, self.__artist__.gdata.label),
+        )
+        # drawn until the next change is published; the one before it may still be
+        # drawn until artist_set_view returns
+        self._published = published
+
+
+class Bar(RC_Artist):
+    """
+    bars from `baseline` to the values of `data`, as wide as candle bodies, e.g
+    volumes or a MACD histogram. A bar is drawn in `colors[1]` when rising and
+    `colors[0]` otherwise: rising is a value above the baseline, or the bar of
+    the Candle `color_by` rising. The bars of an axes are drawn in one batch.
+    For volumes `set_aggregation(Aggregation.SUM)` sums them at coarser timeframes
+    """
+
+    def __init__(
+        self,
+        data: pd.Series,
+        baseline: float = 0.0,
+        color_by: Optional[Candle] = None,
+        colors: tuple[int] = (Candle.RED, Candle.GREEN),
+        label: str = None,
+        label_from_data: bool = False,
+    ):
+        self.ydata = numpy_values(data)  # read in place, see `RC_Artist.set_data`
+        self.xdata = data.index.to_numpy(dtype=np.float64)
+        self.baseline = baseline
+        self.color_by = color_by
+        if label is None and label_from_data:
+            label = str(data.name)
+        self.label = label
+        self.__data_names__ = data.name
+        self.color = np.array(colors) if colors is not None else None
+        if self.color is not None:
+            self.color = self.color.flatten("C").astype(np.int8)
+            if len(self.color) != 8:
+                raise Exception("colors must be of shape 2x4")
+
+    @override
+    def _get_create_args(self) -> tuple[Any]:
+        ffi = self._rc_api.ffi
+        self.config = ffi.new("BarData*")
+        self.config.baseline = self.baseline
+        if self.color_by is not None:
+            self.config.color_by = self.color_by.__artist__  # plotted first
+        self._label = (
+            self._rc_api.cstr(self.label) if self.label is not None else ffi.NULL
+        )
+        self._color_pointer = ffi.cast(
+            "CFFI_Color*", self.color.ctypes.data if self.color is not None else ffi.NULL
+        )
+        return (
+            ArtistType.BAR,
+            numpy_view(self._rc_api, self.ydata, self._label),
+            ffi.NULL,  # limits come from the artist's range index
+            1.0,
+            self._color_pointer,
+            self.config,
+        )
+
+    @override
+    @window_not_closed
+    def set_data(self, data: pd.Series) -> None:
+        if len(data) != self._rc_api.lib.figure_base_len(self._rc_api.fig):
+            raise Exception("length mismatch")
+        published = self.ydata
+        self.ydata = numpy_values(data)
+        self._rc_api.lib.artist_set_view(
+            self.__artist__,
+            numpy_view(self._rc_api, self.ydata, self.__artist__.gdata.label),
+        )
+        # drawn until the next change is published; the one before it may still be
+        # drawn until artist_set_view returns
+        self._published = published
+
+
+class Heatmap(RC_Artist):
+    """
+    order book depth or volume profile drawn behind prices: `data` has a row per
+    bar and a column per price level, level `c` spanning
+    [price_min + c * price_step, price_min + (c + 1) * price_step). Intensities
+    are shaded from `colors[0]` at 0 to `colors[1]` at `intensity_max` (the
+    largest intensity seen when 0), NaN is left transparent. The heatmap does not
+    set the ylims of its axes, plot it with prices. When bars are appended with
+    `update_last` only the new column is shaded and uploaded
+    """
+
+    def __init__(
+        self,
+        data: pd.DataFrame,
+        price_min: float,
+        price_step: float,
+        intensity_max: float = 0.0,
+        colors: Optional[tuple[int]] = None,
+        label: str = None,
+    ):
+        if price_step <= 0:
+            raise Exception("price_step must be positive")
+        self.ydata = numpy_values(data)  # read in place, see `RC_Artist.set_data`
+        self.xdata = data.index.to_numpy(dtype=np.float64)
+        self.price_min = price_min
+        self.price_step = price_step
+        self.intensity_max = intensity_max
+        self.label = label
+        self.__data_names__ = data.columns
+        self.color = np.array(colors) if colors is not None else None
+        if self.color is not None:
+            self.color = self.color.flatten("C").astype(np.int8)
+            if len(self.color) != 8:
+                raise Exception("colors must be of shape 2x4")
+
+    @override
+    def _get_create_args(self) -> tuple[Any]:
+        ffi = self._rc_api.ffi
+        self.config = ffi.new("HeatmapData*")
+        self.config.price_min = self.price_min
+        self.config.price_step = self.price_step
+        self.config.intensity_max = self.intensity_max
+        self._label = (
+            self._rc_api.cstr(self.label) if self.label is not None else ffi.NULL
+        )
+        self._color_pointer = ffi.cast(
+            "CFFI_Color*", self.color.ctypes.data if self.color is not None else ffi.NULL
+        )
+        return (
+            ArtistType.HEATMAP,
+            numpy_view(self._rc_api, self.ydata, self._label),
+            ffi.NULL,  # price levels, see `heatmap_ylim`
+            1.0,
+            self._color_pointer,
+            self.config,
+        )
+
+    @override
+    @window_not_closed
+    def set_data(self, data: pd.DataFrame) -> None:
+        if len(data) != self._rc_api.lib.figure_base_len(self._rc_api.fig):
+            raise Exception("length mismatch")
+        if len(data.columns) != self.ydata.shape[1]:
+            raise Exception("the number of price levels cannot change")
+        published = self.ydata
+        self.ydata = numpy_values(data)
+        self._rc_api.lib.artist_set_view(
+            self.__artist__,
+            numpy_view(self._rc_api, self.ydata, self.__artist__.gdata.label),
         )
+        # drawn until the next change is published; the one before it may still be
+        # drawn until artist_set_view returns
+        self._published = published
@@ -1,4 +1,4 @@
-from typing import NoReturn, Type, Union, final
+from typing import NoReturn, Optional, Type, Union, final
 
 import numpy as np
 import pandas as pd
@@ -6,6 +6,7 @@ import pandas as pd
 from .artists import Line
 from .bases import RC_Artist, RC_Axes, RC_Figure, window_not_closed
 from .defines import *
+from .indicators import indicator_names, indicator_params
 
 
 class Axes(RC_Axes):
@@ -70,10 +71,42 @@ class Axes(RC_Axes):
         self._hold_ref.append(artist)
         return artist
 
+    @window_not_closed
+    def indicator(
+        self,
+        source: RC_Artist,
+        indicator: IndicatorType,
+        *params: int,
+        names: Optional[list[str]] = None,
+        **kwargs,
+    ) -> list[Line]:
+        """
+        plots `indicator` of `source` (a Candle, or a Line for SMA, EMA, RSI and
+        Bollinger) on this axes and returns its output lines. The library keeps
+        them current: `update_last` of `source` updates their last bar, `set_data`
+        recomputes them, without going back to pandas. Indicators of indicators
+        follow too, e.g `ax.indicator(rsi_line, IndicatorType.EMA, 5)`.
+        `kwargs` go to every `Line`. Call it before `show`
+        """
+        xdata = self._parent._xdata
+        lines = [  # NaN until the library fills them
+            self.plot(Line(pd.Series(np.nan, index=xdata, name=n), **kwargs))
+            for n in indicator_names(indicator, names)
+        ]
+        ffi = self._rc_api.ffi
+        self._rc_api.lib.create_indicator(
+            source.__artist__,
+            int(indicator),
+            ffi.new("size_t[3]", indicator_params(indicator, params)),
+            ffi.new("Artist*[]", [line.__artist__ for line in lines]),
+        )
+        return lines
+
     @final
     @window_not_closed
     def set_forecolor(self, color: tuple[int, int, int, int]) -> None:
         self._rc_api.fig.axes[self._id].facecolor = color
+        self._rc_api.fig.force_update = True  # redraw the cached layers
 
     @final
     @window_not_closed
@@ -89,7 +122,7 @@ class Axes(RC_Axes):
     @window_not_closed
     def set_xlim(self, *args, **kwargs) -> NoReturn:
         raise NotImplementedError(
-            "all axes share same x-axis for now. to update all axes xlim, update from a point using Figure.update_from_position"
+            "all axes share same x-axis for now. to update all axes xlim, use Figure.set_xlim"
         )
 
     @final
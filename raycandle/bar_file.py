@@ -0,0 +1,114 @@
+from typing import Any, Optional
+
+import numpy as np
+import pandas as pd
+
+from .bases import numpy_values, numpy_view
+from .feed import FeedBar, FeedCandle, FeedLine
+from .figure import load_api
+
+__all__ = ["BarFile", "BarFileLine", "BarFileCandle", "BarFileBar"]
+
+
+class BarFile:
+    """
+    bars stored column by column in a file that figures map instead of
+    loading, see `Figure.attach_bar_file`
+    """
+
+    def __init__(self, file: Any) -> None:
+        self._api = load_api()
+        self._file = file
+
+    @staticmethod
+    def write(path: str, df: pd.DataFrame, timeframe: Optional[int] = None) -> None:
+        """
+        writes `df` (indexed by increasing epochs) to `path`. `timeframe`
+        defaults to the most common spacing of the index
+        """
+        api = load_api()
+        xdata = np.ascontiguousarray(df.index, dtype=np.float64)
+        ydata = numpy_values(df)  # float32/int64 frames are written without a copy
+        if timeframe is None:
+            timeframe = int(pd.Series(np.diff(xdata)).mode().iloc[0])
+        names = [api.cstr(str(x)) for x in df.columns]
+        if not api.lib.bar_file_write(
+            api.cstr(path),
+            len(df),
+            timeframe,
+            api.ffi.cast("double*", xdata.ctypes.data),
+            numpy_view(api, ydata, api.ffi.NULL),
+            api.ffi.new("char*[]", names),
+        ):
+            raise OSError(f"cannot write '{path}'")
+
+    @classmethod
+    def open(cls, path: str) -> "BarFile":
+        api = load_api()
+        file = api.lib.bar_file_open(api.cstr(path))
+        if file == api.ffi.NULL:
+            raise OSError(f"cannot open bar file '{path}'")
+        return cls(file)
+
+    @property
+    def rows(self) -> int:
+        return self._api.lib.bar_file_rows(self._file)
+
+    @property
+    def cols(self) -> int:
+        return self._api.lib.bar_file_cols(self._file)
+
+    def find(self, name: str) -> int:
+        """
+        index of the value column `name`
+        """
+        col = self._api.lib.bar_file_find(self._file, self._api.cstr(name))
+        if col < 0:
+            raise KeyError(name)
+        return col
+
+    def close(self) -> None:
+        """
+        unmaps the file. Figures attached to it must have been destroyed
+        """
+        self._api.lib.bar_file_close(self._file)
+        self._file = self._api.ffi.NULL
+
+
+class BarFileLine(FeedLine):
+    """
+    a Line of value column `col` (an index or a name) of `file`
+    """
+
+    def __init__(self, file: BarFile, col: Any, **kwargs):
+        super().__init__(file.find(col) if isinstance(col, str) else col, **kwargs)
+        self._file = file
+
+    def _gdata(self, cols: int) -> Any:
+        return self._rc_api.lib.bar_file_gdata(
+            self._file._file, self.col, cols, self._label
+        )
+
+
+class BarFileCandle(FeedCandle):
+    """
+    a Candle of the value columns [col, col+4) of `file`, in o,h,l,c order
+    """
+
+    def __init__(self, file: BarFile, col: Any = 0, **kwargs):
+        super().__init__(file.find(col) if isinstance(col, str) else col, **kwargs)
+        self._file = file
+
+    _gdata = BarFileLine._gdata
+
+
+class BarFileBar(FeedBar):
+    """
+    Bars of value column `col` (an index or a name) of `file`, e.g volumes
+    """
+
+    def __init__(self, file: BarFile, col: Any, **kwargs):
+        super().__init__(file.find(col) if isinstance(col, str) else col, **kwargs)
+        self._file = file
+
+    _gdata = BarFileLine._gdata
@@ -10,6 +10,8 @@ __all__ = [
     "Color",
     "RC_Figure",
     "RC_Artist",
+    "numpy_view",
+    "numpy_values",
 ]
 Color = NewType("Color", tuple[int, int, int, int])
 
@@ -38,6 +40,45 @@ def window_not_closed(func: _T) -> _T:
     return wrapper
 
 
+_DATA_TYPES = {
+    np.dtype(np.float64): DataType.FLOAT64,
+    np.dtype(np.float32): DataType.FLOAT32,
+    np.dtype(np.int64): DataType.INT64,
+}
+
+
+def numpy_view(api: "_Api", values: np.ndarray, label: Any) -> dict[str, Any]:
+    """
+    the Gdata reading `values` (rows x columns, or a single column) in place: the
+    columns keep their dtype and strides, so a pandas float32 frame or row-major
+    records are not copied. Other dtypes and negative strides are not readable by
+    the library, the caller converts those first (see `numpy_values`)
+    """
+    item = values.itemsize
+    strides = values.strides if values.ndim == 2 else (values.strides[0], 0)
+    return {
+        "cols": values.shape[1] if values.ndim == 2 else 1,
+        "ydata": api.ffi.cast("double*", values.ctypes.data),
+        "label": label,
+        "stride": strides[1] // item,
+        "dtype": int(_DATA_TYPES[values.dtype]),
+        "row_stride": strides[0] // item,
+    }
+
+
+def numpy_values(data: Any) -> np.ndarray:
+    """
+    the values of a Series/DataFrame the library reads in place, without a copy
+    when their dtype is float64, float32 or int64. Others are copied to float64
+    columns, the layout the library reads fastest
+    """
+    values = data.to_numpy()
+    readable = values.dtype in _DATA_TYPES and all(
+        s > 0 and s % values.itemsize == 0 for s in values.strides
+    )
+    return values if readable else np.asfortranarray(values, dtype=np.float64)
+
+
 class _Api:
     lib: Any
     fig: Any
@@ -80,16 +121,36 @@ class RC_Artist(SupportsRayCandleApi):
         updates the artist data.
         NOTE:
         ------
-        Care should be taken as `RC_Artist.ydata` is a shared reference
+        Care should be taken as `RC_Artist.ydata` is a shared reference: the
+        values of the Series/DataFrame are read in place when their dtype is
+        float64, float32 or int64 (see `numpy_values`), so changing the frame
+        changes the plot until the figure owns copies (`update_last`,
+        `Figure.append_bar`), which never write into it.
         If need be to change `RC_Artist.ydata` one could:
             1. copy the new data into `RC_Artist.ydata` using a loop. New data
         should have the same length
-            2. Drop the reference  by assigning `RC_Artist` to some new numpy float64 array
-        (which must be C_CONTINGUOUS) and then cast it's ctypes.data to double* and assign  that
-        pointer to the appropriate value
+            2. Drop the reference by assigning `RC_Artist.ydata` to some new numpy
+        array and passing its Gdata (`numpy_view`) to `artist_set_view` so that the
+        artist's range index is rebuilt
         """
         raise NotImplementedError
 
+    @final
+    @window_not_closed
+    def update_last(self, values: Any) -> None:
+        """
+        sets the last bar of the artist to `values`, one value per column
+        e.g (o, h, l, c) for a candle. Only the last slot is redrawn unless the ylims change.
+        The first call copies the data of the figure into buffers it owns, as
+        `Figure.append_bar` does, so the Series/DataFrame is never written
+        """
+        values = np.ascontiguousarray(values, dtype=np.float64).ravel()
+        if len(values) != self.__artist__.gdata.cols:
+            raise Exception("length mismatch")
+        self._rc_api.lib.artist_update_last(
+            self.__artist__, self._rc_api.ffi.cast("double*", values.ctypes.data)
+        )
+
     @final
     @window_not_closed
     def set_lw(self, lw: float) -> None:
@@ -97,6 +158,16 @@ class RC_Artist(SupportsRayCandleApi):
         set line width
         """
         self.__artist__.thickness = lw
+        self._rc_api.fig.force_update = True  # redraw the cached layers
+
+    @final
+    @window_not_closed
+    def set_aggregation(self, aggregation: Aggregation) -> None:
+        """
+        how `Figure.resample` combines the bars of a bucket, e.g `Aggregation.SUM`
+        for volumes. Candles default to `Aggregation.OHLC`, others to `Aggregation.LAST`
+        """
+        self._rc_api.lib.artist_set_aggregation(self.__artist__, int(aggregation))
 
     @final
     @window_not_closed
@@ -105,6 +176,7 @@ class RC_Artist(SupportsRayCandleApi):
         whether the artists will be considered when ylims of its axes are calculated
         """
         self.__artist__.ylim_consider = False
+        self._rc_api.fig.force_update = True
 
 
 class RC_Axes(SupportsRayCandleApi):
@@ -0,0 +1,123 @@
+#define _POSIX_C_SOURCE 200112L // posix_memalign
+#include "arena.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils.h"
+
+struct ArenaSlab {
+  ArenaSlab *prev, *next; // every slab of the arena
+  size_t size, used;      // bytes after the header
+};
+
+struct Arena {
+  ArenaSlab slabs;    // sentinel of the circular slab list
+  ArenaSlab *current; // slab small blocks are bumped from
+  size_t reserved;
+  pthread_mutex_t lock; // artists of different axes grow on pool threads
+};
+
+#define RC_ARENA_HEADER                                                        \
+  ((sizeof(ArenaSlab) + RC_ARENA_ALIGN - 1) / RC_ARENA_ALIGN * RC_ARENA_ALIGN)
+#define RC_ARENA_SMALL_ALIGN 16
+
+static ArenaSlab *arena_slab_alloc(size_t size);
+static ArenaSlab *arena_slab_create(Arena *arena, size_t size);
+static inline char *arena_slab_data(ArenaSlab *slab);
+
+static ArenaSlab *arena_slab_alloc(size_t size) {
+  void *memory = NULL;
+  if (posix_memalign(&memory, RC_ARENA_ALIGN, RC_ARENA_HEADER + size) != 0) {
+    RC_ERROR("cannot allocate an arena slab of %zu bytes\n", size);
+  }
+  ArenaSlab *slab = (ArenaSlab *)memory;
+  *slab = (ArenaSlab){.prev = NULL, .next = NULL, .size = size, .used = 0};
+  return slab;
+}
+
+static ArenaSlab *arena_slab_create(Arena *arena, size_t size) {
+  ArenaSlab *slab = arena_slab_alloc(size);
+  slab->prev = arena->slabs.prev;
+  slab->next = &arena->slabs;
+  arena->slabs.prev->next = slab;
+  arena->slabs.prev = slab;
+  arena->reserved += RC_ARENA_HEADER + size;
+  return slab;
+}
+
+static inline char *arena_slab_data(ArenaSlab *slab) {
+  return (char *)slab + RC_ARENA_HEADER;
+}
+
+Arena *arena_create(void) { // the first slab holds the Arena itself
+  ArenaSlab *slab = arena_slab_alloc(RC_ARENA_SLAB_SIZE);
+  Arena *arena = (Arena *)arena_slab_data(slab);
+  *arena = (Arena){.slabs = {.prev = slab, .next = slab, .size = 0, .used = 0},
+                   .current = slab,
+                   .reserved = RC_ARENA_HEADER + RC_ARENA_SLAB_SIZE};
+  pthread_mutex_init(&arena->lock, NULL);
+  slab->prev = slab->next = &arena->slabs;
+  slab->used = sizeof(Arena);
+  return arena;
+}
+
+void arena_destroy(Arena *arena) {
+  ArenaSlab *first = (ArenaSlab *)((char *)arena - RC_ARENA_HEADER);
+  ArenaSlab *slab = arena->slabs.next;
+  while (slab != &arena->slabs) {
+    ArenaSlab *next = slab->next;
+    if (slab != first)
+      free(slab);
+    slab = next;
+  }
+  pthread_mutex_destroy(&arena->lock);
+  free(first); // last, it holds the list head
+}
+
+void *arena_alloc(Arena *arena, size_t bytes) {
+  RC_ASSERT(bytes > 0);
+  pthread_mutex_lock(&arena->lock);
+  if (bytes > RC_ARENA_LARGE) {
+    ArenaSlab *slab = arena_slab_create(arena, bytes);
+    slab->used = bytes;
+    pthread_mutex_unlock(&arena->lock);
+    return arena_slab_data(slab);
+  }
+  size_t align = bytes >= RC_ARENA_ALIGN ? RC_ARENA_ALIGN : RC_ARENA_SMALL_ALIGN;
+  ArenaSlab *slab = arena->current;
+  size_t offset = (slab->used + align - 1) / align * align;
+  if (offset + bytes > slab->size) {
+    slab = arena->current = arena_slab_create(arena, RC_ARENA_SLAB_SIZE);
+    offset = 0;
+  }
+  slab->used = offset + bytes;
+  pthread_mutex_unlock(&arena->lock);
+  return arena_slab_data(slab) + offset;
+}
+
+void arena_release(Arena *arena, void *ptr, size_t bytes) {
+  if (ptr == NULL || bytes <= RC_ARENA_LARGE)
+    return;
+  ArenaSlab *slab = (ArenaSlab *)((char *)ptr - RC_ARENA_HEADER); // its own slab
+  pthread_mutex_lock(&arena->lock);
+  RC_ASSERT(slab->used == bytes && slab->next->prev == slab,
+            "%p was not allocated with %zu bytes\n", ptr, bytes);
+  slab->prev->next = slab->next;
+  slab->next->prev = slab->prev;
+  arena->reserved -= RC_ARENA_HEADER + slab->size;
+  pthread_mutex_unlock(&arena->lock);
+  free(slab);
+}
+
+void *arena_resize(Arena *arena, void *ptr, size_t old_bytes, size_t bytes) {
+  void *resized = arena_alloc(arena, bytes);
+  if (ptr == NULL)
+    return resized;
+  memcpy(resized, ptr, old_bytes < bytes ? old_bytes : bytes);
+  arena_release(arena, ptr, old_bytes);
+  return resized;
+}
+
+size_t arena_size(const Arena *arena) { return arena->reserved; }
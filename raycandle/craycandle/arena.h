@@ -0,0 +1,43 @@
+/*
+ * Arena
+ * -----
+ * figure lifetime allocator. Allocations are bumped out of cache line aligned
+ * slabs of RC_ARENA_SLAB_SIZE bytes, in creation order, so the buffers of an
+ * axes or an artist that are used together every frame end up next to each
+ * other. Blocks larger than RC_ARENA_LARGE get a slab of their own so buffers
+ * that grow (appended data, vertices) can give the old block back right away.
+ * Nothing is freed one by one: arena_destroy releases every slab at once.
+ * Allocating and releasing are thread safe.
+ */
+#ifndef __RAYCANDLE_ARENA__
+#define __RAYCANDLE_ARENA__
+
+#include <stddef.h>
+
+#define RC_ARENA_ALIGN 64                 // cache line
+#define RC_ARENA_SLAB_SIZE (256 * 1024)   // bytes
+#define RC_ARENA_LARGE (RC_ARENA_SLAB_SIZE / 4)
+
+typedef struct ArenaSlab ArenaSlab;
+typedef struct Arena Arena;
+
+Arena *arena_create(void);
+void arena_destroy(Arena *arena); // frees every block of the arena
+/**
+returns `bytes` of uninitialised memory. blocks of RC_ARENA_ALIGN bytes or more
+start on a cache line, smaller ones are 16 byte aligned
+*/
+void *arena_alloc(Arena *arena, size_t bytes);
+/**
+gives a block of `bytes` (the size it was allocated with) back. Large blocks
+are freed at once, small ones are only reclaimed by arena_destroy
+*/
+void arena_release(Arena *arena, void *ptr, size_t bytes);
+/**
+returns a block of `bytes` holding the first min(old_bytes, bytes) bytes of
+`ptr` (NULL allocates) and releases `ptr`
+*/
+void *arena_resize(Arena *arena, void *ptr, size_t old_bytes, size_t bytes);
+size_t arena_size(const Arena *arena); // bytes reserved from the system
+
+#endif //__RAYCANDLE_ARENA__
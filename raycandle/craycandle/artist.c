@@ -4,29 +4,65 @@
 #include <math.h>
 #include <string.h>
 
+#include "arena.h"
 #include "axes.h"
+#include "bar_file.h"
+#include "batch.h"
+#include "canvas.h"
+#include "figure.h"
+#include "gdata.h"
+#include "heatmap.h"
+#include "indicator.h"
+#include "kernels.h"
+#include "layers.h"
+#include "mouse_updater.h"
+#include "publish.h"
+#include "range_index.h"
 #include "raycandle.h"
+#include "resample.h"
 #include "utils.h"
 
 typedef struct {
-  double *d0, *d1;
-  double *p0, *p1, *p2, *p3;
+  float *high, *top, *bottom, *low; // draw ready pixels per slot
   uint8_t *color_indexes;
+  double *gather;  // O,H,L,C data of aggregated slots before mapping
+  size_t capacity; // slots allocated, grows with the slots
   double width;
 } CandleData;
 
+typedef struct {
+  float *top;      // draw ready pixel of the value of each slot
+  uint8_t *color_indexes;
+  double *gather;  // values of aggregated slots before mapping
+  size_t capacity; // slots allocated, grows with the slots
+  double width;
+  float base; // pixel of the baseline
+  BarData config;
+} BarPixels;
+
 // init
 static void artist_init(Artist *artist, void *config);
 static void artist_line_init(Artist *artist, void *config);
 static void artist_candle_init(Artist *artist, void *config);
+static void artist_bar_init(Artist *artist, void *config);
 // update
 static void artist_line_update_data_buffer(Artist *artist, LimitChanged lim);
 static void artist_candle_update_data_buffer(Artist *artist, LimitChanged lim);
+static void artist_bar_update_data_buffer(Artist *artist, LimitChanged lim);
 // draw
 static void artist_line_plot(Artist *artist);
 static void artist_candle_plot(Artist *artist);
+static void artist_bar_plot(Artist *artist);
 static void artist_line_draw_icon(Artist *artist, Vector2 startPos);
 static void artist_candle_draw_icon(Artist *artist, Vector2 startPos);
+static void artist_bar_draw_icon(Artist *artist, Vector2 startPos);
+static void artist_heatmap_draw_icon(Artist *artist, Vector2 startPos);
+
+static inline YPixelMap artist_y_pixel_map(Artist *artist) {
+  Axes *axes = artist->parent;
+  return (YPixelMap){axes->ylocator.limit.limit_max, axes->ylocator.limit.diff,
+                     axes->height, axes->startY};
+}
 
 static void artist_init(Artist *artist, void *config) {
   switch (artist->artist_type) {
@@ -37,6 +73,13 @@ static void artist_init(Artist *artist, void *config) {
     RC_ASSERT(artist->gdata.cols == 4);
     artist_candle_init(artist, config);
     break;
+  case ARTIST_TYPE_BAR:
+    RC_ASSERT(artist->gdata.cols == 1);
+    artist_bar_init(artist, config);
+    break;
+  case ARTIST_TYPE_HEATMAP:
+    heatmap_init(artist, config);
+    break;
   default:
     RC_ERROR("artist type %d has not been implemented on '%s'\n",
              artist->artist_type, __func__);
@@ -45,18 +88,18 @@ static void artist_init(Artist *artist, void *config) {
 
 static void artist_line_init(Artist *artist, void *config) {
   LineData *line_data = (LineData *)config;
-  RC_ASSERT(line_data && !line_data->data);
-  CM_MALLOC(LineData *line_data_ , (sizeof(LineData)));
+  RC_ASSERT(line_data && !line_data->points);
+  Arena *arena = (Arena *)artist->parent->parent->arena;
+  LineData *line_data_ = arena_alloc(arena, sizeof(LineData));
+  *line_data_ = (LineData){.points = NULL, .x = NULL, .y = NULL, .capacity = 0};
   switch (line_data->line_type) {
-  case LINE_TYPE_S_LINE:    
-    CM_MALLOC(line_data_->data,RC_MAX_PLOTTABLE_LEN * sizeof(*line_data_->data));
-    break;
+  case LINE_TYPE_S_LINE:
+    break; // points are allocated on the first update, see artist_line_reserve
   case LINE_TYPE_H_LINE:
   case LINE_TYPE_V_LINE: {
-    RC_ASSERT(artist->gdata.ydata && artist->gdata.ydata[0] >= 0 &&
-              artist->gdata.ydata[0] <= 1);
-    CM_MALLOC(line_data_->data,sizeof(*line_data->data) * 2);
-    line_data_->data[0] = artist->gdata.ydata[0];
+    RC_ASSERT(artist->gdata.ydata && gdata_get(&artist->gdata, 0, 0) >= 0 &&
+              gdata_get(&artist->gdata, 0, 0) <= 1);
+    line_data_->position = gdata_get(&artist->gdata, 0, 0);
     artist->gdata.ydata = NULL;
     artist->ylim_consider = false; // these two are not used in finding ylims
     break;
@@ -66,8 +109,9 @@ static void artist_line_init(Artist *artist, void *config) {
     break;
   }
   line_data_->line_type = line_data->line_type;
+  line_data_->len = line_data_->tail = 0;
   artist->data = line_data_;
-  Color *CM_MALLOC(color,sizeof(Color));
+  Color *color = arena_alloc(arena, sizeof(Color));
   if (!artist->color) {
     *color = axes_get_next_tableau_t10_color(artist->parent);
   } else {
@@ -80,34 +124,27 @@ static void artist_candle_init(Artist *artist, void *config) {
   /*
 
 
-     d0   d1
+     x    x + width / 2 (x is the axes xdata_buffer)
   -------------------
-        | <------- p0
+        | <------- high
         |
-      ----- <----- p1
+      ----- <----- top
       |   |
       |   |
       |   |
-      ----- <----- p2
+      ----- <----- bottom
         |
-        |<---------p3
+        |<---------low
 
   */
   (void)config;
-  size_t vdata;
   CandleData *candledata;
   Color *color;
-  vdata = RC_MAX_PLOTTABLE_LEN;
-  CM_MALLOC(candledata,sizeof(CandleData));
-  candledata->d0 = artist->parent->xdata_buffer;
-  CM_MALLOC(candledata->d1,sizeof(double) * vdata * 5);
-  candledata->p0 = candledata->d1 + vdata * 1;
-  candledata->p1 = candledata->d1 + vdata * 2;
-  candledata->p2 = candledata->d1 + vdata * 3;
-  candledata->p3 = candledata->d1 + vdata * 4;
-  CM_MALLOC(candledata->color_indexes ,sizeof(*candledata->color_indexes) * vdata);
+  Arena *arena = (Arena *)artist->parent->parent->arena;
+  candledata = arena_alloc(arena, sizeof(CandleData));
+  *candledata = (CandleData){.capacity = 0}; // see artist_candle_reserve
   artist->data = (void *)candledata;
-  CM_MALLOC(color,sizeof(Color) * 2);
+  color = arena_alloc(arena, sizeof(Color) * 2);
   if (artist->color == NULL) {
     color[0] = axes_get_next_tableau_t10_color(artist->parent);
     color[1] = axes_get_next_tableau_t10_color(artist->parent);
@@ -117,29 +154,115 @@ static void artist_candle_init(Artist *artist, void *config) {
   artist->color = color;
 }
 
-static void artist_line_update_data_buffer(Artist *artist, LimitChanged lim) {
-  if (lim == LIMIT_CHANGED_XLIM) {
+static void artist_bar_init(Artist *artist, void *config) {
+  BarData *bar_data = (BarData *)config;
+  Arena *arena = (Arena *)artist->parent->parent->arena;
+  BarPixels *bars = arena_alloc(arena, sizeof(BarPixels));
+  *bars = (BarPixels){.capacity = 0}; // see artist_bar_reserve
+  if (bar_data != NULL)
+    bars->config = *bar_data;
+  Artist *color_by = bars->config.color_by;
+  if (color_by != NULL) {
+    RC_ASSERT(color_by->artist_type == ARTIST_TYPE_CANDLE &&
+                  color_by->parent->parent == artist->parent->parent &&
+                  color_by->index != NULL,
+              "bars are coloured by a candle with data of their figure\n");
+  }
+  artist->data = (void *)bars;
+  Color *color = arena_alloc(arena, sizeof(Color) * 2);
+  if (artist->color == NULL) {
+    color[0] = axes_get_next_tableau_t10_color(artist->parent);
+    color[1] = axes_get_next_tableau_t10_color(artist->parent);
+  } else {
+    memcpy(color, artist->color, sizeof(Color) * 2);
+  }
+  artist->color = color;
+}
+
+static void artist_line_reserve(Artist *artist, size_t len) {
+  LineData *line_data = (LineData *)artist->data;
+  if (len <= line_data->capacity)
     return;
-  } // user changing xlim does no change ylim
-  double *ydata = ((LineData *)artist->data)->data;
-  switch (((LineData *)artist->data)->line_type) {
+  Arena *arena = (Arena *)artist->parent->parent->arena;
+  size_t capacity = line_data->capacity;
+  line_data->points = arena_resize(arena, line_data->points,
+                                   sizeof(Vector2) * capacity,
+                                   sizeof(Vector2) * len);
+  line_data->x = arena_resize(arena, line_data->x, sizeof(double) * capacity,
+                              sizeof(double) * len);
+  line_data->y = arena_resize(arena, line_data->y, sizeof(double) * capacity,
+                              sizeof(double) * len);
+  line_data->capacity = len;
+}
+
+static inline void artist_line_push_point(Artist *artist, double x,
+                                          double y) {
+  // y stays a data value until kernel_points maps the points at once
+  LineData *line_data = (LineData *)artist->data;
+  line_data->x[line_data->len] = x;
+  line_data->y[line_data->len] = y;
+  line_data->len += 1;
+}
+
+static void artist_line_push_slot(Artist *artist, size_t slot) {
+  /*
+    M4 reduction: a slot holding more than one data point is drawn with its
+    first, min, max and last values so the shape survives decimation
+  */
+  Dragger *dragger = &artist->parent->parent->dragger;
+  double x = artist->parent->xdata_buffer[slot];
+  double swidth = artist->parent->width * dragger->slot_fill / dragger->slots;
+  double minmax[2], first, last;
+  size_t range[2], bucket;
+  ((LineData *)artist->data)->tail = ((LineData *)artist->data)->len;
+  dragger_slot_range(dragger, slot, range);
+  first = gdata_get(&artist->gdata, 0, range[0]);
+  if ((bucket = range[1] - range[0]) == 1) {
+    artist_line_push_point(artist, x, first);
+    return;
+  }
+  last = gdata_get(&artist->gdata, 0, range[1] - 1);
+  range_index_query(artist->index, &artist->gdata, range[0], range[1], minmax);
+  if (isnan(minmax[0])) { // nothing finite, keep the gap
+    artist_line_push_point(artist, x, first);
+    return;
+  }
+  if (isfinite(first))
+    artist_line_push_point(artist, x, first);
+  bool rising = !isfinite(first) || !isfinite(last) || last >= first;
+  artist_line_push_point(artist, x + swidth / 2, minmax[rising ? 0 : 1]);
+  artist_line_push_point(artist, x + swidth / 2, minmax[rising ? 1 : 0]);
+  if (isfinite(last))
+    artist_line_push_point(artist, x + swidth * (bucket - 1) / bucket, last);
+}
+
+static void artist_line_map_points(Artist *artist, size_t first) {
+  LineData *line_data = (LineData *)artist->data;
+  kernel_points(line_data->x + first, line_data->y + first,
+                (float *)(line_data->points + first), line_data->len - first,
+                artist_y_pixel_map(artist));
+}
+
+static void artist_line_update_data_buffer(Artist *artist, LimitChanged lim) {
+  (void)lim; // points carry both x and y so any change needs a recompute
+  LineData *line_data = (LineData *)artist->data;
+  switch (line_data->line_type) {
   case LINE_TYPE_S_LINE: {
-    double *pixel_data = artist->gdata.ydata;
-    size_t yindex = artist->parent->parent->dragger.start;
-    for (size_t i = 0; i < artist->parent->parent->dragger.vlen;
-         ++i, ++yindex) {
-      /* ydata[i]=RC_DATA_IN_LIMIT(pixel_data[yindex],artist->parent->ylocator.limit)?RC_DATA_Y_2_PIXEL(pixel_data[yindex],
-       * artist->parent):NAN; */
-      ydata[i] = RC_DATA_Y_2_PIXEL(pixel_data[yindex], artist->parent);
+    size_t slots = artist->parent->parent->dragger.slots;
+    artist_line_reserve(artist, slots * RC_LOD_LINE_POINTS);
+    line_data->len = 0;
+    for (size_t i = 0; i < slots; ++i) {
+      artist_line_push_slot(artist, i);
     }
+    artist_line_map_points(artist, 0);
     return;
   }
   case LINE_TYPE_H_LINE: {
-    ydata[1] = RC_DATA_Y_2_PIXEL(ydata[0], artist->parent);
+    line_data->pixel = RC_DATA_Y_2_PIXEL(line_data->position, artist->parent);
     return;
   }
   case LINE_TYPE_V_LINE: {
-    /* ydata[1]=RC_DATA_X_2_PIXEL(ydata[0],artist->parent); */
+    /* line_data->pixel=RC_DATA_X_2_PIXEL(line_data->position,artist->parent); */
     return;
   }
   default:
@@ -147,75 +270,198 @@ static void artist_line_update_data_buffer(Artist *artist, LimitChanged lim) {
   }
 }
 
+static void artist_candle_reserve(Artist *artist, size_t slots) {
+  CandleData *candledata = (CandleData *)artist->data;
+  if (slots <= candledata->capacity)
+    return;
+  Arena *arena = (Arena *)artist->parent->parent->arena;
+  size_t capacity = candledata->capacity;
+  // the 4 pixel rows of a slot window are one block, read together when drawn
+  candledata->high = arena_resize(arena, candledata->high,
+                                  sizeof(float) * capacity * 4,
+                                  sizeof(float) * slots * 4);
+  candledata->top = candledata->high + slots;
+  candledata->bottom = candledata->high + slots * 2;
+  candledata->low = candledata->high + slots * 3;
+  candledata->color_indexes = arena_resize(arena, candledata->color_indexes,
+                                           capacity, slots);
+  candledata->gather =
+      arena_resize(arena, candledata->gather, sizeof(double) * capacity * 4,
+                   sizeof(double) * slots * 4);
+  candledata->capacity = slots;
+}
+
+static inline void artist_candle_gather_rows(Artist *artist, size_t first,
+                                             const double *in[4]) {
+  CandleData *candledata = (CandleData *)artist->data;
+  size_t capacity = candledata->capacity;
+  for (size_t c = 0; c < 4; ++c)
+    in[c] = candledata->gather + capacity * c + first;
+}
+
+static void artist_candle_gather_slot(Artist *artist, size_t slot) {
+  // a slot aggregates its bars: O=first, H=max, L=min, C=last
+  Dragger *dragger = &artist->parent->parent->dragger;
+  CandleData *candledata = (CandleData *)artist->data;
+  const Gdata *gdata = &artist->gdata;
+  size_t capacity = candledata->capacity;
+  double *gather = candledata->gather + slot;
+  double minmax[2];
+  size_t range[2];
+  dragger_slot_range(dragger, slot, range);
+  if (range[1] - range[0] == 1) {
+    minmax[0] = gdata_get(gdata, 2, range[0]);
+    minmax[1] = gdata_get(gdata, 1, range[0]);
+  } else {
+    range_index_query(artist->index, gdata, range[0], range[1], minmax);
+  }
+  gather[0] = gdata_get(gdata, 0, range[0]);
+  gather[capacity] = minmax[1];
+  gather[capacity * 2] = minmax[0];
+  gather[capacity * 3] = gdata_get(gdata, 3, range[1] - 1);
+}
+
+static void artist_candle_map_slots(Artist *artist, size_t first, size_t len,
+                                    const double *const in[4]) {
+  CandleData *candledata = (CandleData *)artist->data;
+  float *const out[4] = {candledata->high + first, candledata->top + first,
+                         candledata->bottom + first, candledata->low + first};
+  kernel_candle_pixels(in, out, candledata->color_indexes + first, len,
+                       artist_y_pixel_map(artist));
+}
+
 static void artist_candle_update_data_buffer(Artist *artist, LimitChanged lim) {
-  size_t vdata = artist->parent->parent->dragger.vlen;
+  Dragger *dragger = &artist->parent->parent->dragger;
   CandleData *candledata = (CandleData *)artist->data;
   candledata->width =
-      ((double)artist->parent->width / artist->parent->parent->dragger.vlen) /
-      2.f;
-  size_t ldata = artist->parent->parent->dragger._len;
-  size_t yindex = artist->parent->parent->dragger.start;
-  bool ogtc;
-  double *cdata = artist->gdata.ydata;
-  for (size_t i = 0; i < vdata; ++i, ++yindex) {
-    /* if( */
-    /*   !RC_DATA_IN_LIMIT(cdata[yindex],artist->parent->ylocator.limit)|| */
-    /*   !RC_DATA_IN_LIMIT(cdata[ldata+yindex],artist->parent->ylocator.limit)||
-     */
-    /*   !RC_DATA_IN_LIMIT(cdata[ldata*2+yindex],artist->parent->ylocator.limit)||
-     */
-    /*   !RC_DATA_IN_LIMIT(cdata[ldata*3+yindex],artist->parent->ylocator.limit)
-     */
-    /* ){ */
-    /*   candledata->p0[i]=candledata->p1[i]=candledata->p2[i]=candledata->p3[i]=NAN;
-     */
-    /*   continue; */
-    /* } */
-    if (lim == LIMIT_CHANGED_XLIM || lim == LIMIT_CHANGED_ALL_LIM) {
-      candledata->d1[i] = candledata->d0[i] + (candledata->width / 2.f);
-    }
-    if (lim == LIMIT_CHANGED_YLIM || lim == LIMIT_CHANGED_ALL_LIM) {
-      ogtc = cdata[yindex] > cdata[ldata * 3 + yindex];
-      candledata->p0[i] =
-          RC_DATA_Y_2_PIXEL(cdata[ldata + yindex], artist->parent);
-      candledata->p1[i] = RC_DATA_Y_2_PIXEL(
-          ogtc ? cdata[yindex] : cdata[ldata * 3 + yindex], artist->parent);
-      candledata->p2[i] = RC_DATA_Y_2_PIXEL(
-          !ogtc ? cdata[yindex] : cdata[ldata * 3 + yindex], artist->parent);
-      candledata->p3[i] =
-          RC_DATA_Y_2_PIXEL(cdata[ldata * 2 + yindex], artist->parent);
-      candledata->color_indexes[i] = (uint8_t)!ogtc;
-    }
+      (artist->parent->width * dragger->slot_fill / dragger->slots) / 2.f;
+  if (lim != LIMIT_CHANGED_YLIM && lim != LIMIT_CHANGED_ALL_LIM)
+    return; // x pixels are read from the axes xdata_buffer when drawing
+  artist_candle_reserve(artist, dragger->slots);
+  if (dragger->slots == dragger->vlen &&
+      gdata_is_native(&artist->gdata)) { // a bar per slot, map the columns
+    size_t stride = artist->gdata.stride, start = dragger->start;
+    double *cdata = artist->gdata.ydata;
+    const double *const in[4] = {cdata + start, cdata + stride + start,
+                                 cdata + stride * 2 + start,
+                                 cdata + stride * 3 + start};
+    artist_candle_map_slots(artist, 0, dragger->slots, in);
+    return;
+  }
+  if (dragger->slots == dragger->vlen) { // read the window as doubles first
+    for (size_t c = 0; c < 4; ++c)
+      gdata_read(&artist->gdata, c, dragger->start, dragger->slots,
+                 candledata->gather + candledata->capacity * c);
+    const double *in[4];
+    artist_candle_gather_rows(artist, 0, in);
+    artist_candle_map_slots(artist, 0, dragger->slots, in);
+    return;
+  }
+  for (size_t i = 0; i < dragger->slots; ++i) {
+    artist_candle_gather_slot(artist, i);
   }
+  const double *in[4];
+  artist_candle_gather_rows(artist, 0, in);
+  artist_candle_map_slots(artist, 0, dragger->slots, in);
 }
 
-static void artist_line_plot(Artist *artist) {
-  LineData line_data = *(LineData *)artist->data;
-  double *xdata = artist->parent->xdata_buffer;
-  switch (line_data.line_type) {
-  case LINE_TYPE_S_LINE: {
-    size_t visible_data = artist->parent->parent->dragger.vlen;
-    Vector2 spline_buffer[visible_data]; // TODO: FIX THIS
-    for (size_t i = 0; i < visible_data; ++i) {
-      spline_buffer[i] = (Vector2){xdata[i], line_data.data[i]};
-    }
-    DrawSplineLinear(spline_buffer, artist->parent->parent->dragger.vlen,
-                     artist->thickness, *artist->color);
+static void artist_bar_reserve(Artist *artist, size_t slots) {
+  BarPixels *bars = (BarPixels *)artist->data;
+  if (slots <= bars->capacity)
     return;
+  Arena *arena = (Arena *)artist->parent->parent->arena;
+  size_t capacity = bars->capacity;
+  bars->top = arena_resize(arena, bars->top, sizeof(float) * capacity,
+                           sizeof(float) * slots);
+  bars->color_indexes =
+      arena_resize(arena, bars->color_indexes, capacity, slots);
+  bars->gather = arena_resize(arena, bars->gather, sizeof(double) * capacity,
+                              sizeof(double) * slots);
+  bars->capacity = slots;
+}
+
+static void artist_bar_gather_slot(Artist *artist, size_t slot) {
+  // a slot of several bars shows the one farthest from the baseline
+  Dragger *dragger = &artist->parent->parent->dragger;
+  BarPixels *bars = (BarPixels *)artist->data;
+  double minmax[2], baseline = bars->config.baseline;
+  size_t range[2];
+  dragger_slot_range(dragger, slot, range);
+  if (range[1] - range[0] == 1) {
+    bars->gather[slot] = gdata_get(&artist->gdata, 0, range[0]);
+    return;
+  }
+  range_index_query(artist->index, &artist->gdata, range[0], range[1], minmax);
+  bars->gather[slot] = fabs(minmax[1] - baseline) >= fabs(minmax[0] - baseline)
+                           ? minmax[1]
+                           : minmax[0];
+}
+
+static void artist_bar_map_slots(Artist *artist, size_t first, size_t len,
+                                 const double *in) {
+  BarPixels *bars = (BarPixels *)artist->data;
+  kernel_bar_pixels(in, bars->top + first, bars->color_indexes + first, len,
+                    bars->config.baseline, artist_y_pixel_map(artist));
+  Artist *color_by = bars->config.color_by;
+  if (color_by == NULL)
+    return;
+  Dragger *dragger = &artist->parent->parent->dragger;
+  size_t range[2];
+  for (size_t slot = first; slot < first + len; ++slot) {
+    // same rule as the candle: rising unless the open is above the close
+    dragger_slot_range(dragger, slot, range);
+    bars->color_indexes[slot] =
+        !(gdata_get(&color_by->gdata, 0, range[0]) >
+          gdata_get(&color_by->gdata, 3, range[1] - 1));
   }
+}
+
+static void artist_bar_update_data_buffer(Artist *artist, LimitChanged lim) {
+  Dragger *dragger = &artist->parent->parent->dragger;
+  BarPixels *bars = (BarPixels *)artist->data;
+  bars->width = // the width of a candle body
+      (artist->parent->width * dragger->slot_fill / dragger->slots) / 2.f;
+  if (lim != LIMIT_CHANGED_YLIM && lim != LIMIT_CHANGED_ALL_LIM)
+    return; // x pixels are read from the axes xdata_buffer when drawing
+  artist_bar_reserve(artist, dragger->slots);
+  bars->base = RC_DATA_Y_2_PIXEL(bars->config.baseline, artist->parent);
+  if (dragger->slots == dragger->vlen &&
+      gdata_is_native(&artist->gdata)) { // a bar per slot, map the column
+    artist_bar_map_slots(artist, 0, dragger->slots,
+                         artist->gdata.ydata + dragger->start);
+    return;
+  }
+  if (dragger->slots == dragger->vlen) {
+    gdata_read(&artist->gdata, 0, dragger->start, dragger->slots,
+               bars->gather);
+  } else {
+    for (size_t i = 0; i < dragger->slots; ++i)
+      artist_bar_gather_slot(artist, i);
+  }
+  artist_bar_map_slots(artist, 0, dragger->slots, bars->gather);
+}
+
+static void artist_line_plot(Artist *artist) {
+  LineData *line_data = (LineData *)artist->data;
+  GeomBatch *batch = (GeomBatch *)artist->parent->batch;
+  switch (line_data->line_type) {
+  case LINE_TYPE_S_LINE:
+    batch_polyline(batch, line_data->points, line_data->len, artist->thickness,
+                   *artist->color);
+    return;
   case LINE_TYPE_H_LINE:
-    if (isnan(line_data.data[1]))
+    if (isnan(line_data->pixel))
       goto label_non_segmented_line_having_nan;
-    DrawLineEx((Vector2){artist->parent->startX, line_data.data[1]},
+    batch_line(batch, (Vector2){artist->parent->startX, line_data->pixel},
                (Vector2){artist->parent->startX + artist->parent->width,
-                         line_data.data[1]},
+                         line_data->pixel},
                artist->thickness, *artist->color);
     return;
   case LINE_TYPE_V_LINE:
-    if (isnan(line_data.data[1]))
+    if (isnan(line_data->pixel))
       goto label_non_segmented_line_having_nan;
-    DrawLineEx((Vector2){line_data.data[1], artist->parent->startY},
-               (Vector2){line_data.data[1],
+    batch_line(batch, (Vector2){line_data->pixel, artist->parent->startY},
+               (Vector2){line_data->pixel,
                          artist->parent->startY + artist->parent->height},
                artist->thickness, *artist->color);
     return;
@@ -227,54 +473,123 @@ label_non_segmented_line_having_nan: {
   RC_ERROR("non-segmented line unreachable condition .plotting exactly 1 "
            "point %f "
            "on axes with limits (min=%f, max=%f)\n",
-           line_data.data[0], limit.limit_min, limit.limit_max);
+           line_data->position, limit.limit_min, limit.limit_max);
 }
 }
 
 static void artist_candle_plot(Artist *artist) {
   RC_ASSERT(artist->artist_type == ARTIST_TYPE_CANDLE);
   CandleData *candledata = (CandleData *)artist->data;
+  GeomBatch *batch = (GeomBatch *)artist->parent->batch;
+  double *x = artist->parent->xdata_buffer;
   int width = candledata->width;
-  for (size_t cindex = 0; cindex < artist->parent->parent->dragger.vlen;
+  double wick = candledata->width / 2.f;
+  for (size_t cindex = 0; cindex < artist->parent->parent->dragger.slots;
        ++cindex) {
     Color color = artist->color[candledata->color_indexes[cindex]];
-    DrawRectangleLinesEx(
-        (Rectangle){candledata->d0[cindex], candledata->p1[cindex], width,
-                    fmax(candledata->p2[cindex] - candledata->p1[cindex], 1.f)},
+    float top = candledata->top[cindex], bottom = candledata->bottom[cindex];
+    batch_rect_lines(
+        batch, (Rectangle){x[cindex], top, width, fmaxf(bottom - top, 1.f)},
         artist->thickness, color);
-    /* DrawRectangleV((Vector2){candledata->d0[cindex],candledata->p1[cindex]},(Vector2){width,RC_MAX(candledata->p2[cindex]-candledata->p1[cindex],1.f)},color);
-     */
-    DrawLineEx((Vector2){candledata->d1[cindex], candledata->p0[cindex]},
-               (Vector2){candledata->d1[cindex], candledata->p1[cindex]},
-               artist->thickness, color);
-    DrawLineEx((Vector2){candledata->d1[cindex], candledata->p2[cindex]},
-               (Vector2){candledata->d1[cindex], candledata->p3[cindex]},
+    batch_line(batch, (Vector2){x[cindex] + wick, candledata->high[cindex]},
+               (Vector2){x[cindex] + wick, top}, artist->thickness, color);
+    batch_line(batch, (Vector2){x[cindex] + wick, bottom},
+               (Vector2){x[cindex] + wick, candledata->low[cindex]},
                artist->thickness, color);
   }
 }
 
+static void artist_bar_plot(Artist *artist) {
+  BarPixels *bars = (BarPixels *)artist->data;
+  GeomBatch *batch = (GeomBatch *)artist->parent->batch;
+  double *x = artist->parent->xdata_buffer;
+  float width = fmaxf((int)bars->width, 1.f), base = bars->base;
+  for (size_t i = 0; i < artist->parent->parent->dragger.slots; ++i) {
+    float top = bars->top[i];
+    if (!isfinite(top))
+      continue; // a gap
+    batch_rect(batch,
+               (Rectangle){x[i], fminf(top, base), width,
+                           fmaxf(fabsf(base - top), 1.f)},
+               artist->color[bars->color_indexes[i]]);
+  }
+}
+
 static void artist_line_draw_icon(Artist *artist, Vector2 startPos) {
   startPos.y +=
       artist->parent->parent->font_size / 2.f; // draw a line middle as icon
-  DrawLineEx(startPos, (Vector2){startPos.x + RC_LEGEND_ICON_WIDTH, startPos.y},
-             1, *artist->color);
+  canvas_draw_line_ex(startPos,
+                      (Vector2){startPos.x + RC_LEGEND_ICON_WIDTH, startPos.y},
+                      1, *artist->color);
 }
 
 static void artist_candle_draw_icon(Artist *artist, Vector2 startPos) {
   int y = artist->parent->parent->font_size / 3; // draw a half rect as icon
-  DrawRectangleLines(startPos.x, startPos.y + y, RC_LEGEND_ICON_WIDTH,
-                     artist->parent->parent->font_size - y * 2,
-                     artist->color[0]);
+  canvas_draw_rect_lines((Rectangle){startPos.x, startPos.y + y,
+                                     RC_LEGEND_ICON_WIDTH,
+                                     artist->parent->parent->font_size - y * 2},
+                         1, artist->color[0]);
+}
+
+static void artist_bar_draw_icon(Artist *artist, Vector2 startPos) {
+  int y = artist->parent->parent->font_size / 3; // draw a half bar as icon
+  canvas_draw_rect((Rectangle){startPos.x + RC_LEGEND_ICON_WIDTH / 4.f,
+                               startPos.y + y, RC_LEGEND_ICON_WIDTH / 2.f,
+                               artist->parent->parent->font_size - y},
+                   artist->color[1]);
+}
+
+static void artist_heatmap_draw_icon(Artist *artist, Vector2 startPos) {
+  int y = artist->parent->parent->font_size / 3; // draw a shaded rect as icon
+  float width = RC_LEGEND_ICON_WIDTH / 2.f;
+  Rectangle rec = {startPos.x, startPos.y + y, width,
+                   artist->parent->parent->font_size - y * 2};
+  canvas_draw_rect(rec, artist->color[0]);
+  rec.x += width;
+  canvas_draw_rect(rec, artist->color[1]);
+}
+
+ArtistGroups *artist_groups_create(Arena *arena) {
+  ArtistGroups *groups = arena_alloc(arena, sizeof(ArtistGroups));
+  *groups = (ArtistGroups){.order = NULL, .capacity = 0};
+  return groups;
+}
+
+/**
+a slot for a new artist of `artist_type`, after the ones already in its group
+*/
+static Artist *artist_groups_push(Axes *axes, ArtistType artist_type) {
+  ArtistGroups *groups = (ArtistGroups *)axes->artists;
+  ArtistGroup *group = &groups->groups[artist_type];
+  Arena *arena = (Arena *)axes->parent->arena;
+  size_t k = 0, first = 0; // chunk of the new artist and its first index
+  while (k < group->chunks_len && first + ((size_t)RC_ARTIST_CHUNK << k) <= group->len)
+    first += (size_t)RC_ARTIST_CHUNK << k++;
+  if (k == group->chunks_len) {
+    RC_ASSERT(k < RC_ARTIST_CHUNKS);
+    group->chunks[k] =
+        arena_alloc(arena, sizeof(Artist) * ((size_t)RC_ARTIST_CHUNK << k));
+    group->chunks_len += 1;
+  }
+  Artist *artist = group->chunks[k] + (group->len - first);
+  group->len += 1;
+  if (axes->artist_len == groups->capacity) {
+    size_t capacity = maxl(groups->capacity * 2, RC_ARTIST_CHUNK);
+    groups->order =
+        arena_resize(arena, groups->order, sizeof(Artist *) * groups->capacity,
+                     sizeof(Artist *) * capacity);
+    groups->capacity = capacity;
+  }
+  groups->order[axes->artist_len] = artist;
+  axes->artist_len += 1;
+  return artist;
 }
 
 inline Artist *get_artist(Axes *axes, size_t index) {
-  if ((long int)index < 0 || index + 1 > axes->artist_len)
+  if (index >= axes->artist_len)
     RC_ERROR("requested artist index %zu but axes only has %zu items\n", index,
              axes->artist_len);
-  Artist *artist = axes->artist;
-  for (size_t i = 0; i < index; ++i)
-    artist = artist->next;
-  return artist;
+  return ((ArtistGroups *)axes->artists)->order[index];
 }
 
 void artist_update_data_buffer(Artist *artist, LimitChanged lim) {
@@ -285,20 +600,47 @@ void artist_update_data_buffer(Artist *artist, LimitChanged lim) {
   case ARTIST_TYPE_CANDLE:
     artist_candle_update_data_buffer(artist, lim);
     break;
+  case ARTIST_TYPE_BAR:
+    artist_bar_update_data_buffer(artist, lim);
+    break;
+  case ARTIST_TYPE_HEATMAP:
+    heatmap_update_data_buffer(artist, lim);
+    break;
   default:
     RC_ERROR("artist type %d has not been implemented on '%s'\n",
              artist->artist_type, __func__);
   }
 }
 
-void draw_artist(Artist *artist) {
-  switch (artist->artist_type) {
-  case ARTIST_TYPE_LINE:
-    return artist_line_plot(artist);
-  case ARTIST_TYPE_CANDLE:
-    return artist_candle_plot(artist);
-  default:
-    RC_ERROR("imlpement %d\n for draw_artist", artist->artist_type);
+void artists_update_data_buffers(Axes *axes, LimitChanged lim) {
+  ArtistGroup *groups = ((ArtistGroups *)axes->artists)->groups;
+  RC_ARTIST_GROUP_FOR_EACH(&groups[ARTIST_TYPE_HEATMAP], artist) {
+    heatmap_update_data_buffer(artist, lim);
+  }
+  RC_ARTIST_GROUP_FOR_EACH(&groups[ARTIST_TYPE_BAR], artist) {
+    artist_bar_update_data_buffer(artist, lim);
+  }
+  RC_ARTIST_GROUP_FOR_EACH(&groups[ARTIST_TYPE_CANDLE], artist) {
+    artist_candle_update_data_buffer(artist, lim);
+  }
+  RC_ARTIST_GROUP_FOR_EACH(&groups[ARTIST_TYPE_LINE], artist) {
+    artist_line_update_data_buffer(artist, lim);
+  }
+}
+
+void draw_artists(Axes *axes) {
+  ArtistGroup *groups = ((ArtistGroups *)axes->artists)->groups;
+  RC_ARTIST_GROUP_FOR_EACH(&groups[ARTIST_TYPE_HEATMAP], artist) {
+    heatmap_plot(artist); // drawn now, under what the batch holds
+  }
+  RC_ARTIST_GROUP_FOR_EACH(&groups[ARTIST_TYPE_BAR], artist) {
+    artist_bar_plot(artist);
+  }
+  RC_ARTIST_GROUP_FOR_EACH(&groups[ARTIST_TYPE_CANDLE], artist) {
+    artist_candle_plot(artist);
+  }
+  RC_ARTIST_GROUP_FOR_EACH(&groups[ARTIST_TYPE_LINE], artist) {
+    artist_line_plot(artist);
   }
 }
 
@@ -310,6 +652,12 @@ void artist_draw_icon(Artist *artist, Vector2 startPos) {
   case ARTIST_TYPE_LINE:
     artist_line_draw_icon(artist, startPos);
     break;
+  case ARTIST_TYPE_BAR:
+    artist_bar_draw_icon(artist, startPos);
+    break;
+  case ARTIST_TYPE_HEATMAP:
+    artist_heatmap_draw_icon(artist, startPos);
+    break;
   default:
     RC_ERROR("imlpement %d\n for draw_icon", artist->artist_type);
   }
@@ -318,47 +666,192 @@ void artist_draw_icon(Artist *artist, Vector2 startPos) {
 Artist *create_artist(Axes *axes, ArtistType artist_type, Gdata gdata,
                       double ydata_minmax[2], float thickness, Color *color,
                       void *config) {
-  Artist *CM_MALLOC(artist,sizeof(Artist));
+  RC_ASSERT((unsigned)artist_type < ARTIST_TYPE_LEN,
+            "artist type %d has not been implemented\n", artist_type);
+  Artist *artist = artist_groups_push(axes, artist_type);
   *artist = (Artist){
       .artist_type = artist_type,
       .gdata = gdata,
       .parent = axes,
       .thickness = thickness,
-      .next = NULL,
+      .index = NULL,
       .color = color,
       .ylim_consider = true,
+      .aggregation = artist_type == ARTIST_TYPE_CANDLE ? AGGREGATION_OHLC
+                                                       : AGGREGATION_LAST,
   };
   if (gdata.label != NULL) {
     RC_ASSERT(gdata.label[0] != '\0');
   }
-  if (axes->artist_len == 0) {
-    RC_ASSERT(axes->artist == NULL);
-    axes->artist = artist;
-  } else {
-    get_artist(axes, axes->artist_len - 1)->next = artist;
+  artist_init(artist, config);
+  double minmax[2] = {NAN, NAN};
+  if (artist->gdata.ydata != NULL) {
+    RC_ASSERT(axes->parent->has_dragger,
+              "'%s' needs to be called before creating artists with data\n",
+              RC_ECHO(set_dragger));
+    resampler_reset(axes->parent); // levels have no columns for it
+    if (artist->gdata.stride == 0)
+      artist->gdata.stride = axes->parent->dragger._len;
+    artist->index = bar_file_range_index((BarFile *)axes->parent->bar_file,
+                                         (Arena *)axes->parent->arena,
+                                         &artist->gdata,
+                                         axes->parent->dragger._len);
+    if (artist->index == NULL)
+      artist->index = range_index_create((Arena *)axes->parent->arena,
+                                         &artist->gdata,
+                                         axes->parent->dragger._len,
+                                         artist->gdata.stride);
+    if (axes->parent->dragger.capacity != 0) // the figure owns the data
+      artist_set_capacity(artist, axes->parent->dragger.capacity, false);
+    artist_ylim(artist, 0, axes->parent->dragger._len, minmax);
+  } else if (ydata_minmax == NULL) {
+    return artist; // nothing to consider for the ylims
   }
-  if (isnan(ydata_minmax[0]) || isnan(ydata_minmax[1])) {
+  if (ydata_minmax != NULL) {
+    minmax[0] = ydata_minmax[0];
+    minmax[1] = ydata_minmax[1];
+  }
+  if (isnan(minmax[0]) || isnan(minmax[1])) {
     RC_ERROR("create_artist failed to create Artist(name='%s'). Data limits "
              "cannot "
              "contain NaN\n",
              (artist->gdata.label == NULL ? "Nameless" : artist->gdata.label));
   }
   if (!axes->ylocator.limit.is_static) {
-    if (axes->artist_len == 0) {
-      axes->ylocator.limit = (Limit){.is_static = false,
-                                     .limit_min = ydata_minmax[0],
-                                     .limit_max = ydata_minmax[1],
-                                     .diff = ydata_minmax[1] - ydata_minmax[0]};
-    } else {
-      axes->ylocator.limit.limit_min =
-          fmin(axes->ylocator.limit.limit_min, ydata_minmax[0]);
-      axes->ylocator.limit.limit_max =
-          fmax(axes->ylocator.limit.limit_max, ydata_minmax[1]);
-      axes->ylocator.limit.diff =
-          axes->ylocator.limit.limit_max - axes->ylocator.limit.limit_min;
-    }
+    axes->ylocator.limit.limit_min =
+        fmin(axes->ylocator.limit.limit_min, minmax[0]);
+    axes->ylocator.limit.limit_max =
+        fmax(axes->ylocator.limit.limit_max, minmax[1]);
+    axes->ylocator.limit.diff =
+        axes->ylocator.limit.limit_max - axes->ylocator.limit.limit_min;
   }
-  axes->artist_len += 1;
-  artist_init(artist, config);
   return artist;
 }
+
+void artist_ylim(Artist *artist, size_t from, size_t to, double minmax[2]) {
+  if (artist->artist_type == ARTIST_TYPE_HEATMAP) { // not its intensities
+    heatmap_ylim(artist, minmax);
+    return;
+  }
+  range_index_query(artist->index, &artist->gdata, from, to, minmax);
+  if (artist->artist_type == ARTIST_TYPE_BAR) { // bars reach their baseline
+    double baseline = ((BarPixels *)artist->data)->config.baseline;
+    minmax[0] = fmin(minmax[0], baseline);
+    minmax[1] = fmax(minmax[1], baseline);
+  }
+}
+
+void artist_set_data(Artist *artist, double *ydata) {
+  artist_set_view(artist, (Gdata){.cols = artist->gdata.cols, .ydata = ydata});
+}
+
+void artist_set_view(Artist *artist, Gdata view) {
+  RC_ASSERT(view.ydata != NULL && artist->index != NULL,
+            "cannot set data for an artist created without data\n");
+  RC_ASSERT(view.cols == artist->gdata.cols,
+            "the data must have the %zu columns of the artist\n",
+            artist->gdata.cols);
+  if (publish_set_view(artist, view))
+    return;
+  Dragger *dragger = &artist->parent->parent->dragger;
+  resample_base_enter(artist->parent->parent);
+  if (view.stride == 0)
+    view.stride = dragger->_len;
+  if (dragger->capacity != 0) { // figure owns the data, copy it in
+    for (size_t c = 0; c < artist->gdata.cols; ++c)
+      gdata_read(&view, c, 0, dragger->_len,
+                 artist->gdata.ydata + c * artist->gdata.stride);
+  } else {
+    gdata_set_view(&artist->gdata, &view);
+  }
+  range_index_rebuild(artist->index, &artist->gdata, dragger->_len,
+                      artist->gdata.stride);
+  resample_base_leave(artist->parent->parent, true);
+  heatmap_data_replaced(artist);
+  indicators_source_replaced(artist);
+}
+
+void artist_set_capacity(Artist *artist, size_t capacity, bool owned) {
+  Dragger *dragger = &artist->parent->parent->dragger;
+  Gdata *gdata = &artist->gdata;
+  Arena *arena = (Arena *)artist->parent->parent->arena;
+  RC_ASSERT(capacity >= dragger->_len);
+  double *ydata = arena_alloc(arena, sizeof(double) * gdata->cols * capacity);
+  for (size_t c = 0; c < gdata->cols; ++c) // the copy is native
+    gdata_read(gdata, c, 0, dragger->_len, ydata + c * capacity);
+  if (owned)
+    arena_release(arena, gdata->ydata,
+                  sizeof(double) * gdata->cols * gdata->stride);
+  gdata_set_native(gdata, ydata, capacity);
+  range_index_rebuild(artist->index, gdata, dragger->_len, gdata->stride);
+}
+
+void artist_update_last(Artist *artist, double *values) {
+  if (publish_update_last(artist, values))
+    return;
+  RC_ASSERT(artist->index != NULL, "artist has no data to update\n");
+  figure_own_data(artist->parent->parent); // never write into the caller's data
+  if (!resample_update_last(artist, values)) {
+    size_t row = artist->parent->parent->dragger._len - 1;
+    for (size_t c = 0; c < artist->gdata.cols; ++c)
+      gdata_set(&artist->gdata, c, row, values[c]);
+    artist_last_changed(artist);
+  }
+  indicators_source_updated(artist);
+}
+
+void artist_last_changed(Artist *artist) {
+  Axes *axes = artist->parent;
+  Dragger *dragger = &axes->parent->dragger;
+  size_t row = dragger->_len - 1;
+  range_index_update(artist->index, &artist->gdata, row);
+  if (dragger->start + dragger->vlen != dragger->_len || axes->width == 0)
+    return; // last bar is not on screen (or nothing is laid out yet)
+  if (!axes->ylocator.limit.is_static && artist->ylim_consider) {
+    Limit limit = axes->ylocator.limit;
+    update_ylim_not_static(axes);
+    if (limit.limit_min != axes->ylocator.limit.limit_min ||
+        limit.limit_max != axes->ylocator.limit.limit_max) {
+      measure_ylabel(axes);
+      locator_update_data_buffers(axes, LIMIT_CHANGED_ALL_LIM);
+      return;
+    }
+  }
+  size_t slot = dragger->slots - 1;
+  switch (artist->artist_type) {
+  case ARTIST_TYPE_LINE: {
+    LineData *line_data = (LineData *)artist->data;
+    line_data->len = line_data->tail;
+    artist_line_push_slot(artist, slot);
+    artist_line_map_points(artist, line_data->tail);
+    break;
+  }
+  case ARTIST_TYPE_CANDLE: {
+    artist_candle_gather_slot(artist, slot);
+    const double *in[4];
+    artist_candle_gather_rows(artist, slot, in);
+    artist_candle_map_slots(artist, slot, 1, in);
+    break;
+  }
+  case ARTIST_TYPE_HEATMAP:
+    heatmap_last_changed(artist);
+    break;
+  case ARTIST_TYPE_BAR: {
+    artist_bar_gather_slot(artist, slot);
+    artist_bar_map_slots(artist, slot, 1,
+                         ((BarPixels *)artist->data)->gather + slot);
+    break;
+  }
+  default:
+    RC_ERROR("artist type %d has not been implemented on '%s'\n",
+             artist->artist_type, __func__);
+  }
+  layer_invalidate(&((AxesLayers *)axes->layers)->data); // ylabels are intact
+}
+
+void artists_unload(Axes *axes) {
+  ArtistGroup *groups = ((ArtistGroups *)axes->artists)->groups;
+  RC_ARTIST_GROUP_FOR_EACH(&groups[ARTIST_TYPE_HEATMAP], artist) {
+    heatmap_unload(artist);
+  }
+}
@@ -1,8 +1,104 @@
+#ifndef __RAYCANDLE_ARTIST__
+#define __RAYCANDLE_ARTIST__
+
+#include "arena.h"
 #include "locator.h"
 
-Artist *get_artist(Axes *axes, size_t index);
+#define RC_ARTIST_CHUNK 4   // artists in the first chunk of a group
+#define RC_ARTIST_CHUNKS 32 // chunk k holds RC_ARTIST_CHUNK << k artists
+
+/**
+the artists of one ArtistType in creation order, packed in chunks that never
+move so the Artist pointers returned by create_artist stay valid
+*/
+typedef struct {
+  Artist *chunks[RC_ARTIST_CHUNKS];
+  size_t len, chunks_len;
+} ArtistGroup;
+
+typedef struct {
+  ArtistGroup groups[ARTIST_TYPE_LEN];
+  Artist **order;  // every artist in creation order, for get_artist
+  size_t capacity; // of order
+} ArtistGroups;
+
+static inline size_t artist_chunk_len(const ArtistGroup *group, size_t k,
+                                      size_t done) {
+  size_t len = (size_t)RC_ARTIST_CHUNK << k;
+  return group->len - done < len ? group->len - done : len;
+}
+
+typedef struct {
+  Artist *end; // of the current chunk
+  size_t k, done;
+  bool once;
+} ArtistCursor;
+
+static inline Artist *artist_cursor_chunk(const ArtistGroup *group,
+                                          ArtistCursor *cursor) {
+  if (cursor->done >= group->len)
+    return NULL;
+  Artist *first = group->chunks[cursor->k];
+  cursor->end = first + artist_chunk_len(group, cursor->k, cursor->done);
+  return first;
+}
+
+static inline Artist *artist_cursor_next(const ArtistGroup *group,
+                                         ArtistCursor *cursor, Artist *artist) {
+  if (++artist < cursor->end)
+    return artist;
+  cursor->done += (size_t)RC_ARTIST_CHUNK << cursor->k++;
+  return artist_cursor_chunk(group, cursor);
+}
+
+/**
+loops `artist` over the artists of `group` in creation order. A single loop
+over the chunks: `break` and `continue` behave as in a plain `for` (the outer
+`for` only scopes the cursor and runs once)
+*/
+#define RC_ARTIST_GROUP_FOR_EACH(group, artist)                                \
+  for (ArtistCursor _cursor = {.once = true}; _cursor.once;                    \
+       _cursor.once = false)                                                   \
+    for (Artist *artist = artist_cursor_chunk((group), &_cursor);              \
+         artist != NULL; artist = artist_cursor_next((group), &_cursor, artist))
+
+ArtistGroups *artist_groups_create(Arena *arena);
+Artist *get_artist(Axes *axes, size_t index); // in creation order
 void artist_update_data_buffer(Artist *artist, LimitChanged lim);
-void draw_artist(Artist *artist);
+/**
+updates the data buffers of every artist of `axes`, type after type
+*/
+void artists_update_data_buffers(Axes *axes, LimitChanged lim);
+/**
+draws every artist of `axes`, type after type: heatmaps, bars, candles, then
+lines so what is overlaid stays visible. The order is fixed by type whatever
+the order the artists were created in (a line created before a candle is still
+drawn over it); creation order only orders artists of the same type. Heatmaps
+draw their texture, the rest goes to the axes GeomBatch, submitted in a single
+draw
+*/
+void draw_artists(Axes *axes);
+/**
+unloads the textures of the artists of `axes`, must be called before
+CloseWindow
+*/
+void artists_unload(Axes *axes);
+/**
+moves ydata into a buffer of `capacity` rows per column owned by the figure.
+`owned` tells whether the current ydata is already such a buffer
+*/
+void artist_set_capacity(Artist *artist, size_t capacity, bool owned);
+/**
+y limits of rows [from, to) of `artist` for autoscaling, NaN if none is
+finite. Bars include their baseline
+*/
+void artist_ylim(Artist *artist, size_t from, size_t to, double minmax[2]);
+/**
+redraws the last row after its ydata changed in place, like `artist_update_last`
+*/
+void artist_last_changed(Artist *artist);
 void artist_draw_icon(
     Artist *artist,
     Vector2 startPos); // draw a small shape of len  RC_LEGEND_ICON_WIDTH
+
+#endif //__RAYCANDLE_ARTIST__
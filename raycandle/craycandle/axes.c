@@ -1,15 +1,36 @@
 #include "axes.h"
 
+#include <string.h>
+
+#include "arena.h"
 #include "artist.h"
+#include "batch.h"
+#include "canvas.h"
+#include "layers.h"
+#include "profiler.h"
+#include "text.h"
 #include "utils.h"
 
+#define RC_YTICKS_MAX 128 // labels per axes, enough for a 4k high axes
+#define RC_YTICK_LEN 32
+
+typedef struct {
+  double limit_min, limit_max; // the labels were made for
+  float x, y, height;          // right edge, top and height of the plot
+  size_t len;
+  float rh[RC_YTICKS_MAX]; // from the top of the plot
+  char label[RC_YTICKS_MAX][RC_YTICK_LEN];
+} YTicks;
+
 static bool pre_border_draw_adjust_axes_dimensions(
     Axes *axes); // plots the axes frames and ajusts the axes dimensions
 static void axes_draw_legend(Axes *axes);
-static void axes_draw_title(Axes *axes);
+static void axes_draw_title(Axes *axes, Rectangle framed);
 static void axes_draw_labels(Axes *axes);
 static void axes_draw_xlabels(Axes *axes);
 static void axes_draw_ylabels(Axes *axes);
+static bool axes_has_data(Axes *axes); // artists with finite ylims
+static bool axes_update_yticks(Axes *axes); // true if the labels changed
 
 static bool pre_border_draw_adjust_axes_dimensions(Axes *axes) {
   // adjust for frame
@@ -72,10 +93,10 @@ static void axes_draw_legend(Axes *axes) {
     RC_ERROR("unreachable condition! %d %d %d\n", axes->legend.legend_position,
              startx, starty);
   }
-  DrawRectangleLinesEx((Rectangle){startx, starty,
-                                   axes->legend.width + RC_LEGEND_PADDING,
-                                   axes->legend.height},
-                       2, FadeToBlack(axes->facecolor, 0.2));
+  canvas_draw_rect_lines((Rectangle){startx, starty,
+                                     axes->legend.width + RC_LEGEND_PADDING,
+                                     axes->legend.height},
+                         2, FadeToBlack(axes->facecolor, 0.2));
   startx += paddingdiv;
   for (size_t i = 0; i < axes->artist_len; ++i) {
     Artist *artist = get_artist(axes, i);
@@ -84,27 +105,29 @@ static void axes_draw_legend(Axes *axes) {
       continue;
     }
     artist_draw_icon(artist, (Vector2){.x = startx, .y = starty});
-    DrawTextEx(FIGURE_FONT(axes->parent), label,
-               (Vector2){startx + RC_LEGEND_ICON_WIDTH + paddingdiv, starty},
-               axes->parent->font_size, axes->parent->font_spacing,
-               axes->parent->text_color);
+    text_draw(
+        (TextCache *)axes->parent->text_cache, FIGURE_FONT(axes->parent), label,
+        (Vector2){startx + RC_LEGEND_ICON_WIDTH + paddingdiv, starty},
+        axes->parent->font_size, axes->parent->font_spacing,
+        axes->parent->text_color);
     starty += axes->parent->font_size;
   }
 }
 
-static void axes_draw_title(Axes *axes) {
+static void axes_draw_title(Axes *axes, Rectangle framed) {
   if (axes->title != NULL) {
-    float x = align_text(FIGURE_FONT(axes->parent), axes->title, axes->width,
-                         axes->parent->font_size, axes->parent->font_spacing,
-                         RC_ALIGNMENT_CENTER);
-    DrawTextEx(
-        FIGURE_FONT(axes->parent), axes->title,
-        (Vector2){axes->startX + x, axes->startY - axes->parent->font_size},
+    TextCache *cache = (TextCache *)axes->parent->text_cache;
+    float x = text_align(cache, FIGURE_FONT(axes->parent), axes->title,
+                         framed.width, axes->parent->font_size,
+                         axes->parent->font_spacing, RC_ALIGNMENT_CENTER);
+    text_draw(
+        cache, FIGURE_FONT(axes->parent), axes->title,
+        (Vector2){framed.x + x, framed.y - axes->parent->font_size},
         axes->parent->font_size, axes->parent->font_spacing,
         axes->parent->text_color);
-    DrawLineEx((Vector2){axes->startX, axes->startY},
-               (Vector2){axes->startX + axes->width, axes->startY},
-               AXES_FRAME_THICK, axes->parent->axes_frame_color);
+    canvas_draw_line_ex((Vector2){framed.x, framed.y},
+                        (Vector2){framed.x + framed.width, framed.y},
+                        AXES_FRAME_THICK, axes->parent->axes_frame_color);
   }
 }
 
@@ -118,60 +141,106 @@ static void axes_draw_xlabels(Axes *axes) {
   // TODO
 }
 
-#define BUF_LEN 320
+static bool axes_update_yticks(Axes *axes) {
+  YTicks *yticks = (YTicks *)axes->yticks;
+  Limit limit = axes->ylocator.limit;
+  float x = axes->startX + axes->width;
+  if (!memcmp(&yticks->limit_min, &limit.limit_min, sizeof(double)) &&
+      !memcmp(&yticks->limit_max, &limit.limit_max, sizeof(double)) &&
+      yticks->x == x && yticks->y == axes->startY &&
+      yticks->height == axes->height)
+    return false; // memcmp so NaN limits compare equal
+  *yticks = (YTicks){.limit_min = limit.limit_min,
+                     .limit_max = limit.limit_max,
+                     .x = x,
+                     .y = axes->startY,
+                     .height = axes->height,
+                     .len = 0};
+  if (!axes_has_data(axes))
+    return true;
+  size_t ylabel_count = axes->height / (RC_LABEL_FONT_SIZE * 2);
+  for (size_t i = 1; i < ylabel_count + 1 && yticks->len < RC_YTICKS_MAX;
+       ++i) {
+    float rh = ((double)i) / (ylabel_count + 1) * axes->height;
+    yticks->rh[yticks->len] = rh;
+    snprintf(yticks->label[yticks->len++], RC_YTICK_LEN, "%.5f",
+             (1.f - ((double)rh / axes->height)) * limit.diff +
+                 limit.limit_min);
+  }
+  return true;
+}
+
 static void axes_draw_ylabels(Axes *axes) {
   if (!axes->parent->show_ylabels)
     return;
+  YTicks *yticks = (YTicks *)axes->yticks;
   int sx = axes->startX + axes->width;
-  float rh;
+  for (size_t i = 0; i < yticks->len; ++i) {
+    float rh = yticks->rh[i];
+    text_draw((TextCache *)axes->parent->text_cache, FIGURE_FONT(axes->parent),
+              yticks->label[i],
+              (Vector2){sx + axes->ylabel_padding,
+                        rh + axes->startY - (RC_LABEL_FONT_SIZE / 2.f)},
+              RC_LABEL_FONT_SIZE, axes->parent->font_spacing, BLACK);
+    canvas_draw_line(
+        (Vector2){sx, rh + axes->startY},
+        (Vector2){axes->width + (axes->startX + 0.25 * axes->ylabel_padding),
+                  rh + axes->startY},
+        BLUE);
+  }
+}
+
+#define BUF_LEN 320
+void axes_draw_overlay(Axes *axes) {
+  if (!axes->parent->show_ylabels || !axes_has_data(axes) ||
+      get_axes_under_mouse(axes->parent) != axes)
+    return;
   char _buffer[BUF_LEN] = {0};
   Str buffer = string_create(BUF_LEN, _buffer);
   int mousey = GetMouseY();
-  bool aium = get_axes_under_mouse(axes->parent) == axes;
-  size_t ylabel_count = axes->height / (RC_LABEL_FONT_SIZE * 2);
-
-  for (size_t i = 1; i < ylabel_count + 1; ++i) {
-    rh = ((double)i) / (ylabel_count + 1) * axes->height;
-    if (aium && (fabsf(rh + axes->startY - mousey) < RC_LABEL_FONT_SIZE))
-      continue;
-    string_clear(buffer);
-    string_append(buffer, "%.5f",
-                  (1.f - ((double)rh / axes->height)) *
-                          axes->ylocator.limit.diff +
-                      axes->ylocator.limit.limit_min);
-    DrawTextEx(FIGURE_FONT(axes->parent), buffer,
-               (Vector2){sx+axes->ylabel_padding,
-                         rh + axes->startY - (RC_LABEL_FONT_SIZE / 2.f)},
-               RC_LABEL_FONT_SIZE, axes->parent->font_spacing, BLACK);
-    DrawLine(sx, rh + axes->startY,
-             axes->width + (axes->startX + 0.25 * axes->ylabel_padding),
-             rh + axes->startY, BLUE);
-  }
-  if (aium) {
-    string_clear(buffer);
-    string_append(buffer, "%.5f", RC_PIXEL_Y_2_DATA(mousey, axes));
-    DrawTextEx(FIGURE_FONT(axes->parent), buffer,
-               (Vector2){axes->startX + axes->width + axes->ylabel_padding,
-                         mousey - (RC_LABEL_FONT_SIZE / 2.f)},
-               RC_LABEL_FONT_SIZE, axes->parent->font_spacing, RED);
-  }
+  float sx = axes->startX + axes->width;
+  // hide the cached labels under the mouse label
+  float top = fmaxf(mousey - RC_LABEL_FONT_SIZE, axes->startY);
+  float bottom =
+      fminf(mousey + RC_LABEL_FONT_SIZE, axes->startY + axes->height);
+  DrawRectangleRec((Rectangle){sx + 1, top, axes->ylabel_len - 1, bottom - top},
+                   axes->facecolor);
+  string_append(buffer, "%.5f", RC_PIXEL_Y_2_DATA(mousey, axes));
+  text_draw((TextCache *)axes->parent->text_cache, FIGURE_FONT(axes->parent),
+            buffer,
+            (Vector2){sx + axes->ylabel_padding,
+                      mousey - (RC_LABEL_FONT_SIZE / 2.f)},
+            RC_LABEL_FONT_SIZE, axes->parent->font_spacing, RED);
 }
 #undef BUF_LEN
 
+static bool axes_has_data(Axes *axes) {
+  return axes->parent->has_dragger && axes->artist_len > 0 &&
+         !isnan(axes->ylocator.limit.limit_min) &&
+         !isnan(axes->ylocator.limit.limit_max);
+}
+
 void create_axes(Figure *figure, char *labels) {
-  CM_MALLOC(figure->axes,sizeof(Axes) * figure->axes_len);
+  Arena *arena = (Arena *)figure->arena;
+  figure->axes = arena_alloc(arena, sizeof(Axes) * figure->axes_len);
   for (size_t i = 0; i < figure->axes_len; ++i) {
     figure->axes[i] = (Axes){
         .xdata_buffer = NULL,
         .ylabel_len = 0,
         .parent = figure,
         .title = NULL,
-        .artist = NULL,
+        .artists = artist_groups_create(arena),
         .artist_len = 0,
+        .batch = batch_create(arena),
+        .layers = layers_create(arena),
+        .yticks = arena_alloc(arena, sizeof(YTicks)),
         .padding = 0.f,
         .ylocator = (Locator){.format = "%.5f",
                               .flen = 11,
-                              .limit = (Limit){.is_static = false},
+                              .limit = (Limit){.limit_min = NAN,
+                                               .limit_max = NAN,
+                                               .diff = NAN,
+                                               .is_static = false},
                               .ftype = FORMATTER_LINEAR_FORMATTER},
         .legend = (Legend){.legend_position = LEGEND_POSITION_NO_LEGEND,
                            .height = 0,
@@ -180,43 +249,66 @@ void create_axes(Figure *figure, char *labels) {
         .label = labels[i],
         .tableau_t10_index = 0,
     };
+    *(YTicks *)figure->axes[i].yticks = (YTicks){.limit_min = NAN, .len = 0};
   }
 }
 
 bool draw_axes(Axes *axes) {
-  DrawRectangleLinesEx(
-      (Rectangle){axes->startX, axes->startY, axes->width, axes->height},
-      AXES_FRAME_THICK,
-      axes->parent->axes_frame_color); // draw frame first before ajusting
+  AxesLayers *layers = (AxesLayers *)axes->layers;
+  Rectangle outer = {axes->startX, axes->startY, axes->width, axes->height};
   if (!pre_border_draw_adjust_axes_dimensions(axes)) {
+    canvas_draw_rect_lines(outer, AXES_FRAME_THICK,
+                           axes->parent->axes_frame_color);
     return false;
   }
-  if (!RC_COLOR1_EQUALS_COLOR2(axes->facecolor,
-                               axes->parent->background_color)) {
-    DrawRectangle(axes->startX, axes->startY, axes->width, axes->height,
-                  axes->facecolor);
-  } // save some fps
-  if (axes->legend.legend_position != LEGEND_POSITION_NO_LEGEND) {
-    axes_draw_legend(axes);
-  }
-  axes_draw_title(axes);
+  Rectangle framed = {axes->startX, axes->startY, axes->width, axes->height};
   if (!post_border_draw_adjust_axes_dimensions(axes)) {
+    layer_invalidate(&layers->decorations);
+    canvas_draw_rect_lines(outer, AXES_FRAME_THICK,
+                           axes->parent->axes_frame_color);
     return false;
   }
-  if (axes->parent->has_dragger && axes->artist_len > 0) {
-    if (axes->parent->sds == SCREEN_DIMENSION_STATE_CHANGED) {
-      locator_update_data_buffers(axes, LIMIT_CHANGED_ALL_LIM);
+  Rectangle plot = {axes->startX, axes->startY, axes->width, axes->height};
+  if (axes->parent->has_dragger && axes->artist_len > 0 &&
+      axes->parent->sds == SCREEN_DIMENSION_STATE_CHANGED) {
+    locator_update_data_buffers(axes, LIMIT_CHANGED_ALL_LIM);
+  }
+  bool has_data = axes_has_data(axes);
+  if (axes_update_yticks(axes)) // limits, size or position changed
+    layer_invalidate(&layers->decorations);
+  if (layer_begin(&layers->decorations, outer,
+                  axes->parent->background_color)) {
+    canvas_draw_rect_lines(outer, AXES_FRAME_THICK,
+                           axes->parent->axes_frame_color);
+    if (!RC_COLOR1_EQUALS_COLOR2(axes->facecolor,
+                                 axes->parent->background_color)) {
+      canvas_draw_rect(framed, axes->facecolor);
+    } // save some fps
+    RC_PROFILE_BEGIN(PROFILE_PHASE_TEXT);
+    axes_draw_title(axes, framed);
+    if (has_data)
+      axes_draw_labels(axes);
+    RC_PROFILE_END(PROFILE_PHASE_TEXT);
+    layer_end(&layers->decorations);
+  }
+  layer_draw(&layers->decorations);
+  if (!has_data && axes->legend.legend_position == LEGEND_POSITION_NO_LEGEND)
+    return true;
+  if (layer_begin(&layers->data, plot, axes->facecolor)) {
+    if (has_data) {
+      RC_PROFILE_BEGIN(PROFILE_PHASE_DRAW_ARTIST);
+      draw_artists(axes);
+      RC_PROFILE_END(PROFILE_PHASE_DRAW_ARTIST);
+      batch_draw((GeomBatch *)axes->batch, layer_clip(&layers->data, plot));
     }
-    if (isnan(axes->ylocator.limit.limit_min) ||
-        isnan(axes->ylocator.limit.limit_min))
-      return true;
-    axes_draw_labels(axes);
-    for (size_t i = 0; i < axes->artist_len; ++i) {
-      BeginScissorMode(axes->startX, axes->startY, axes->width, axes->height);
-      draw_artist(get_artist(axes, i));
-      EndScissorMode();
-    };
+    if (axes->legend.legend_position != LEGEND_POSITION_NO_LEGEND) {
+      RC_PROFILE_BEGIN(PROFILE_PHASE_TEXT);
+      axes_draw_legend(axes); // on top of the artists
+      RC_PROFILE_END(PROFILE_PHASE_TEXT);
+    }
+    layer_end(&layers->data);
   }
+  layer_draw(&layers->data);
   return true;
 }
 
@@ -250,11 +342,12 @@ void axes_set_legend(Figure *figure) {
         ;
       }
       axes->legend.height += figure->font_size;
-      axes->legend.width = maxl(
-          axes->legend.width, (int)MeasureTextEx(FIGURE_FONT(axes->parent),
-                                                 label, axes->parent->font_size,
-                                                 axes->parent->font_spacing)
-                                  .x);
+      axes->legend.width =
+          maxl(axes->legend.width,
+               (int)canvas_measure_text(FIGURE_FONT(axes->parent), label,
+                                        axes->parent->font_size,
+                                        axes->parent->font_spacing)
+                   .x);
     }
     axes->legend.width += RC_LEGEND_ICON_WIDTH;
   }
@@ -274,6 +367,7 @@ void axes_set_title(Axes *axes, char *title) {
   else
     string_destroy(axes->title);
   axes->title = string_create_from_format(0, NULL, "%s", title);
+  layers_invalidate((AxesLayers *)axes->layers);
 }
 
 void axes_show_legend(Axes *axes, LegendPosition legend_position) {
@@ -283,6 +377,7 @@ void axes_show_legend(Axes *axes, LegendPosition legend_position) {
   case LEGEND_POSITION_TOP_RIGHT:
   case LEGEND_POSITION_TOP_LEFT:
     axes->legend.legend_position = legend_position;
+    layers_invalidate((AxesLayers *)axes->layers);
     break;
   case LEGEND_POSITION_NO_LEGEND:
   default:
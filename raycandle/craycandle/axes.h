@@ -3,6 +3,7 @@
 void create_axes(Figure *figure,
                  char *labels); // allocate memory and create axes structs in it
 bool draw_axes(Axes *axes);     // plot the axes and all artists for the axes
+void axes_draw_overlay(Axes *axes); // per frame mouse y label over the layers
 /*
 return index of axes under mouse. if none return `figure->axes_len`
 */
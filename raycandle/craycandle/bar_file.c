@@ -0,0 +1,237 @@
+#define _POSIX_C_SOURCE 200112L // fstat, mmap
+#include "bar_file.h"
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "gdata.h"
+#include "utils.h"
+
+#define RC_BAR_FILE_CHUNK 1024 // summaries (or column rows) written at once
+
+static size_t bar_file_blocks(size_t rows, size_t block);
+static bool bar_file_header_valid(const BarFileHeader *header, size_t bytes);
+static bool bar_file_pad(FILE *file, size_t bytes);
+static bool bar_file_write_summaries(FILE *file, size_t rows, Gdata gdata,
+                                     bool max);
+
+static size_t bar_file_blocks(size_t rows, size_t block) {
+  return rows / block + (rows % block != 0); // rows + block - 1 may wrap
+}
+
+// the header describes a file of `bytes`: products of its fields are checked
+// for overflow before they are compared, a crafted header cannot wrap them
+static bool bar_file_header_valid(const BarFileHeader *header, size_t bytes) {
+  if (header->magic != RC_BAR_FILE_MAGIC ||
+      header->version != RC_BAR_FILE_VERSION || header->rows == 0 ||
+      header->cols == 0 || header->timeframe == 0 || header->block == 0 ||
+      header->stride < header->rows ||
+      header->data_offset % RC_BAR_FILE_PAGE != 0)
+    return false;
+  size_t blocks = bar_file_blocks(header->rows, header->block);
+  size_t names, columns, summaries, end;
+  if (__builtin_mul_overflow(header->cols, RC_BAR_FILE_NAME_LEN, &names) ||
+      __builtin_add_overflow(names, sizeof(BarFileHeader), &names) ||
+      header->data_offset < names)
+    return false;
+  if (__builtin_add_overflow(header->cols, 1, &columns) ||
+      __builtin_mul_overflow(columns, header->stride, &columns) ||
+      __builtin_mul_overflow(header->cols, blocks, &summaries) ||
+      __builtin_mul_overflow(summaries, 2, &summaries) ||
+      __builtin_add_overflow(columns, summaries, &end) ||
+      __builtin_mul_overflow(end, sizeof(double), &end) ||
+      __builtin_add_overflow(end, header->data_offset, &end))
+    return false;
+  return bytes >= end;
+}
+
+static bool bar_file_pad(FILE *file, size_t bytes) {
+  static const char zeros[RC_BAR_FILE_PAGE];
+  for (size_t n; bytes > 0; bytes -= n) {
+    n = minl(bytes, sizeof(zeros));
+    if (fwrite(zeros, 1, n, file) != n)
+      return false;
+  }
+  return true;
+}
+
+/**
+writes the min (or max) of the finite values of every RC_RANGE_INDEX_BLOCK rows
+of each column, NaN for blocks without any
+*/
+static bool bar_file_write_summaries(FILE *file, size_t rows, Gdata gdata,
+                                     bool max) {
+  double chunk[RC_BAR_FILE_CHUNK];
+  size_t blocks = bar_file_blocks(rows, RC_RANGE_INDEX_BLOCK), len = 0;
+  for (size_t c = 0; c < gdata.cols; ++c) {
+    for (size_t b = 0; b < blocks; ++b) {
+      double value = NAN;
+      size_t end = minl((b + 1) * RC_RANGE_INDEX_BLOCK, rows);
+      for (size_t row = b * RC_RANGE_INDEX_BLOCK; row < end; ++row) {
+        double y = gdata_get(&gdata, c, row);
+        if (isfinite(y))
+          value = max ? fmax(value, y) : fmin(value, y);
+      }
+      chunk[len++] = value;
+      if (len == RC_BAR_FILE_CHUNK || (c == gdata.cols - 1 && b == blocks - 1)) {
+        if (fwrite(chunk, sizeof(double), len, file) != len)
+          return false;
+        len = 0;
+      }
+    }
+  }
+  return true;
+}
+
+bool bar_file_write(char *path, size_t rows, size_t timeframe, double *xdata,
+                    Gdata gdata, char **names) {
+  RC_ASSERT(rows > 0 && timeframe > 0 && gdata.cols > 0 && xdata != NULL &&
+            gdata.ydata != NULL);
+  for (size_t row = 1; row < rows; ++row)
+    RC_ASSERT(xdata[row] > xdata[row - 1], "xdata must be increasing\n");
+  if (gdata.stride == 0)
+    gdata.stride = rows;
+  size_t cols = gdata.cols;
+  size_t stride = (rows + 7) & ~(size_t)7; // 64 bytes
+  size_t names_end = sizeof(BarFileHeader) + cols * RC_BAR_FILE_NAME_LEN;
+  BarFileHeader header = {
+      .magic = RC_BAR_FILE_MAGIC,
+      .version = RC_BAR_FILE_VERSION,
+      .rows = rows,
+      .cols = cols,
+      .timeframe = timeframe,
+      .block = RC_RANGE_INDEX_BLOCK,
+      .stride = stride,
+      .data_offset = (names_end + RC_BAR_FILE_PAGE - 1) / RC_BAR_FILE_PAGE *
+                     RC_BAR_FILE_PAGE,
+  };
+  char tmp[strlen(path) + sizeof(".tmp")];
+  snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+  FILE *file = fopen(tmp, "wb");
+  if (file == NULL)
+    return false;
+  bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+  for (size_t c = 0; ok && c < cols; ++c) {
+    char name[RC_BAR_FILE_NAME_LEN] = {0};
+    if (names != NULL && names[c] != NULL)
+      strncpy(name, names[c], RC_BAR_FILE_NAME_LEN - 1);
+    ok = fwrite(name, 1, RC_BAR_FILE_NAME_LEN, file) == RC_BAR_FILE_NAME_LEN;
+  }
+  ok = ok && bar_file_pad(file, header.data_offset - names_end);
+  ok = ok && fwrite(xdata, sizeof(double), rows, file) == rows &&
+       bar_file_pad(file, sizeof(double) * (stride - rows));
+  for (size_t c = 0; ok && c < cols; ++c) { // views are written as float64
+    double chunk[RC_BAR_FILE_CHUNK];
+    for (size_t row = 0; ok && row < rows; row += RC_BAR_FILE_CHUNK) {
+      size_t len = minl(RC_BAR_FILE_CHUNK, rows - row);
+      gdata_read(&gdata, c, row, len, chunk);
+      ok = fwrite(chunk, sizeof(double), len, file) == len;
+    }
+    ok = ok && bar_file_pad(file, sizeof(double) * (stride - rows));
+  }
+  ok = ok && bar_file_write_summaries(file, rows, gdata, false) &&
+       bar_file_write_summaries(file, rows, gdata, true);
+  ok = fclose(file) == 0 && ok;
+  if (!ok || rename(tmp, path) != 0) { // mappings of `path` stay intact
+    remove(tmp);
+    return false;
+  }
+  return true;
+}
+
+BarFile *bar_file_open(char *path) {
+  struct stat st;
+  int fd = open(path, O_RDONLY);
+  if (fd == -1 || fstat(fd, &st) == -1 ||
+      (size_t)st.st_size < sizeof(BarFileHeader)) {
+    RC_WARN("cannot open bar file '%s'\n", path);
+    if (fd != -1)
+      close(fd);
+    return NULL;
+  }
+  // private: rows written by artist updates are copied, never written back
+  void *map = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    RC_WARN("cannot map bar file '%s'\n", path);
+    return NULL;
+  }
+  BarFileHeader *header = map;
+  if (!bar_file_header_valid(header, st.st_size)) {
+    RC_WARN("'%s' is not a bar file of version %d\n", path, RC_BAR_FILE_VERSION);
+    munmap(map, st.st_size);
+    return NULL;
+  }
+  CM_MALLOC(BarFile * file, sizeof(BarFile));
+  size_t blocks = bar_file_blocks(header->rows, header->block);
+  double *columns = (double *)((char *)map + header->data_offset);
+  const double *summaries = columns + (header->cols + 1) * header->stride;
+  *file = (BarFile){
+      .header = header,
+      .names = (const char *)(header + 1),
+      .columns = columns,
+      .block_min = summaries,
+      .block_max = summaries + header->cols * blocks,
+      .blocks = blocks,
+      .bytes = st.st_size,
+  };
+  return file;
+}
+
+void bar_file_close(BarFile *file) {
+  munmap(file->header, file->bytes);
+  CM_FREE(file);
+}
+
+size_t bar_file_rows(BarFile *file) { return file->header->rows; }
+
+size_t bar_file_cols(BarFile *file) { return file->header->cols; }
+
+long bar_file_find(BarFile *file, char *name) {
+  for (size_t c = 0; c < file->header->cols; ++c) {
+    if (strncmp(file->names + c * RC_BAR_FILE_NAME_LEN, name,
+                RC_BAR_FILE_NAME_LEN) == 0)
+      return c;
+  }
+  return -1;
+}
+
+Gdata bar_file_gdata(BarFile *file, size_t col, size_t cols, char *label) {
+  RC_ASSERT(cols > 0 && col + cols <= file->header->cols);
+  return (Gdata){.cols = cols,
+                 .ydata = file->columns + (col + 1) * file->header->stride,
+                 .label = label,
+                 .stride = file->header->stride};
+}
+
+void figure_attach_bar_file(Figure *figure, BarFile *file, FormatterType ftype,
+                            char *format) {
+  set_dragger(figure, file->header->rows, file->header->timeframe,
+              file->columns, ftype, format);
+  figure->bar_file = file;
+}
+
+RangeIndex *bar_file_range_index(const BarFile *file, Arena *arena,
+                                 const Gdata *gdata, size_t len) {
+  if (file == NULL || !gdata_is_native(gdata) ||
+      file->header->block != RC_RANGE_INDEX_BLOCK ||
+      len != file->header->rows || gdata->stride != file->header->stride)
+    return NULL;
+  size_t stride = file->header->stride, cols = file->header->cols;
+  const double *first = file->columns + stride,
+               *end = file->columns + (cols + 1) * stride;
+  if (gdata->ydata < first || gdata->ydata >= end ||
+      (gdata->ydata - file->columns) % stride != 0)
+    return NULL;
+  size_t col = (gdata->ydata - file->columns) / stride - 1;
+  if (col + gdata->cols > cols)
+    return NULL;
+  return range_index_create_from_blocks(
+      arena, gdata, len, stride, file->block_min + col * file->blocks,
+      file->block_max + col * file->blocks, file->blocks);
+}
@@ -0,0 +1,55 @@
+/*
+ * BarFile
+ * -------
+ * columnar file of bars that figures map instead of loading. Layout:
+ *   BarFileHeader
+ *   cols names of RC_BAR_FILE_NAME_LEN bytes, NUL terminated
+ *   at `data_offset` (page aligned): cols+1 columns of `stride` doubles, the
+ *     epochs first. `stride` keeps every column 64 byte aligned
+ *   then the min of every RC_RANGE_INDEX_BLOCK rows of each value column,
+ *     then their max, `blocks` per column
+ * The block summaries let a RangeIndex be built without reading the rows, so
+ * opening a file costs the same whatever its length. Files are mapped
+ * privately: the rows stay shared with the page cache of every process that
+ * maps the file until one of them writes to them.
+ */
+#ifndef __RAYCANDLE_BAR_FILE__
+#define __RAYCANDLE_BAR_FILE__
+
+#include <stdint.h>
+
+#include "arena.h"
+#include "range_index.h"
+#include "raycandle.h"
+
+#define RC_BAR_FILE_MAGIC 0x3153524142435252u // "RRCBARS1" little endian
+#define RC_BAR_FILE_VERSION 1
+#define RC_BAR_FILE_NAME_LEN 32
+#define RC_BAR_FILE_PAGE 4096
+
+typedef struct {
+  uint64_t magic, version;
+  uint64_t rows, cols;   // cols: value columns, the epochs are not counted
+  uint64_t timeframe;    // seconds between bars
+  uint64_t block;        // rows per summary, RC_RANGE_INDEX_BLOCK of the writer
+  uint64_t stride;       // doubles between 2 columns
+  uint64_t data_offset;  // bytes from the start of the file to the epochs
+} BarFileHeader;
+
+struct BarFile {
+  BarFileHeader *header;
+  const char *names;
+  double *columns;          // epochs at 0, value column c at (c+1)*stride
+  const double *block_min;  // value column c at c*blocks
+  const double *block_max;
+  size_t blocks, bytes;
+};
+
+/**
+a RangeIndex over `gdata` built from the block summaries of `file`, or NULL if
+`gdata` are not len rows of its value columns (file may be NULL)
+*/
+RangeIndex *bar_file_range_index(const BarFile *file, Arena *arena,
+                                 const Gdata *gdata, size_t len);
+
+#endif //__RAYCANDLE_BAR_FILE__
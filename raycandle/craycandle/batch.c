@@ -0,0 +1,131 @@
+#include "batch.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "canvas.h"
+#include "profiler.h"
+#include "rlgl.h"
+#include "utils.h"
+
+static BatchVertex *batch_reserve(GeomBatch *batch, size_t len);
+static void batch_quad(GeomBatch *batch, Vector2 a, Vector2 b, Vector2 c,
+                       Vector2 d, Color color);
+
+static BatchVertex *batch_reserve(GeomBatch *batch, size_t len) {
+  if (batch->len + len > batch->capacity) {
+    size_t capacity = batch->capacity * 2;
+    while (capacity < batch->len + len)
+      capacity *= 2;
+    batch->vertices = arena_resize(batch->arena, batch->vertices,
+                                   sizeof(BatchVertex) * batch->capacity,
+                                   sizeof(BatchVertex) * capacity);
+    batch->capacity = capacity;
+  }
+  BatchVertex *v = batch->vertices + batch->len;
+  batch->len += len;
+  return v;
+}
+
+static void batch_quad(GeomBatch *batch, Vector2 a, Vector2 b, Vector2 c,
+                       Vector2 d, Color color) {
+  // counter clockwise a,b,c,d as 2 triangles
+  BatchVertex *v = batch_reserve(batch, 6);
+  v[0] = (BatchVertex){a.x, a.y, color};
+  v[1] = (BatchVertex){b.x, b.y, color};
+  v[2] = (BatchVertex){c.x, c.y, color};
+  v[3] = (BatchVertex){a.x, a.y, color};
+  v[4] = (BatchVertex){c.x, c.y, color};
+  v[5] = (BatchVertex){d.x, d.y, color};
+}
+
+GeomBatch *batch_create(Arena *arena) {
+  GeomBatch *batch = arena_alloc(arena, sizeof(GeomBatch));
+  *batch = (GeomBatch){
+      .len = 0, .capacity = RC_BATCH_INITIAL_CAPACITY, .arena = arena};
+  batch->vertices = arena_alloc(arena, sizeof(BatchVertex) * batch->capacity);
+  return batch;
+}
+
+void batch_clear(GeomBatch *batch) { batch->len = 0; }
+
+void batch_rect(GeomBatch *batch, Rectangle rec, Color color) {
+  batch_quad(batch, (Vector2){rec.x, rec.y},
+             (Vector2){rec.x, rec.y + rec.height},
+             (Vector2){rec.x + rec.width, rec.y + rec.height},
+             (Vector2){rec.x + rec.width, rec.y}, color);
+}
+
+void batch_rect_lines(GeomBatch *batch, Rectangle rec, float thick,
+                      Color color) {
+  if (thick * 2 >= rec.width || thick * 2 >= rec.height) {
+    batch_rect(batch, rec, color);
+    return;
+  }
+  batch_rect(batch, (Rectangle){rec.x, rec.y, rec.width, thick}, color);
+  batch_rect(batch,
+             (Rectangle){rec.x, rec.y + rec.height - thick, rec.width, thick},
+             color);
+  batch_rect(batch,
+             (Rectangle){rec.x, rec.y + thick, thick, rec.height - thick * 2},
+             color);
+  batch_rect(batch,
+             (Rectangle){rec.x + rec.width - thick, rec.y + thick, thick,
+                         rec.height - thick * 2},
+             color);
+}
+
+void batch_line(GeomBatch *batch, Vector2 start, Vector2 end, float thick,
+                Color color) {
+  float dx = end.x - start.x, dy = end.y - start.y;
+  float len = sqrtf(dx * dx + dy * dy);
+  if (len == 0.f || !isfinite(len))
+    return;
+  float nx = -dy / len * thick / 2.f, ny = dx / len * thick / 2.f;
+  batch_quad(batch, (Vector2){start.x - nx, start.y - ny},
+             (Vector2){start.x + nx, start.y + ny},
+             (Vector2){end.x + nx, end.y + ny},
+             (Vector2){end.x - nx, end.y - ny}, color);
+}
+
+void batch_polyline(GeomBatch *batch, const Vector2 *points, size_t len,
+                    float thick, Color color) {
+  for (size_t i = 1; i < len; ++i) {
+    if (!isfinite(points[i - 1].y) || !isfinite(points[i].y))
+      continue;
+    batch_line(batch, points[i - 1], points[i], thick, color);
+  }
+}
+
+void batch_draw(GeomBatch *batch, Rectangle clip) {
+  if (batch->len == 0)
+    return;
+  RC_PROFILE_BEGIN(PROFILE_PHASE_BATCH_DRAW);
+  if (canvas_active() != NULL) {
+    canvas_begin_clip(clip);
+    for (size_t i = 0; i < batch->len; i += 3) {
+      BatchVertex *v = batch->vertices + i;
+      canvas_fill_triangle((Vector2){v[0].x, v[0].y}, (Vector2){v[1].x, v[1].y},
+                           (Vector2){v[2].x, v[2].y}, v[0].color);
+    }
+    canvas_end_clip();
+    batch_clear(batch);
+    RC_PROFILE_END(PROFILE_PHASE_BATCH_DRAW);
+    return;
+  }
+  BeginScissorMode(clip.x, clip.y, clip.width, clip.height);
+  rlBegin(RL_TRIANGLES);
+  for (size_t i = 0; i < batch->len; i += 3) {
+    rlCheckRenderBatchLimit(3); // flushes only when rlgl's buffer is full
+    for (size_t v = i; v < i + 3; ++v) {
+      BatchVertex *vertex = batch->vertices + v;
+      rlColor4ub(vertex->color.r, vertex->color.g, vertex->color.b,
+                 vertex->color.a);
+      rlVertex2f(vertex->x, vertex->y);
+    }
+  }
+  rlEnd();
+  EndScissorMode();
+  batch_clear(batch);
+  RC_PROFILE_END(PROFILE_PHASE_BATCH_DRAW);
+}
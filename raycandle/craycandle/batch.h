@@ -0,0 +1,48 @@
+/*
+ * GeomBatch
+ * ---------
+ * a per axes vertex buffer. artists append their candle bodies, wicks and
+ * polylines as coloured triangles and the whole buffer is submitted once, in
+ * a single scissor region, when the axes is drawn.
+ */
+#ifndef __RAYCANDLE_BATCH__
+#define __RAYCANDLE_BATCH__
+
+#include <stddef.h>
+
+#include "arena.h"
+#include "raylib.h"
+
+#define RC_BATCH_INITIAL_CAPACITY 4096 // vertices
+
+typedef struct {
+  float x, y;
+  Color color;
+} BatchVertex;
+
+typedef struct {
+  BatchVertex *vertices; // 3 per triangle
+  size_t len, capacity;
+  Arena *arena; // owns the batch and its vertices
+} GeomBatch;
+
+GeomBatch *batch_create(Arena *arena);
+void batch_clear(GeomBatch *batch);
+void batch_rect(GeomBatch *batch, Rectangle rec, Color color);
+void batch_rect_lines(GeomBatch *batch, Rectangle rec, float thick,
+                      Color color); // same outline as DrawRectangleLinesEx
+void batch_line(GeomBatch *batch, Vector2 start, Vector2 end, float thick,
+                Color color); // same as DrawLineEx
+/**
+appends a polyline through `len` points. segments touching a non finite
+point are skipped so NaNs leave gaps
+*/
+void batch_polyline(GeomBatch *batch, const Vector2 *points, size_t len,
+                    float thick, Color color);
+/**
+submits every vertex clipped to `clip` (or rasterizes it into the active
+canvas) and clears the batch
+*/
+void batch_draw(GeomBatch *batch, Rectangle clip);
+
+#endif //__RAYCANDLE_BATCH__
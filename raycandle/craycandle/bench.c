@@ -0,0 +1,262 @@
+/*
+ * bench
+ * -----
+ * headless microbenchmarks of the compute hot paths on synthetic OHLC of 1e3
+ * up to `max_bars` (argv[1], default 1e8) bars. Prints one JSON object per
+ * line: {"bench","isa","bars","vlen","iterations","ns_per_op","ns_per_op_min"}
+ * where ns_per_op is the median of RC_BENCH_BATCHES timed batches.
+ * build and run with `make bench [BENCH_MAX_BARS=...]`; RAYCANDLE_SIMD=scalar
+ * times the scalar pixel kernels
+ */
+#define _POSIX_C_SOURCE 199309L // clock_gettime
+#include <locale.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "artist.h"
+#include "fas.h"
+#include "kernels.h"
+#include "locator.h"
+#include "mouse_updater.h"
+#include "raycandle.h"
+#include "utils.h"
+
+#define RC_BENCH_BATCHES 7
+#define RC_BENCH_BATCH_SECONDS 0.02 // minimum time of one batch
+#define RC_BENCH_TIMEFRAME 600      // seconds between bars
+#define RC_BENCH_BUF_LEN 128
+#define RC_BENCH_TAU 6.283185307179586
+
+typedef void (*BenchFn)(void *ctx, size_t iteration);
+
+typedef struct {
+  Figure *figure;
+  Artist *candle, *line;
+  size_t bars;
+} BenchFigure;
+
+typedef struct {
+  char *buffer;
+  double value;
+} BenchString;
+
+static uint64_t rng_state = 0x9e3779b97f4a7c15u;
+
+static uint64_t bench_now(void);
+static double bench_uniform(void);
+static double bench_normal(double mean, double scale);
+static long bench_randint(long low, long high);
+static void fake_stock_data(size_t len, double *xdata, double *ohlc);
+static int bench_compare(const void *a, const void *b);
+static void bench_run(const char *name, size_t bars, size_t vlen, BenchFn fn,
+                      void *ctx);
+
+static void bench_update_from_position(void *ctx, size_t iteration);
+static void bench_update_ylim(void *ctx, size_t iteration);
+static void bench_locator(void *ctx, size_t iteration);
+static void bench_line_buffer(void *ctx, size_t iteration);
+static void bench_candle_buffer(void *ctx, size_t iteration);
+static void bench_fas_parse(void *ctx, size_t iteration);
+static void bench_string_append(void *ctx, size_t iteration);
+static void bench_string_create_from_format(void *ctx, size_t iteration);
+static void bench_time_formatter(void *ctx, size_t iteration);
+
+static uint64_t bench_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static double bench_uniform(void) { // xorshift64*, fixed seed for repeatable data
+  rng_state ^= rng_state >> 12;
+  rng_state ^= rng_state << 25;
+  rng_state ^= rng_state >> 27;
+  return ((rng_state * 0x2545f4914f6cdd1du) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static double bench_normal(double mean, double scale) { // Box-Muller
+  double u = 1.0 - bench_uniform(), v = bench_uniform();
+  return mean + scale * sqrt(-2.0 * log(u)) * cos(RC_BENCH_TAU * v);
+}
+
+static long bench_randint(long low, long high) {
+  return low + (long)(bench_uniform() * (high - low));
+}
+
+/**
+port of cmnfunc.fake_stock_data: trending random walk segments of 20..50 bars.
+`ohlc` is column major, 4 columns of `len`
+*/
+static void fake_stock_data(size_t len, double *xdata, double *ohlc) {
+  double *o = ohlc, *h = ohlc + len, *l = ohlc + len * 2, *c = ohlc + len * 3;
+  double price = 1000, step = 0.2, volatility = 0.5;
+  long trend = 1, segment_length = bench_randint(20, 50), counter = 0;
+  for (size_t i = 0; i < len; ++i) {
+    if (i > 0) {
+      if (counter >= segment_length) {
+        trend = bench_randint(-1, 2);
+        segment_length = bench_randint(20, 50);
+        counter = 0;
+      }
+      double decay = 1 - ((double)counter / segment_length);
+      price += trend * step * decay + bench_normal(0, volatility * decay);
+      counter++;
+    }
+    xdata[i] = (double)i * RC_BENCH_TIMEFRAME;
+    o[i] = price;
+    h[i] = price + fabs(bench_normal(0.4, 0.15));
+    l[i] = price - fabs(bench_normal(0.4, 0.15));
+    c[i] = l[i] + (h[i] - l[i]) * bench_uniform();
+  }
+}
+
+static int bench_compare(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+static void bench_run(const char *name, size_t bars, size_t vlen, BenchFn fn,
+                      void *ctx) {
+  size_t iterations = 1, done = 0;
+  for (;;) { // calibrate so one batch lasts RC_BENCH_BATCH_SECONDS
+    uint64_t start = bench_now();
+    for (size_t i = 0; i < iterations; ++i)
+      fn(ctx, done++);
+    if ((bench_now() - start) / 1e9 >= RC_BENCH_BATCH_SECONDS)
+      break;
+    iterations *= 2;
+  }
+  double ns[RC_BENCH_BATCHES];
+  for (size_t b = 0; b < RC_BENCH_BATCHES; ++b) {
+    uint64_t start = bench_now();
+    for (size_t i = 0; i < iterations; ++i)
+      fn(ctx, done++);
+    ns[b] = (double)(bench_now() - start) / iterations;
+  }
+  qsort(ns, RC_BENCH_BATCHES, sizeof(double), bench_compare);
+  printf("{\"bench\":\"%s\",\"isa\":\"%s\",\"bars\":%zu,\"vlen\":%zu,"
+         "\"iterations\":%zu,\"ns_per_op\":%.1f,\"ns_per_op_min\":%.1f}\n",
+         name, kernels_isa_name(kernels_isa()), bars, vlen,
+         iterations * RC_BENCH_BATCHES,
+         ns[RC_BENCH_BATCHES / 2], ns[0]);
+  fflush(stdout);
+}
+
+static void bench_update_from_position(void *ctx, size_t iteration) {
+  BenchFigure *bf = ctx;
+  Dragger *dragger = &bf->figure->dragger;
+  size_t positions = dragger->_len - dragger->vlen + 1;
+  update_from_position((iteration * 7919) % positions, bf->figure); // pan
+}
+
+static void bench_update_ylim(void *ctx, size_t iteration) {
+  (void)iteration;
+  update_ylim_not_static(((BenchFigure *)ctx)->figure->axes);
+}
+
+static void bench_locator(void *ctx, size_t iteration) {
+  (void)iteration;
+  locator_update_data_buffers(((BenchFigure *)ctx)->figure->axes,
+                              LIMIT_CHANGED_ALL_LIM);
+}
+
+static void bench_line_buffer(void *ctx, size_t iteration) {
+  (void)iteration;
+  artist_update_data_buffer(((BenchFigure *)ctx)->line, LIMIT_CHANGED_ALL_LIM);
+}
+
+static void bench_candle_buffer(void *ctx, size_t iteration) {
+  (void)iteration;
+  artist_update_data_buffer(((BenchFigure *)ctx)->candle,
+                            LIMIT_CHANGED_ALL_LIM);
+}
+
+static void bench_fas_parse(void *ctx, size_t iteration) {
+  (void)iteration;
+  char skel[RC_BENCH_BUF_LEN];
+  strcpy(skel, (const char *)ctx); // fas_parse takes a mutable string
+  fas_destroy(fas_parse(skel));
+}
+
+static void bench_string_append(void *ctx, size_t iteration) {
+  BenchString *bs = ctx;
+  Str buffer = string_create(RC_BENCH_BUF_LEN, bs->buffer);
+  string_append(buffer, "%.5f", bs->value + iteration); // a y label
+}
+
+static void bench_string_create_from_format(void *ctx, size_t iteration) {
+  BenchString *bs = ctx;
+  string_destroy(string_create_from_format(0, NULL, "    %.5f ",
+                                           bs->value + iteration));
+}
+
+static void bench_time_formatter(void *ctx, size_t iteration) {
+  BenchString *bs = ctx;
+  Str buffer = string_create(RC_BENCH_BUF_LEN, bs->buffer);
+  double epoch = bs->value + iteration * RC_BENCH_TIMEFRAME;
+  formatter_to_str(FORMATTER_TIME_FORMATTER, "[%Y-%m-%d %H:%M:%S]", buffer,
+                   &epoch);
+}
+
+int main(int argc, char **argv) {
+  size_t max_bars = argc > 1 ? strtoull(argv[1], NULL, 10) : 100000000;
+  int fig_size[] = {1280, 720};
+  for (size_t bars = 1000; bars <= max_bars; bars *= 10) {
+    double *xdata = malloc(sizeof(double) * bars);
+    double *ohlc = malloc(sizeof(double) * bars * 4);
+    if (xdata == NULL || ohlc == NULL) {
+      fprintf(stderr, "bench: cannot allocate %zu bars\n", bars);
+      free(xdata);
+      free(ohlc);
+      break;
+    }
+    fake_stock_data(bars, xdata, ohlc);
+    BenchFigure bf = {.bars = bars};
+    bf.figure = create_figure("a b", fig_size, NULL, WHITE, 0.01f, 0, 20, 2,
+                              "");
+    set_dragger(bf.figure, bars, RC_BENCH_TIMEFRAME, xdata,
+                FORMATTER_TIME_FORMATTER, "[%Y-%m-%d %H:%M:%S]");
+    bf.candle = create_artist(bf.figure->axes, ARTIST_TYPE_CANDLE,
+                              (Gdata){.cols = 4, .ydata = ohlc}, NULL, 1,
+                              NULL, NULL);
+    LineData line = {.line_type = LINE_TYPE_S_LINE};
+    bf.line = create_artist(bf.figure->axes, ARTIST_TYPE_LINE,
+                            (Gdata){.cols = 1, .ydata = ohlc + bars * 3},
+                            NULL, 1, NULL, &line);
+    figure_render(bf.figure, NULL); // lays the axes out without a window
+    setlocale(LC_NUMERIC, "C");     // create_figure picks the user's locale
+    size_t vlens[] = {RC_INITIAL_VISIBLE_DATA, bars};
+    for (size_t v = 0; v < sizeof(vlens) / sizeof(vlens[0]); ++v) {
+      bf.figure->dragger.vlen = minl(vlens[v], bars);
+      update_from_position(0, bf.figure);
+      size_t vlen = bf.figure->dragger.vlen;
+      bench_run("update_from_position", bars, vlen, bench_update_from_position,
+                &bf);
+      bench_run("update_ylim_not_static", bars, vlen, bench_update_ylim, &bf);
+      bench_run("locator_update_data_buffers", bars, vlen, bench_locator, &bf);
+      bench_run("artist_line_update_data_buffer", bars, vlen,
+                bench_line_buffer, &bf);
+      bench_run("artist_candle_update_data_buffer", bars, vlen,
+                bench_candle_buffer, &bf);
+    }
+    destroy_figure(bf.figure);
+    free(xdata);
+    free(ohlc);
+  }
+  // independent of the data size
+  bench_run("fas_parse", 0, 0, bench_fas_parse, "ab ab cd");
+  bench_run("fas_parse_large", 0, 0, bench_fas_parse,
+            "aabbccdd aabbccdd eeffgghh eeffgghh iijjkkll mmnnoopp");
+  char buffer[RC_BENCH_BUF_LEN];
+  BenchString bs = {.buffer = buffer, .value = 1234.56789};
+  bench_run("string_append", 0, 0, bench_string_append, &bs);
+  bench_run("string_create_from_format", 0, 0,
+            bench_string_create_from_format, &bs);
+  bs.value = 1700000000;
+  bench_run("formatter_to_str_time", 0, 0, bench_time_formatter, &bs);
+  return 0;
+}
@@ -0,0 +1,372 @@
+#include "canvas.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "utils.h"
+
+#define RC_CANVAS_ATLAS_PADDING 2 // transparent pixels between atlas glyphs
+
+static Canvas *active = NULL;
+
+static void canvas_unload_font(Canvas *canvas);
+static void canvas_blend(Canvas *canvas, int x, int y, Color color,
+                         float coverage);
+static void canvas_rect(Canvas *canvas, Rectangle rec, Rectangle clip,
+                        Color color);
+static bool canvas_edge_inclusive(Vector2 u, Vector2 v);
+static float canvas_atlas_sample(const Canvas *canvas, Rectangle src, float u,
+                                 float v);
+static void canvas_draw_glyph(Canvas *canvas, int index, Vector2 position,
+                              float scale, Color tint);
+
+static void canvas_unload_font(Canvas *canvas) {
+  if (canvas->font.glyphs == NULL)
+    return;
+  UnloadFontData(canvas->font.glyphs, canvas->font.glyphCount);
+  MemFree(canvas->font.recs);
+  UnloadImage(canvas->atlas);
+  canvas->font = (Font){0};
+  canvas->atlas = (Image){0};
+}
+
+static void canvas_blend(Canvas *canvas, int x, int y, Color color,
+                         float coverage) {
+  float a = color.a / 255.f * coverage;
+  if (a <= 0.f)
+    return;
+  Color *p = canvas->pixels + (size_t)y * canvas->width + x;
+  p->r = color.r * a + p->r * (1.f - a) + 0.5f;
+  p->g = color.g * a + p->g * (1.f - a) + 0.5f;
+  p->b = color.b * a + p->b * (1.f - a) + 0.5f;
+  p->a = 255.f * a + p->a * (1.f - a) + 0.5f;
+}
+
+static void canvas_rect(Canvas *canvas, Rectangle rec, Rectangle clip,
+                        Color color) {
+  // pixels whose centers fall inside rec
+  int x0 = maxl(ceilf(rec.x - 0.5f), clip.x);
+  int y0 = maxl(ceilf(rec.y - 0.5f), clip.y);
+  int x1 = minl(ceilf(rec.x + rec.width - 0.5f), clip.x + clip.width);
+  int y1 = minl(ceilf(rec.y + rec.height - 0.5f), clip.y + clip.height);
+  for (int y = y0; y < y1; ++y) {
+    if (color.a == 255) {
+      Color *row = canvas->pixels + (size_t)y * canvas->width;
+      for (int x = x0; x < x1; ++x)
+        row[x] = color;
+      continue;
+    }
+    for (int x = x0; x < x1; ++x)
+      canvas_blend(canvas, x, y, color, 1.f);
+  }
+}
+
+// top-left fill rule so triangles sharing an edge never blend a pixel twice
+static bool canvas_edge_inclusive(Vector2 u, Vector2 v) {
+  float dx = v.x - u.x, dy = v.y - u.y;
+  return dy < 0.f || (dy == 0.f && dx > 0.f);
+}
+
+static float canvas_atlas_sample(const Canvas *canvas, Rectangle src, float u,
+                                 float v) {
+  // bilinear, texels outside the glyph (padding) are transparent
+  int x0 = floorf(u), y0 = floorf(v);
+  float fx = u - x0, fy = v - y0, coverage = 0.f;
+  const Color *texels = (const Color *)canvas->atlas.data;
+  for (int j = 0; j < 2; ++j) {
+    for (int i = 0; i < 2; ++i) {
+      int x = x0 + i, y = y0 + j;
+      if (x < src.x || y < src.y || x >= src.x + src.width ||
+          y >= src.y + src.height)
+        continue;
+      float w = (i ? fx : 1.f - fx) * (j ? fy : 1.f - fy);
+      coverage += w * texels[(size_t)y * canvas->atlas.width + x].a;
+    }
+  }
+  return coverage / 255.f;
+}
+
+static void canvas_draw_glyph(Canvas *canvas, int index, Vector2 position,
+                              float scale, Color tint) {
+  Rectangle src = canvas->font.recs[index];
+  GlyphInfo *glyph = canvas->font.glyphs + index;
+  Rectangle dst = {position.x + glyph->offsetX * scale,
+                   position.y + glyph->offsetY * scale, src.width * scale,
+                   src.height * scale};
+  int x0 = maxl(floorf(dst.x), canvas->clip.x);
+  int y0 = maxl(floorf(dst.y), canvas->clip.y);
+  int x1 = minl(ceilf(dst.x + dst.width), canvas->clip.x + canvas->clip.width);
+  int y1 =
+      minl(ceilf(dst.y + dst.height), canvas->clip.y + canvas->clip.height);
+  for (int y = y0; y < y1; ++y) {
+    float v = src.y + (y + 0.5f - dst.y) / scale - 0.5f;
+    for (int x = x0; x < x1; ++x) {
+      float u = src.x + (x + 0.5f - dst.x) / scale - 0.5f;
+      canvas_blend(canvas, x, y, tint, canvas_atlas_sample(canvas, src, u, v));
+    }
+  }
+}
+
+Canvas *canvas_create(int width, int height) {
+  RC_ASSERT(width > 0 && height > 0);
+  Canvas *CM_MALLOC(canvas, sizeof(Canvas));
+  *canvas = (Canvas){.width = width,
+                     .height = height,
+                     .clip = (Rectangle){0, 0, width, height}};
+  CM_MALLOC(canvas->pixels, sizeof(Color) * width * height);
+  memset(canvas->pixels, 0, sizeof(Color) * width * height);
+  return canvas;
+}
+
+void canvas_destroy(Canvas *canvas) {
+  if (active == canvas)
+    canvas_end();
+  canvas_unload_font(canvas);
+  CM_FREE(canvas->pixels);
+  CM_FREE(canvas);
+}
+
+bool canvas_load_font(Canvas *canvas, const char *font_path, int font_size) {
+  canvas_unload_font(canvas);
+  int len = 0;
+  unsigned char *data = (font_path != NULL && font_path[0] != '\0')
+                            ? LoadFileData(font_path, &len)
+                            : NULL;
+  if (data == NULL)
+    return false;
+  Font font = {.baseSize = font_size, .glyphCount = RC_CANVAS_GLYPHS};
+  font.glyphs = LoadFontData(data, len, font_size, NULL, RC_CANVAS_GLYPHS,
+                             FONT_DEFAULT);
+  UnloadFileData(data);
+  if (font.glyphs == NULL)
+    return false;
+  canvas->atlas = GenImageFontAtlas(font.glyphs, &font.recs, RC_CANVAS_GLYPHS,
+                                    font_size, RC_CANVAS_ATLAS_PADDING, 0);
+  ImageFormat(&canvas->atlas, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+  canvas->font = font;
+  return true;
+}
+
+void canvas_begin(Canvas *canvas) {
+  RC_ASSERT(active == NULL, "canvases cannot be nested\n");
+  active = canvas;
+  canvas->clip = (Rectangle){0, 0, canvas->width, canvas->height};
+}
+
+void canvas_end(void) { active = NULL; }
+
+Canvas *canvas_active(void) { return active; }
+
+bool canvas_export(const Canvas *canvas, const char *path) {
+  size_t len = strlen(path);
+  if (len > 4 && strcmp(path + len - 4, ".png") == 0) {
+    return ExportImage((Image){.data = canvas->pixels,
+                               .width = canvas->width,
+                               .height = canvas->height,
+                               .mipmaps = 1,
+                               .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8},
+                       path);
+  }
+  FILE *file = fopen(path, "wb");
+  if (file == NULL)
+    return false;
+  size_t pixels = (size_t)canvas->width * canvas->height;
+  bool written = fwrite(canvas->pixels, sizeof(Color), pixels, file) == pixels;
+  return (fclose(file) == 0) && written;
+}
+
+void canvas_begin_clip(Rectangle clip) {
+  if (active == NULL) {
+    BeginScissorMode(clip.x, clip.y, clip.width, clip.height);
+    return;
+  }
+  float x0 = fmaxf(clip.x, 0), y0 = fmaxf(clip.y, 0);
+  float x1 = fminf(clip.x + clip.width, active->width);
+  float y1 = fminf(clip.y + clip.height, active->height);
+  active->clip = (Rectangle){(int)x0, (int)y0, fmaxf((int)x1 - (int)x0, 0),
+                             fmaxf((int)y1 - (int)y0, 0)};
+}
+
+void canvas_end_clip(void) {
+  if (active == NULL) {
+    EndScissorMode();
+    return;
+  }
+  active->clip = (Rectangle){0, 0, active->width, active->height};
+}
+
+void canvas_clear(Color color) {
+  if (active == NULL) {
+    ClearBackground(color);
+    return;
+  }
+  for (size_t i = 0; i < (size_t)active->width * active->height; ++i)
+    active->pixels[i] = color;
+}
+
+void canvas_fill_rect(Rectangle rec, Color color) {
+  RC_ASSERT(active != NULL);
+  canvas_rect(active, rec, (Rectangle){0, 0, active->width, active->height},
+              color);
+}
+
+void canvas_fill_triangle(Vector2 a, Vector2 b, Vector2 c, Color color) {
+  RC_ASSERT(active != NULL);
+  float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+  if (area == 0.f || !isfinite(area))
+    return;
+  if (area < 0.f) { // same orientation for both windings
+    Vector2 t = b;
+    b = c;
+    c = t;
+  }
+  Vector2 edges[3][2] = {{b, c}, {c, a}, {a, b}};
+  bool inclusive[3];
+  for (int e = 0; e < 3; ++e)
+    inclusive[e] = canvas_edge_inclusive(edges[e][0], edges[e][1]);
+  Rectangle clip = active->clip;
+  int x0 = maxl(floorf(fminf(a.x, fminf(b.x, c.x))), clip.x);
+  int y0 = maxl(floorf(fminf(a.y, fminf(b.y, c.y))), clip.y);
+  int x1 = minl(ceilf(fmaxf(a.x, fmaxf(b.x, c.x))), clip.x + clip.width);
+  int y1 = minl(ceilf(fmaxf(a.y, fmaxf(b.y, c.y))), clip.y + clip.height);
+  for (int y = y0; y < y1; ++y) {
+    for (int x = x0; x < x1; ++x) {
+      Vector2 p = {x + 0.5f, y + 0.5f};
+      bool inside = true;
+      for (int e = 0; e < 3 && inside; ++e) {
+        Vector2 u = edges[e][0], v = edges[e][1];
+        float w = (v.x - u.x) * (p.y - u.y) - (v.y - u.y) * (p.x - u.x);
+        inside = w > 0.f || (w == 0.f && inclusive[e]);
+      }
+      if (inside)
+        canvas_blend(active, x, y, color, 1.f);
+    }
+  }
+}
+
+void canvas_draw_rect(Rectangle rec, Color color) {
+  if (active == NULL) {
+    DrawRectangleRec(rec, color);
+    return;
+  }
+  canvas_rect(active, rec, active->clip, color);
+}
+
+void canvas_draw_rect_lines(Rectangle rec, float thick, Color color) {
+  if (active == NULL) {
+    DrawRectangleLinesEx(rec, thick, color);
+    return;
+  }
+  if (thick * 2 >= rec.width || thick * 2 >= rec.height) {
+    canvas_draw_rect(rec, color);
+    return;
+  }
+  canvas_draw_rect((Rectangle){rec.x, rec.y, rec.width, thick}, color);
+  canvas_draw_rect(
+      (Rectangle){rec.x, rec.y + rec.height - thick, rec.width, thick}, color);
+  canvas_draw_rect(
+      (Rectangle){rec.x, rec.y + thick, thick, rec.height - thick * 2}, color);
+  canvas_draw_rect((Rectangle){rec.x + rec.width - thick, rec.y + thick, thick,
+                               rec.height - thick * 2},
+                   color);
+}
+
+void canvas_draw_line(Vector2 start, Vector2 end, Color color) {
+  if (active == NULL) {
+    DrawLineV(start, end, color);
+    return;
+  }
+  canvas_draw_line_ex(start, end, 1.f, color);
+}
+
+void canvas_draw_line_ex(Vector2 start, Vector2 end, float thick,
+                         Color color) {
+  if (active == NULL) {
+    DrawLineEx(start, end, thick, color);
+    return;
+  }
+  float dx = end.x - start.x, dy = end.y - start.y;
+  float len = sqrtf(dx * dx + dy * dy);
+  if (len == 0.f || !isfinite(len))
+    return;
+  float nx = -dy / len * thick / 2.f, ny = dx / len * thick / 2.f;
+  Vector2 a = {start.x - nx, start.y - ny}, b = {start.x + nx, start.y + ny};
+  Vector2 c = {end.x + nx, end.y + ny}, d = {end.x - nx, end.y - ny};
+  canvas_fill_triangle(a, b, c, color);
+  canvas_fill_triangle(a, c, d, color);
+}
+
+void canvas_draw_texture_pro(Texture2D texture, const Color *texels,
+                             Rectangle source, Rectangle dest, Color tint) {
+  if (active == NULL) {
+    DrawTexturePro(texture, source, dest, (Vector2){0, 0}, 0.f, tint);
+    return;
+  }
+  if (dest.width <= 0.f || dest.height <= 0.f)
+    return;
+  Rectangle clip = active->clip;
+  // pixels whose centers fall inside dest, like canvas_rect
+  int x0 = maxl(ceilf(dest.x - 0.5f), clip.x);
+  int y0 = maxl(ceilf(dest.y - 0.5f), clip.y);
+  int x1 = minl(ceilf(dest.x + dest.width - 0.5f), clip.x + clip.width);
+  int y1 = minl(ceilf(dest.y + dest.height - 0.5f), clip.y + clip.height);
+  float sx = source.width / dest.width, sy = source.height / dest.height;
+  for (int y = y0; y < y1; ++y) {
+    int v = minl(source.y + (y + 0.5f - dest.y) * sy,
+                 source.y + source.height - 1);
+    const Color *row = texels + (size_t)v * texture.width;
+    for (int x = x0; x < x1; ++x) {
+      int u = minl(source.x + (x + 0.5f - dest.x) * sx,
+                   source.x + source.width - 1);
+      Color texel = row[u];
+      texel.r = texel.r * tint.r / 255;
+      texel.g = texel.g * tint.g / 255;
+      texel.b = texel.b * tint.b / 255;
+      texel.a = texel.a * tint.a / 255;
+      canvas_blend(active, x, y, texel, 1.f);
+    }
+  }
+}
+
+void canvas_draw_text(Font font, const char *text, Vector2 position,
+                      float font_size, float spacing, Color tint) {
+  if (active == NULL) {
+    DrawTextEx(font, text, position, font_size, spacing, tint);
+    return;
+  }
+  font = active->font; // a canvas only has glyphs for its own font
+  if (font.glyphs == NULL)
+    return;
+  float scale = font_size / font.baseSize, offset = 0.f;
+  for (int size = 0; *text != '\0'; text += size) {
+    int codepoint = GetCodepointNext(text, &size);
+    int index = GetGlyphIndex(font, codepoint);
+    if (codepoint != ' ' && codepoint != '\t')
+      canvas_draw_glyph(active, index,
+                        (Vector2){position.x + offset, position.y}, scale,
+                        tint);
+    offset += (font.glyphs[index].advanceX == 0 ? font.recs[index].width
+                                                : font.glyphs[index].advanceX) *
+                  scale +
+              spacing;
+  }
+}
+
+Vector2 canvas_measure_text(Font font, const char *text, float font_size,
+                            float spacing) {
+  if (active == NULL)
+    return MeasureTextEx(font, text, font_size, spacing);
+  font = active->font;
+  if (font.glyphs == NULL || *text == '\0')
+    return (Vector2){0, font_size};
+  float width = 0.f;
+  size_t count = 0;
+  for (int size = 0; *text != '\0'; text += size, ++count) {
+    int index = GetGlyphIndex(font, GetCodepointNext(text, &size));
+    width += font.glyphs[index].advanceX == 0 ? font.recs[index].width
+                                              : font.glyphs[index].advanceX;
+  }
+  return (Vector2){width * font_size / font.baseSize + (count - 1) * spacing,
+                   font_size};
+}
@@ -0,0 +1,65 @@
+/*
+ * Canvas
+ * ------
+ * a CPU framebuffer used to render figures without a window or GL context.
+ * While a canvas is active (canvas_begin..canvas_end) the canvas_draw_*
+ * functions rasterize into it; otherwise they forward to the raylib function
+ * they are named after, so the drawing code is shared by both targets.
+ */
+#ifndef __RAYCANDLE_CANVAS__
+#define __RAYCANDLE_CANVAS__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "raylib.h"
+
+#define RC_CANVAS_GLYPHS 95 // printable ascii, same set raylib loads by default
+
+typedef struct {
+  int width, height;
+  Color *pixels;  // width*height, row major from the top left
+  Rectangle clip; // pixels outside are never written
+  Font font;      // glyph metrics only, texture is never loaded
+  Image atlas;    // R8G8B8A8 glyph coverage in the alpha channel
+} Canvas;
+
+Canvas *canvas_create(int width, int height);
+void canvas_destroy(Canvas *canvas);
+/**
+loads `font_path` at `font_size` into the canvas. returns false, leaving the
+canvas without text, if the font cannot be read
+*/
+bool canvas_load_font(Canvas *canvas, const char *font_path, int font_size);
+void canvas_begin(Canvas *canvas); // route canvas_draw_* to `canvas`
+void canvas_end(void);             // route canvas_draw_* to the window
+Canvas *canvas_active(void);       // NULL when drawing to the window
+/**
+writes the pixels as PNG if `path` ends with ".png", else as raw RGBA
+*/
+bool canvas_export(const Canvas *canvas, const char *path);
+
+void canvas_begin_clip(Rectangle clip); // BeginScissorMode
+void canvas_end_clip(void);             // EndScissorMode
+void canvas_clear(Color color);         // ClearBackground
+void canvas_fill_rect(Rectangle rec, Color color); // ignores the clip
+void canvas_fill_triangle(Vector2 a, Vector2 b, Vector2 c, Color color);
+void canvas_draw_rect(Rectangle rec, Color color); // DrawRectangleRec
+void canvas_draw_rect_lines(Rectangle rec, float thick,
+                            Color color); // DrawRectangleLinesEx
+void canvas_draw_line(Vector2 start, Vector2 end, Color color); // DrawLineV
+void canvas_draw_line_ex(Vector2 start, Vector2 end, float thick,
+                         Color color); // DrawLineEx
+/**
+DrawTexturePro without origin and rotation. A canvas has no textures: it
+samples `texels`, the CPU copy of `texture` (texture.width wide), nearest
+*/
+void canvas_draw_texture_pro(Texture2D texture, const Color *texels,
+                             Rectangle source, Rectangle dest, Color tint);
+void canvas_draw_text(Font font, const char *text, Vector2 position,
+                      float font_size, float spacing,
+                      Color tint); // DrawTextEx
+Vector2 canvas_measure_text(Font font, const char *text, float font_size,
+                            float spacing); // MeasureTextEx
+
+#endif //__RAYCANDLE_CANVAS__
@@ -3,6 +3,10 @@
  * =================
  * A tiny malloc/free tracker for catching segfaults, double frees,
  * freeing pointers not allocated by CM, and for logging memory activity.
+ * CM_MALLOC and CM_FREE are O(1); cm_free_all and cm_pointer_chain_print
+ * walk the chain once. Double frees are caught for the last CM_QUARANTINE
+ * frees, whose blocks are held back from free until they leave the quarantine;
+ * freeing a pointer freed before that is undefined, as with free.
  *
  * HOW TO USE
  * ----------
@@ -35,6 +39,9 @@
  * 2. CM_SILENT
  *      If nonzero, suppress all INFO logging (errors still print).
  *
+ * 3. CM_QUARANTINE
+ *      Number of freed blocks held back to catch double frees (default 64).
+ *
  *
  *When satisfied, default to malloc and free with #define CM_OFF
  *
@@ -49,6 +56,10 @@
 #define CM_SILENT 0
 #endif // CM_SILENT
 
+#ifndef CM_QUARANTINE
+#define CM_QUARANTINE 64
+#endif // CM_QUARANTINE
+
 #ifdef CM_OFF
 #include <string.h>
 #define CM_MALLOC(target,bytes) target=malloc(bytes)
@@ -90,19 +101,37 @@ void cm_pointer_chain_print();          // print the chain
 #include <string.h>
 
 #ifndef CM_OFF
+/*
+ * every block is prefixed by a PointerChain node; the nodes form a circular
+ * doubly linked list around PointerChain_v in allocation order so malloc and
+ * free are O(1). `magic` is last so it sits right before the user memory,
+ * where an overrun of the previous block shows as an unlocatable pointer.
+ */
 typedef struct PointerChain PointerChain;
 struct PointerChain {
-  size_t size;
-  struct PointerChain *next;
+  struct PointerChain *prev, *next;
+  size_t size, magic;
 };
 
 typedef struct {
   size_t allocated, chain_length;
 } PointerChainInfo_t;
 
-static PointerChain PointerChain_v = {.size = 0, .next = NULL};
+#define CM_MAGIC_LIVE ((size_t)0x434d4c495645u)  // "CMLIVE"
+#define CM_MAGIC_FREED ((size_t)0x434d46524545u) // "CMFREE"
+
+static PointerChain PointerChain_v = {.prev = &PointerChain_v,
+                                      .next = &PointerChain_v,
+                                      .size = 0,
+                                      .magic = 0};
 static PointerChainInfo_t PointerChainInfo = {.allocated = 0,
                                               .chain_length = 0};
+/*
+ * the last CM_QUARANTINE freed blocks, not yet given back to free: a pointer
+ * is found here without reading its header, which free may have reused
+ */
+static PointerChain *CM_Quarantine[CM_QUARANTINE];
+static size_t CM_QuarantineNext = 0;
 
 #define CM_ERROR(format, ...)                                           \
   do {                                                                  \
@@ -120,17 +149,17 @@ void *CM_FUNCTION_ADD_FLF(cm_malloc, size_t bytes, const char *target) {
   if (bytes == 0) {
     CM_ERROR("cannot malloc 0 bytes for target '%s'\n", target);
   }
-  PointerChain *ptrc = &PointerChain_v;
-  while (ptrc->next != NULL) {
-    ptrc = ptrc->next;
-  }
-  ptrc = ptrc->next = (PointerChain *)malloc(sizeof(PointerChain) + bytes);
+  PointerChain *ptrc = (PointerChain *)malloc(sizeof(PointerChain) + bytes);
   if (ptrc == NULL) {
     CM_ERROR("could not malloc %'zu bytes for target 'PointerChain'; %s\n",
              bytes + sizeof(PointerChain), strerror(errno));
   }
   ptrc->size = bytes;
-  ptrc->next = NULL;
+  ptrc->magic = CM_MAGIC_LIVE;
+  ptrc->prev = PointerChain_v.prev; // append at the tail
+  ptrc->next = &PointerChain_v;
+  PointerChain_v.prev->next = ptrc;
+  PointerChain_v.prev = ptrc;
   PointerChainInfo.allocated += bytes;
   PointerChainInfo.chain_length += 1;
   CM_INFO("malloc@%zu: %p %'zu bytes total %'10zu target: %s/%s\n",
@@ -140,27 +169,27 @@ void *CM_FUNCTION_ADD_FLF(cm_malloc, size_t bytes, const char *target) {
 }
 
 void CM_FUNCTION_ADD_FLF(cm_free, void *ptrv) {
-  PointerChain *ptrc = &PointerChain_v;
-  size_t id = 0;
   void *ptr = *(void **)ptrv;
-  if (ptr==NULL)
+  if (ptr == NULL)
     CM_ERROR("cannot free NULL\n");
-  ptr -= sizeof(PointerChain);
-  while (ptrc->next != NULL) {
-    if (ptrc->next == ptr) {
-      CM_INFO("free_ptrv@%zu %p %'10zu\n", id, *(void **)ptrv,
-              ptrc->next->size);
-      PointerChainInfo.chain_length -= 1;
-      PointerChainInfo.allocated -= ptrc->next->size;
-      ptrc->next = ptrc->next->next; // join the remaining structs
-      free(ptr);                     // free the pointer
-      *(void **)ptrv = NULL;         // reset mem to NULL
-      return;
-    }
-    ptrc = ptrc->next;
-    id += 1;
+  PointerChain *ptrc = (PointerChain *)((char *)ptr - sizeof(PointerChain));
+  for (size_t i = 0; i < CM_QUARANTINE; ++i) {
+    if (CM_Quarantine[i] == ptrc)
+      CM_ERROR("double free of pointer '%p'\n", ptr);
   }
-  CM_ERROR("could not locate pointer '%p'\n", ptrv);
+  if (ptrc->magic != CM_MAGIC_LIVE || ptrc->prev->next != ptrc ||
+      ptrc->next->prev != ptrc)
+    CM_ERROR("could not locate pointer '%p'\n", ptr);
+  CM_INFO("free_ptrv %p %'10zu\n", ptr, ptrc->size);
+  PointerChainInfo.chain_length -= 1;
+  PointerChainInfo.allocated -= ptrc->size;
+  ptrc->prev->next = ptrc->next; // join the remaining structs
+  ptrc->next->prev = ptrc->prev;
+  ptrc->magic = CM_MAGIC_FREED;
+  free(CM_Quarantine[CM_QuarantineNext]); // the oldest freed block, or NULL
+  CM_Quarantine[CM_QuarantineNext] = ptrc;
+  CM_QuarantineNext = (CM_QuarantineNext + 1) % CM_QUARANTINE;
+  *(void **)ptrv = NULL; // reset mem to NULL
 }
 
 size_t cm_chain_length() { return PointerChainInfo.chain_length; }
@@ -168,12 +197,16 @@ size_t cm_chain_length() { return PointerChainInfo.chain_length; }
 void CM_FUNCTION_ADD_FLF(cm_free_all) {
   CM_INFO("Before free_all: allocated %'10zu chain length %6zu\n",
           PointerChainInfo.allocated, PointerChainInfo.chain_length);
-  while (PointerChain_v.next != NULL) {
+  while (PointerChain_v.next != &PointerChain_v) {
     void *p = ((char *)PointerChain_v.next + sizeof(PointerChain));
     CM_FREE(p);
   }
   if (PointerChainInfo.allocated != 0 || PointerChainInfo.chain_length != 0)
     CM_ERROR("corrupt chain\n");
+  for (size_t i = 0; i < CM_QUARANTINE; ++i) {
+    free(CM_Quarantine[i]);
+    CM_Quarantine[i] = NULL;
+  }
   return;
 }
 
@@ -183,7 +216,7 @@ void cm_pointer_chain_print() {
   PointerChain *temp = PointerChain_v.next;
   size_t id = 1;
   printf("PointerChain=[\n");
-  while (temp != NULL) {
+  while (temp != &PointerChain_v) {
     printf("%6zu %p %10zu\n", id, (char *)temp + sizeof(PointerChain),
            temp->size);
     temp = temp->next;
@@ -192,6 +225,8 @@ void cm_pointer_chain_print() {
   printf("\tTotal: %zu bytes\n]\n", PointerChainInfo.allocated);
 }
 
+#undef CM_MAGIC_LIVE
+#undef CM_MAGIC_FREED
 #endif // CM_OFF is not defined
 
 #undef CM_ERROR
@@ -202,4 +237,5 @@ void cm_pointer_chain_print() {
 #undef TKNCCT
 #undef CONCAT_L2
 #undef CM_SILENT
+#undef CM_QUARANTINE
 #endif //__CM__
@@ -195,9 +195,11 @@ void fas_destroy(Fas fas) {
   CM_FREE(fas.labels);
 }
 
+#ifdef FAS_MAIN // cc -DFAS_MAIN fas.c, kept out of the library and bench
 int main() {
   Fas f = fas_parse(" 1234 mc-p llll 0986 .;=[ asdf");
   fas_print(f);
 
   return 0;
 }
+#endif
@@ -0,0 +1,491 @@
+#define _POSIX_C_SOURCE 200112L // shm_open, ftruncate
+#include "feed.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "arena.h"
+#include "artist.h"
+#include "figure.h"
+#include "gdata.h"
+#include "mouse_updater.h"
+#include "range_index.h"
+#include "utils.h"
+
+#define RC_FEED_NAME_LEN 256
+#define RC_FEED_SPINS 1024 // seqlock retries before a frame gives up on the last bar
+
+typedef struct {
+  Artist *artist;
+  size_t col; // feed value column of the artist's first column
+} FeedColumn;
+
+typedef struct {
+  Feed *feed;
+  uint64_t base;         // sequence number of figure row 0
+  uint64_t consumed;     // bars picked up, the figure holds [base, consumed)
+  uint64_t last_version; // of the last bar when it was picked up
+  double *rows;          // bars the figure reads, laid out as the feed columns.
+                         // NULL once the figure owns copies
+  double *last;          // copy of bar consumed-1 (epoch first) the artists
+                         // read instead of the ring when `rows` is the ring
+  size_t stride;         // between 2 columns of `rows`
+  size_t rows_bytes;     // of `rows` if it was copied out of a wrapped ring
+  double *stage;         // bars copied out of the ring, checked before use
+  size_t stage_bytes;
+  FeedColumn *columns;   // artists reading the feed
+  size_t columns_len, columns_capacity;
+} FeedReader;
+
+static void feed_shm_name(const char *name, char path[RC_FEED_NAME_LEN]);
+static Feed *feed_map(int fd, size_t bytes, bool writer);
+static bool feed_read_bar(const Feed *feed, uint64_t s, double *values,
+                          uint64_t *version);
+static size_t feed_stage(Figure *figure, FeedReader *reader, uint64_t *first,
+                         uint64_t *published);
+static void feed_take_stage(FeedReader *reader, size_t len);
+static bool feed_reader_map(Figure *figure, FeedReader *reader);
+static void feed_resync(Figure *figure, FeedReader *reader,
+                        uint64_t published);
+static void feed_index_rows(Artist *artist, size_t first, size_t end);
+static void feed_follow(Figure *figure, bool follow, size_t row);
+static bool feed_grow_in_place(Figure *figure, FeedReader *reader,
+                               uint64_t published);
+static void feed_append(Figure *figure, FeedReader *reader,
+                        uint64_t published);
+
+static void feed_shm_name(const char *name, char path[RC_FEED_NAME_LEN]) {
+  RC_ASSERT(name != NULL && name[0] != '\0', "a feed needs a name\n");
+  RC_ASSERT(strchr(name + 1, '/') == NULL,
+            "feed names cannot contain '/' but at the start\n");
+  snprintf(path, RC_FEED_NAME_LEN, "%s%s", name[0] == '/' ? "" : "/", name);
+}
+
+static Feed *feed_map(int fd, size_t bytes, bool writer) {
+  void *map = mmap(NULL, bytes, writer ? PROT_READ | PROT_WRITE : PROT_READ,
+                   MAP_SHARED, fd, 0);
+  close(fd); // the mapping keeps the object
+  if (map == MAP_FAILED)
+    return NULL;
+  CM_MALLOC(Feed * feed, sizeof(Feed));
+  *feed = (Feed){.header = map,
+                 .columns = (double *)((FeedHeader *)map + 1),
+                 .bytes = bytes,
+                 .writer = writer};
+  return feed;
+}
+
+Feed *feed_create(char *name, size_t cols, size_t capacity, size_t timeframe) {
+  RC_ASSERT(cols > 0 && capacity > 1 && timeframe > 0);
+  char path[RC_FEED_NAME_LEN];
+  feed_shm_name(name, path);
+  size_t bytes = sizeof(FeedHeader) + sizeof(double) * (cols + 1) * capacity;
+  shm_unlink(path); // readers of a previous feed keep their own object
+  int fd = shm_open(path, O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd == -1 || ftruncate(fd, bytes) == -1) {
+    RC_WARN("cannot create feed '%s'\n", path);
+    if (fd != -1) {
+      close(fd);
+      shm_unlink(path);
+    }
+    return NULL;
+  }
+  Feed *feed = feed_map(fd, bytes, true);
+  if (feed == NULL) {
+    RC_WARN("cannot map feed '%s'\n", path);
+    shm_unlink(path);
+    return NULL;
+  }
+  FeedHeader *header = feed->header; // zero filled by ftruncate
+  header->cols = cols;
+  header->capacity = capacity;
+  header->timeframe = timeframe;
+  header->version = RC_FEED_VERSION;
+  __atomic_store_n(&header->magic, RC_FEED_MAGIC, __ATOMIC_RELEASE);
+  return feed;
+}
+
+Feed *feed_open(char *name) {
+  char path[RC_FEED_NAME_LEN];
+  feed_shm_name(name, path);
+  struct stat st;
+  int fd = shm_open(path, O_RDONLY, 0);
+  if (fd == -1 || fstat(fd, &st) == -1 ||
+      (size_t)st.st_size < sizeof(FeedHeader)) {
+    RC_WARN("cannot open feed '%s'\n", path);
+    if (fd != -1)
+      close(fd);
+    return NULL;
+  }
+  Feed *feed = feed_map(fd, st.st_size, false);
+  if (feed == NULL) {
+    RC_WARN("cannot map feed '%s'\n", path);
+    return NULL;
+  }
+  FeedHeader *header = feed->header;
+  if (__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != RC_FEED_MAGIC ||
+      header->version != RC_FEED_VERSION ||
+      feed->bytes < sizeof(FeedHeader) + sizeof(double) * (header->cols + 1) *
+                                             header->capacity) {
+    RC_WARN("'%s' is not a feed of version %d\n", path, RC_FEED_VERSION);
+    feed_close(feed);
+    return NULL;
+  }
+  return feed;
+}
+
+void feed_close(Feed *feed) {
+  munmap(feed->header, feed->bytes);
+  CM_FREE(feed);
+}
+
+bool feed_unlink(char *name) {
+  char path[RC_FEED_NAME_LEN];
+  feed_shm_name(name, path);
+  return shm_unlink(path) == 0;
+}
+
+void feed_publish(Feed *feed, double x, double *values) {
+  RC_ASSERT(feed->writer, "the feed was opened read only\n");
+  FeedHeader *header = feed->header;
+  uint64_t s = header->published; // only stored by this process
+  size_t capacity = header->capacity, row = s % capacity;
+  RC_ASSERT(s == 0 || x > feed->columns[(s - 1) % capacity],
+            "bars must be published in time order\n");
+  feed->columns[row] = x;
+  for (size_t c = 0; c < header->cols; ++c)
+    feed->columns[(c + 1) * capacity + row] = values[c];
+  __atomic_store_n(&header->published, s + 1, __ATOMIC_RELEASE);
+}
+
+void feed_update_last(Feed *feed, double *values) {
+  RC_ASSERT(feed->writer, "the feed was opened read only\n");
+  FeedHeader *header = feed->header;
+  RC_ASSERT(header->published > 0, "no bar was published\n");
+  size_t capacity = header->capacity, row = (header->published - 1) % capacity;
+  uint64_t version = header->last_version;
+  __atomic_store_n(&header->last_version, version + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE); // odd before any value
+  for (size_t c = 0; c < header->cols; ++c)
+    feed->columns[(c + 1) * capacity + row] = values[c];
+  __atomic_store_n(&header->last_version, version + 2, __ATOMIC_RELEASE);
+}
+
+uint64_t feed_published(Feed *feed) {
+  return __atomic_load_n(&feed->header->published, __ATOMIC_ACQUIRE);
+}
+
+size_t feed_cols(Feed *feed) { return feed->header->cols; }
+
+/**
+copies the epoch and values of bar `s` into `values` (cols+1 items) under the
+seqlock, so a bar being rewritten is never torn. false if the producer stays
+in the middle of a rewrite
+*/
+static bool feed_read_bar(const Feed *feed, uint64_t s, double *values,
+                          uint64_t *version) {
+  FeedHeader *header = feed->header;
+  size_t capacity = header->capacity, row = s % capacity;
+  for (size_t spin = 0; spin < RC_FEED_SPINS; ++spin) {
+    uint64_t before = __atomic_load_n(&header->last_version, __ATOMIC_ACQUIRE);
+    if (before & 1)
+      continue;
+    for (size_t c = 0; c <= header->cols; ++c)
+      values[c] = feed->columns[c * capacity + row];
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&header->last_version, __ATOMIC_RELAXED) == before) {
+      *version = before;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+copies bars [*first, *published) out of the ring into `reader->stage`, one
+column of len bars after the other, the last bar under the seqlock. Bars that
+are not readable, or that the producer overwrote during the copy, are dropped
+from the front: *first and *published move forward. returns len
+*/
+static size_t feed_stage(Figure *figure, FeedReader *reader, uint64_t *first,
+                         uint64_t *published) {
+  Feed *feed = reader->feed;
+  size_t capacity = feed->header->capacity, cols = feed->header->cols;
+  for (;;) {
+    if (*published >= capacity && *first < *published - capacity + 1)
+      *first = *published - capacity + 1;
+    size_t len = *published - *first, bytes = sizeof(double) * (cols + 1) * len;
+    if (bytes > reader->stage_bytes) {
+      reader->stage = arena_resize((Arena *)figure->arena, reader->stage,
+                                   reader->stage_bytes, bytes);
+      reader->stage_bytes = bytes;
+    }
+    for (size_t c = 0; c <= cols; ++c) {
+      for (uint64_t s = *first; s < *published;) { // at most 2 runs of the ring
+        size_t at = s % capacity, run = minl(*published - s, capacity - at);
+        memcpy(reader->stage + c * len + (s - *first),
+               feed->columns + c * capacity + at, sizeof(double) * run);
+        s += run;
+      }
+    }
+    double bar[cols + 1];
+    if (feed_read_bar(feed, *published - 1, bar, &reader->last_version)) {
+      for (size_t c = 0; c <= cols; ++c)
+        reader->stage[c * len + len - 1] = bar[c];
+    }
+    __atomic_thread_fence(__ATOMIC_ACQUIRE); // the copies before the check
+    uint64_t now = feed_published(feed);
+    if (*first + capacity > now) // none was overwritten meanwhile
+      return len;
+    *published = now;
+  }
+}
+
+/**
+the stage becomes `reader->rows`, the bars the artists read
+*/
+static void feed_take_stage(FeedReader *reader, size_t len) {
+  reader->rows = reader->stage;
+  reader->rows_bytes = reader->stage_bytes;
+  reader->stride = len;
+  reader->stage = NULL;
+  reader->stage_bytes = 0;
+}
+
+void figure_attach_feed(Figure *figure, Feed *feed, FormatterType ftype,
+                        char *format) {
+  RC_ASSERT(figure->feed == NULL, "a feed is already attached\n");
+  FeedHeader *header = feed->header;
+  uint64_t published = feed_published(feed), first = 0;
+  RC_ASSERT(published > 0, "the feed has no bars yet\n");
+  FeedReader *reader = arena_alloc((Arena *)figure->arena, sizeof(FeedReader));
+  *reader = (FeedReader){.feed = feed,
+                         .consumed = published,
+                         .rows = feed->columns,
+                         .last = arena_alloc((Arena *)figure->arena,
+                                             sizeof(double) * (header->cols + 1)),
+                         .stride = header->capacity};
+  if (published >= header->capacity) { // wrapped, the bars are out of order
+    feed_take_stage(reader, feed_stage(figure, reader, &first, &published));
+    reader->base = first;
+    reader->consumed = published;
+  } else if (!feed_read_bar(feed, published - 1, reader->last,
+                            &reader->last_version)) {
+    reader->last_version = UINT64_MAX; // the next poll copies it again
+  }
+  set_dragger(figure, reader->consumed - reader->base, header->timeframe,
+              reader->rows, ftype, format);
+  figure->feed = reader;
+}
+
+Gdata figure_feed_gdata(Figure *figure, size_t col, size_t cols, char *label) {
+  FeedReader *reader = (FeedReader *)figure->feed;
+  RC_ASSERT(reader != NULL, "call '%s' first\n", RC_ECHO(figure_attach_feed));
+  RC_ASSERT(reader->rows != NULL,
+            "artists cannot be created once the figure owns the bars\n");
+  RC_ASSERT(cols > 0 && col + cols <= reader->feed->header->cols);
+  bool in_place = reader->rows == reader->feed->columns;
+  return (Gdata){.cols = cols,
+                 .ydata = reader->rows + (col + 1) * reader->stride,
+                 .label = label,
+                 .stride = reader->stride,
+                 .last = in_place ? reader->last + col + 1 : NULL,
+                 .last_row = reader->consumed - reader->base - 1};
+}
+
+/**
+lists the artists whose data are columns of `reader->rows`. false if another
+artist has data, which cannot grow with the feed in place
+*/
+static bool feed_reader_map(Figure *figure, FeedReader *reader) {
+  size_t artists = 0, cols = reader->feed->header->cols;
+  for (size_t i = 0; i < figure->axes_len; ++i)
+    artists += figure->axes[i].artist_len;
+  if (artists > reader->columns_capacity) {
+    reader->columns = arena_resize(
+        (Arena *)figure->arena, reader->columns,
+        sizeof(FeedColumn) * reader->columns_capacity,
+        sizeof(FeedColumn) * artists);
+    reader->columns_capacity = artists;
+  }
+  bool in_place = true;
+  reader->columns_len = 0;
+  for (size_t i = 0; i < figure->axes_len; ++i) {
+    Axes *axes = figure->axes + i;
+    for (size_t a = 0; a < axes->artist_len; ++a) {
+      Artist *artist = get_artist(axes, a);
+      if (artist->index == NULL)
+        continue;
+      const double *ydata = artist->gdata.ydata;
+      const double *first = reader->rows + reader->stride,
+                   *end = reader->rows + (cols + 1) * reader->stride;
+      if (ydata < first || ydata >= end ||
+          artist->gdata.stride != reader->stride ||
+          (ydata - reader->rows) % reader->stride != 0) {
+        in_place = false;
+        continue;
+      }
+      reader->columns[reader->columns_len++] = (FeedColumn){
+          .artist = artist,
+          .col = (ydata - reader->rows) / reader->stride - 1,
+      };
+    }
+  }
+  return in_place;
+}
+
+static void feed_index_rows(Artist *artist, size_t first, size_t end) {
+  for (size_t row = first; row < end;
+       row = (row / RC_RANGE_INDEX_BLOCK + 1) * RC_RANGE_INDEX_BLOCK)
+    range_index_update((RangeIndex *)artist->index, &artist->gdata, row);
+}
+
+/**
+moves the window onto the new bars if it was showing the last one, widening it
+to RC_INITIAL_VISIBLE_DATA bars, otherwise redraws it if it shows `row`
+*/
+static void feed_follow(Figure *figure, bool follow, size_t row) {
+  Dragger *dragger = &figure->dragger;
+  if (follow) {
+    dragger->vlen = maxl(dragger->vlen, minl(RC_INITIAL_VISIBLE_DATA, dragger->_len));
+    update_from_position(dragger->_len - dragger->vlen, figure);
+  } else if (dragger->start + dragger->vlen > row) {
+    update_from_position(dragger->start, figure);
+  }
+}
+
+/**
+the artists read bars [base, published) of the ring, the last one from a copy
+which the producer cannot rewrite under them. false if it cannot be copied yet
+*/
+static bool feed_grow_in_place(Figure *figure, FeedReader *reader,
+                               uint64_t published) {
+  Dragger *dragger = &figure->dragger;
+  size_t cols = reader->feed->header->cols;
+  double bar[cols + 1];
+  if (!feed_read_bar(reader->feed, published - 1, bar, &reader->last_version))
+    return false;
+  memcpy(reader->last, bar, sizeof(double) * (cols + 1));
+  size_t last = dragger->_len - 1; // final now, read from the ring
+  bool follow = dragger->start + dragger->vlen == dragger->_len;
+  dragger->_len = published;
+  for (size_t i = 0; i < reader->columns_len; ++i) {
+    Artist *artist = reader->columns[i].artist;
+    artist->gdata.last_row = dragger->_len - 1;
+    range_index_resize((RangeIndex *)artist->index, &artist->gdata,
+                       dragger->_len);
+    range_index_update((RangeIndex *)artist->index, &artist->gdata, last);
+  }
+  reader->consumed = published;
+  feed_follow(figure, follow, last);
+  return true;
+}
+
+/**
+the producer overwrote bars a figure reads in place: start over from a copy of
+the readable ones
+*/
+static void feed_resync(Figure *figure, FeedReader *reader,
+                        uint64_t published) {
+  Dragger *dragger = &figure->dragger;
+  uint64_t first = 0;
+  feed_reader_map(figure, reader); // before the rows move
+  feed_take_stage(reader, feed_stage(figure, reader, &first, &published));
+  RC_WARN("the feed lapped the figure, it restarts from bar %lu\n",
+          (unsigned long)first);
+  reader->base = first;
+  reader->consumed = published;
+  dragger->xdata = reader->rows;
+  dragger->_len = published - first;
+  dragger->vlen = minl(dragger->vlen, dragger->_len);
+  for (size_t i = 0; i < reader->columns_len; ++i) {
+    Artist *artist = reader->columns[i].artist;
+    gdata_set_native(&artist->gdata,
+                     reader->rows + (reader->columns[i].col + 1) * reader->stride,
+                     reader->stride);
+    range_index_rebuild((RangeIndex *)artist->index, &artist->gdata,
+                        dragger->_len, reader->stride);
+  }
+  feed_follow(figure, true, 0);
+}
+
+static void feed_append(Figure *figure, FeedReader *reader,
+                        uint64_t published) {
+  Dragger *dragger = &figure->dragger;
+  if (reader->rows != NULL)
+    feed_reader_map(figure, reader); // the artists to copy bars into, for good
+  size_t last = dragger->_len - 1; // may have been rewritten since
+  uint64_t first = reader->consumed - 1;
+  size_t len = feed_stage(figure, reader, &first, &published);
+  if (first > reader->consumed)
+    RC_WARN("the feed lapped the figure, %lu bars are lost\n",
+            (unsigned long)(first - reader->consumed));
+  size_t skip = first < reader->consumed; // bar `last` is staged too
+  reader->base = first + skip - dragger->_len;
+  bool follow = dragger->start + dragger->vlen == dragger->_len;
+  figure_append_rows(figure, reader->stage + skip, len - skip);
+  if (reader->rows_bytes != 0)
+    arena_release((Arena *)figure->arena, reader->rows, reader->rows_bytes);
+  reader->rows = NULL;
+  reader->rows_bytes = 0;
+  size_t row = dragger->_len - len; // of the first staged bar
+  for (size_t i = 0; i < reader->columns_len; ++i) {
+    Gdata *gdata = &reader->columns[i].artist->gdata;
+    for (size_t c = 0; c < gdata->cols; ++c)
+      memcpy(gdata->ydata + c * gdata->stride + row,
+             reader->stage + (reader->columns[i].col + c + 1) * len,
+             sizeof(double) * len);
+    feed_index_rows(reader->columns[i].artist, row, dragger->_len);
+  }
+  reader->consumed = published;
+  feed_follow(figure, follow, last);
+}
+
+bool feed_pending(Figure *figure) {
+  FeedReader *reader = (FeedReader *)figure->feed;
+  FeedHeader *header = reader->feed->header;
+  return feed_published(reader->feed) != reader->consumed ||
+         __atomic_load_n(&header->last_version, __ATOMIC_ACQUIRE) !=
+             reader->last_version;
+}
+
+bool feed_poll(Figure *figure) {
+  FeedReader *reader = (FeedReader *)figure->feed;
+  Feed *feed = reader->feed;
+  FeedHeader *header = feed->header;
+  uint64_t published = feed_published(feed);
+  uint64_t version = __atomic_load_n(&header->last_version, __ATOMIC_ACQUIRE);
+  if (published == reader->consumed && version == reader->last_version)
+    return false;
+  if (published != reader->consumed) {
+    bool in_place =
+        reader->rows == feed->columns && feed_reader_map(figure, reader);
+    if (in_place && published >= header->capacity) {
+      feed_resync(figure, reader, published);
+    } else if (in_place && published <= header->capacity / 2) {
+      return feed_grow_in_place(figure, reader, published);
+    } else {
+      feed_append(figure, reader, published);
+    }
+    return true;
+  }
+  double bar[header->cols + 1];
+  if (!feed_read_bar(feed, published - 1, bar, &reader->last_version))
+    return false;
+  if (reader->rows == feed->columns) { // the artists read reader->last
+    memcpy(reader->last, bar, sizeof(double) * (header->cols + 1));
+    feed_reader_map(figure, reader);
+    for (size_t i = 0; i < reader->columns_len; ++i)
+      artist_last_changed(reader->columns[i].artist);
+    return true;
+  }
+  if (reader->rows != NULL) // a copy of a wrapped ring, the artists read it
+    feed_reader_map(figure, reader);
+  for (size_t i = 0; i < reader->columns_len; ++i)
+    artist_update_last(reader->columns[i].artist,
+                       bar + reader->columns[i].col + 1);
+  return true;
+}
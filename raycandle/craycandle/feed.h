@@ -0,0 +1,56 @@
+/*
+ * Feed
+ * ----
+ * single producer ring of bars in shared memory. The mapping starts with a
+ * FeedHeader followed by cols+1 columns of `capacity` doubles: the epochs,
+ * then every value column. Bar `s` (its sequence number) lives at index
+ * s % capacity of each column, so a ring that has not wrapped holds bars in
+ * order and can back a dragger and its artists directly.
+ *
+ * The producer writes a bar and then publishes it with a release store of
+ * `published`; readers acquire `published` and may read bars
+ * [published - capacity + 1, published). The last bar may be rewritten in
+ * place (a forming candle): `last_version` is a seqlock around that, odd
+ * while a rewrite is in flight. A figure reading the ring in place reads the
+ * last bar from a copy taken under the seqlock (Gdata.last), never the slot
+ * being rewritten.
+ */
+#ifndef __RAYCANDLE_FEED__
+#define __RAYCANDLE_FEED__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "raycandle.h"
+
+#define RC_FEED_MAGIC 0x4445454643524152u // "RARCFEED" little endian
+#define RC_FEED_VERSION 1
+
+typedef struct {
+  uint64_t magic, version; // stored last by feed_create
+  uint64_t cols;           // value columns, the epochs are not counted
+  uint64_t capacity;       // bars in the ring
+  uint64_t timeframe;      // seconds between bars
+  uint64_t published;      // bars published so far
+  uint64_t last_version;   // seqlock of bar published-1
+  uint64_t reserved;
+} FeedHeader; // one cache line, the columns start right after it
+
+struct Feed {
+  FeedHeader *header;
+  double *columns; // epochs at 0, value column c at (c+1)*capacity
+  size_t bytes;    // of the mapping
+  bool writer;
+};
+
+/**
+picks up the bars published or rewritten since the last call. Called by
+update_figure on every frame; returns whether the figure changed
+*/
+bool feed_poll(Figure *figure);
+/**
+whether feed_poll has bars to pick up, without picking them up
+*/
+bool feed_pending(Figure *figure);
+
+#endif //__RAYCANDLE_FEED__
@@ -8,23 +8,51 @@
 #include <time.h>
 #include <unistd.h>
 
+#include "arena.h"
+#include "artist.h"
 #include "axes.h"
+#include "canvas.h"
 #include "fas.h"
+#include "feed.h"
+#include "indicator.h"
+#include "layers.h"
 #include "locator.h"
 #include "mouse_updater.h"
+#include "pacer.h"
+#include "profiler.h"
+#include "publish.h"
+#include "range_index.h"
 #include "raycandle.h"
 #include "ready_signal.h"
+#include "resample.h"
+#include "text.h"
+#include "time_index.h"
 #include "utils.h"
 
+#define RC_TOOLTIP_LEN 128
+#define RC_TOOLTIP_KEYS 13
+
+typedef struct {
+  double key[RC_TOOLTIP_KEYS]; // what the text shows, see tooltip_changed
+  char buffer[RC_TOOLTIP_LEN];
+  Str text; // NULL until the first frame
+} Tooltip;
+
 static void figure_draw_cursors(Figure *figure);    // draw cursor positions
 static bool set_real_span_skel_map(Figure *figure); // map axes skeletons to real pixels
 static bool set_borders(Figure *figure);            // returns if borders can be set
 static void update_fps(Figure *figure);             // set fps according to figure->fps
 static void draw_title(Figure *figure);             // draw title
 static void draw_tooltip(Figure *figure);           // draw tooltip data
+static bool tooltip_changed(Figure *figure, size_t axes_under_mouse); // the text must be rebuilt
 static void draw_current_time(Figure *figure);      // show current time. might be used if the
                                                     // app is doing nothing
 static void load_font(Figure *figure);
+static Canvas *figure_canvas(Figure *figure); // canvas of the figure's size
+static bool figure_update_frame(Figure *figure); // update_figure, untimed
+static void draw_profiler(Figure *figure);       // per phase percentiles
+static void figure_set_capacity(Figure *figure, size_t capacity); // own and grow data
+static size_t figure_memory(Figure *figure); // bytes of the figure's arena and of CM
 
 static int processId = 0;
 
@@ -121,6 +149,7 @@ void raylib_init(Figure *figure) {
   string_destroy(window_title);
   load_font(figure);
   update_fps(figure);
+  publisher_start((Publisher *)figure->publisher);
   ready_signal_set((ReadySignal *)figure->initialized);
 }
 
@@ -155,14 +184,38 @@ static void draw_current_time(Figure *figure) {
   tm_info = localtime(&tv.tv_sec);
   string_append(buffer, "%04d-%02d-%02d   %02d:%02d:%02d   %02ld", tm_info->tm_year + 1900, tm_info->tm_mon + 1, tm_info->tm_mday, tm_info->tm_hour,
                 tm_info->tm_min, tm_info->tm_sec, tv.tv_usec / 10000);
-  float x = align_text(FIGURE_FONT(figure), buffer, figure->width - 10, figure->font_size, figure->font_spacing, RC_ALIGNMENT_CENTER);
+  float x = text_align((TextCache *)figure->text_cache, FIGURE_FONT(figure), buffer, figure->width - 10, figure->font_size, figure->font_spacing,
+                       RC_ALIGNMENT_CENTER);
   DrawTextEx(FIGURE_FONT(figure), buffer, (Vector2){x, figure->height / 2}, figure->font_size, figure->font_spacing, figure->text_color);
 }
 
 static void draw_title(Figure *figure) {
   RC_ASSERT(figure->title != NULL);
-  float x = align_text(FIGURE_FONT(figure), figure->title, figure->width, figure->font_size, figure->font_spacing, RC_ALIGNMENT_CENTER);
-  DrawTextEx(FIGURE_FONT(figure), figure->title, (Vector2){x, 0}, figure->font_size, figure->font_spacing, figure->text_color);
+  RC_PROFILE_BEGIN(PROFILE_PHASE_TEXT);
+  TextCache *cache = (TextCache *)figure->text_cache;
+  float x = text_align(cache, FIGURE_FONT(figure), figure->title, figure->width, figure->font_size, figure->font_spacing, RC_ALIGNMENT_CENTER);
+  text_draw(cache, FIGURE_FONT(figure), figure->title, (Vector2){x, 0}, figure->font_size, figure->font_spacing, figure->text_color);
+  RC_PROFILE_END(PROFILE_PHASE_TEXT);
+}
+
+static size_t figure_memory(Figure *figure) {
+  // buffers, indexes, layers and levels live in the arena, strings in CM
+  return arena_size((Arena *)figure->arena) + cm_malloc_size();
+}
+
+static bool tooltip_changed(Figure *figure, size_t axes_under_mouse) {
+  Tooltip *tooltip = (Tooltip *)figure->tooltip;
+  Axes *axes = figure->axes + axes_under_mouse;
+  bool on_axes = axes_under_mouse != figure->axes_len;
+  double key[RC_TOOLTIP_KEYS] = {
+    GetFPS(), figure_memory(figure), GetMouseX(), GetMouseY(), axes_under_mouse, figure->width, figure->height,
+    figure->dragger.start, figure->dragger.vlen, figure->dragger._len, figure->dragger.timeframe,
+    on_axes ? axes->ylocator.limit.limit_min : 0, on_axes ? axes->ylocator.limit.limit_max : 0,
+  };
+  if (tooltip->text != NULL && !memcmp(key, tooltip->key, sizeof(key)))
+    return false;
+  memcpy(tooltip->key, key, sizeof(key));
+  return true;
 }
 
 static void draw_tooltip(Figure *figure) {
@@ -170,29 +223,52 @@ static void draw_tooltip(Figure *figure) {
     fps  [index_under_mouse/total_length] [current_time-xindex[-1]] timeframe
     'axes_label_under_mouse' x_index_under_mouse y_index_under_mouse
   */
-#define buf_size 128
-  char _buffer[buf_size];
-  char *buffer = string_create(buf_size, _buffer);
+  RC_PROFILE_BEGIN(PROFILE_PHASE_TEXT);
+  Tooltip *tooltip = (Tooltip *)figure->tooltip;
+  TextCache *cache = (TextCache *)figure->text_cache;
   size_t axes_under_mouse = get_axes_index_under_mouse(figure);
   Axes *axes = figure->axes + axes_under_mouse;
-  string_append(buffer, "fps=%'d  mem:%'zu ", GetFPS(), cm_malloc_size());
-  if (figure->has_dragger) { // the user has called `set_dragger` because
-    // otherwise we do not have
-    // xdata
-    if (figure->axes_len != axes_under_mouse && axes->artist_len != 0) {
-      int mousex_iloc = (int)(((float)(GetMouseX() - axes->startX) / (axes->width) * figure->dragger.vlen) + figure->dragger.start);
-      string_append(buffer, "%zu [%d/%zu] ", figure->dragger.vlen, mousex_iloc, (figure->dragger._len - 1));
-      string_append(buffer, "timeframe=%zu ", figure->dragger.timeframe);
-      locator_tooltip_mouse_position(axes, buffer, GetMouseX(), GetMouseY());
-    } else {
-      string_append(buffer, "Xindex[-1]=");
-      formatter_to_str(figure->dragger.locator.ftype, figure->dragger.locator.format, buffer, &figure->dragger.xdata[figure->dragger._len - 1]);
+  if (tooltip_changed(figure, axes_under_mouse)) { // else reuse the last text
+    Str buffer = tooltip->text = string_create(RC_TOOLTIP_LEN, tooltip->buffer);
+    string_append(buffer, "fps=%'d  mem:%'zu ", GetFPS(), figure_memory(figure));
+    if (figure->has_dragger) { // the user has called `set_dragger` because
+      // otherwise we do not have
+      // xdata
+      if (figure->axes_len != axes_under_mouse && axes->artist_len != 0) {
+        size_t mousex_iloc = time_index_row_at_pixel(axes, GetMouseX());
+        string_append(buffer, "%zu [%zu/%zu] ", figure->dragger.vlen, mousex_iloc, (figure->dragger._len - 1));
+        string_append(buffer, "timeframe=%zu ", figure->dragger.timeframe);
+        locator_tooltip_mouse_position(axes, buffer, GetMouseX(), GetMouseY());
+      } else {
+        string_append(buffer, "Xindex[-1]=");
+        formatter_to_str(figure->dragger.locator.ftype, figure->dragger.locator.format, buffer, &figure->dragger.xdata[figure->dragger._len - 1]);
+      }
     }
   }
   float x = figure->border_dimensions[0] + AXES_FRAME_THICK +
-    align_text(FIGURE_FONT(figure), buffer, (size_t)figure->width - (figure->border_dimensions[0] + AXES_FRAME_THICK), figure->font_size,
+    text_align(cache, FIGURE_FONT(figure), tooltip->text, (size_t)figure->width - (figure->border_dimensions[0] + AXES_FRAME_THICK), figure->font_size,
                figure->font_spacing, RC_ALIGNMENT_LEFT);
-  DrawTextEx(FIGURE_FONT(figure), buffer, (Vector2){x, figure->height - figure->font_size}, figure->font_size, figure->font_spacing, figure->text_color);
+  text_draw(cache, FIGURE_FONT(figure), tooltip->text, (Vector2){x, figure->height - figure->font_size}, figure->font_size, figure->font_spacing, figure->text_color);
+  RC_PROFILE_END(PROFILE_PHASE_TEXT);
+}
+
+static void draw_profiler(Figure *figure) {
+#define PROFILER_BUF_LEN 128
+  char _buffer[PROFILER_BUF_LEN];
+  Str buffer = string_create(PROFILER_BUF_LEN, _buffer);
+  Vector2 position = {figure->border_dimensions[0] + AXES_FRAME_THICK * 2, figure->font_size * 2};
+  DrawRectangle(position.x, position.y, figure->width / 2, RC_LABEL_FONT_SIZE * (PROFILE_PHASE_LEN + 1), Fade(figure->background_color, 0.85f));
+  string_append(buffer, "%-28s %10s %10s  (us/frame)", "phase", "p50", "p99");
+  DrawTextEx(FIGURE_FONT(figure), buffer, position, RC_LABEL_FONT_SIZE, figure->font_spacing, figure->text_color);
+  for (ProfilePhase phase = 0; phase < PROFILE_PHASE_LEN; ++phase) {
+    if (profiler_samples(phase) == 0)
+      continue;
+    position.y += RC_LABEL_FONT_SIZE;
+    string_clear(buffer);
+    string_append(buffer, "%-28s %10.1f %10.1f", profiler_phase_name(phase), profiler_percentile(phase, 0.5), profiler_percentile(phase, 0.99));
+    DrawTextEx(FIGURE_FONT(figure), buffer, position, RC_LABEL_FONT_SIZE, figure->font_spacing, figure->text_color);
+  }
+#undef PROFILER_BUF_LEN
 }
 
 static void load_font(Figure *figure) {
@@ -202,48 +278,91 @@ static void load_font(Figure *figure) {
 }
 
 bool update_figure(Figure *figure) {
-  int sd[] = {GetScreenWidth(), GetScreenHeight()};
+  RC_PROFILE_BEGIN(PROFILE_PHASE_UPDATE_FIGURE);
+  bool drawn = figure_update_frame(figure);
+  RC_PROFILE_END(PROFILE_PHASE_UPDATE_FIGURE);
+  return drawn;
+}
+
+static bool figure_update_frame(Figure *figure) {
+  publisher_consume(figure); // changes of other threads, before anything reads
+  if (publisher_try_lock(figure)) { // writers read the base rows
+    resample_refresh(figure);
+    publisher_unlock(figure);
+  }
+  if (figure->feed != NULL) {
+    feed_poll(figure);
+  }
+  Canvas *canvas = canvas_active();
+  int sd[] = {canvas ? canvas->width : GetScreenWidth(), canvas ? canvas->height : GetScreenHeight()};
   figure->sds =
     (sd[0] == figure->width && sd[1] == figure->height) ? SCREEN_DIMENSION_STATE_UNCHANGED : SCREEN_DIMENSION_STATE_CHANGED; // cannot be
   // SCREEN_DIMENSION_STATE_DEFAULT
-  if (figure->force_update) {
+  figure->width = sd[0];
+  figure->height = sd[1];
+  bool relayout = figure->force_update || figure->sds == SCREEN_DIMENSION_STATE_CHANGED;
+  if (relayout) {
     figure->force_update = false;
     figure->sds = SCREEN_DIMENSION_STATE_CHANGED;
-    if (figure->has_dragger) {
-      update_from_position(figure->dragger.start, figure);
+    for (size_t i = 0; i < figure->axes_len; ++i) {
+      layers_invalidate((AxesLayers *)figure->axes[i].layers);
     }
   }
-  figure->width = sd[0];
-  figure->height = sd[1];
   if (!set_borders(figure)) {
     return false;
   }
   if (!set_real_span_skel_map(figure)) {
     return false;
   }
+  if (relayout && figure->has_dragger) {
+    // slots depend on the width: mapped on the axes of this frame's size
+    update_from_position(figure->dragger.start, figure);
+  }
   if (figure->title != NULL) {
     draw_title(figure);
   }
-  if (IsKeyPressed(KEY_LEFT_SHIFT) || IsKeyPressed(KEY_RIGHT_SHIFT)) {
-    figure->clear_screen = !figure->clear_screen;
-  }
-  if (figure->clear_screen) {
-    figure->force_update = true;
-    draw_current_time(figure);
-    return true;
+  if (canvas == NULL) { // no mouse, keyboard or overlay without a window
+    if (IsKeyPressed(KEY_LEFT_SHIFT) || IsKeyPressed(KEY_RIGHT_SHIFT)) {
+      figure->clear_screen = !figure->clear_screen;
+    }
+    if (IsKeyPressed(KEY_P)) {
+      figure->show_profiler = !figure->show_profiler;
+      profiler_enable(figure->show_profiler);
+    } else if (figure->show_profiler && !profiler_enabled) {
+      profiler_enable(true);
+    }
+    if (figure->clear_screen) {
+      figure->force_update = true;
+      draw_current_time(figure);
+      return true;
+    }
   }
   for (size_t i = 0; i < figure->axes_len; ++i) {
-    if (!draw_axes(figure->axes + i)) {
+    RC_PROFILE_BEGIN(PROFILE_PHASE_DRAW_AXES);
+    bool drawn = draw_axes(figure->axes + i);
+    RC_PROFILE_END(PROFILE_PHASE_DRAW_AXES);
+    if (!drawn) {
       return false;
     }
   }
+  if (canvas != NULL) {
+    return true;
+  }
   if (figure->dragger.ulen > 0) {
+    RC_PROFILE_BEGIN(PROFILE_PHASE_MOUSE_UPDATES);
     mouse_updates(figure);
+    RC_PROFILE_END(PROFILE_PHASE_MOUSE_UPDATES);
+  }
+  for (size_t i = 0; i < figure->axes_len; ++i) {
+    axes_draw_overlay(figure->axes + i);
   }
   if (figure->show_cursors == true) {
     figure_draw_cursors(figure);
   }
   draw_tooltip(figure);
+  if (figure->show_profiler) {
+    draw_profiler(figure);
+  }
   return true;
 }
 
@@ -257,11 +376,30 @@ void update_xlim(Figure *figure) {
   lmax += figure->dragger.timeframe / 2.f; // if visible_data=1 then
                                            // lmax-lmin=0
   figure->dragger.locator.limit = (Limit){.limit_max = lmax, .limit_min = lmin, .diff = lmax - lmin, .is_static = figure->dragger.locator.limit.is_static};
-  for (size_t i = 0; i < figure->dragger.vlen; ++i, ++y)
-    figure->dragger.xdata_shared[i] = (double)i / figure->dragger.vlen;
+  // about one slot per RC_LOD_SLOT_PIXELS pixel columns of the narrowest axes
+  long int slots = figure->width / (long int)(figure->cols * RC_LOD_SLOT_PIXELS);
+  slots = minl(minl(maxl(slots, 1), RC_MAX_PLOTTABLE_LEN), figure->dragger.vlen);
+  figure->dragger.slots = slots;
+  time_index_map_slots(&figure->dragger);
   figure->label_length = snprintf(NULL, 0, "%.5f", lmax);
 }
 
+static inline size_t dragger_slot_start(const Dragger *dragger, size_t slot) {
+  size_t row = dragger->start + slot * dragger->vlen / dragger->slots;
+  size_t grain = dragger->slots * RC_LOD_ALIGN; // vlen when slots are RC_LOD_ALIGN wide
+  if (dragger->vlen < grain * RC_RANGE_INDEX_GRAIN || slot == 0 ||
+      slot == dragger->slots)
+    return row; // narrow slots and the window edges stay where they are
+  grain = dragger->vlen < grain * RC_RANGE_INDEX_BLOCK ? RC_RANGE_INDEX_GRAIN
+                                                       : RC_RANGE_INDEX_BLOCK;
+  return row - row % grain;
+}
+
+void dragger_slot_range(const Dragger *dragger, size_t slot, size_t range[2]) {
+  range[0] = dragger_slot_start(dragger, slot);
+  range[1] = dragger_slot_start(dragger, slot + 1);
+}
+
 Figure *create_figure(char *figskel, int *fig_size, char *window_title, Color background_color, float border_percentage, int fps, size_t font_size,
                       int font_spacing, char *font_path) {
   Fas fas=fas_parse(figskel);
@@ -272,10 +410,15 @@ Figure *create_figure(char *figskel, int *fig_size, char *window_title, Color ba
     RC_ERROR("font_size is 0\n");
   }
   setlocale(LC_NUMERIC, "");
-  size_t *CM_MALLOC(border_dimensions,sizeof(size_t) * 2);
-  size_t *CM_MALLOC(axes_skels_dyn,sizeof(size_t) * fas.len * 4);
+  Arena *arena = arena_create();
+  Figure *figure = arena_alloc(arena, sizeof(Figure));
+  size_t *border_dimensions = arena_alloc(arena, sizeof(size_t) * 2);
+  size_t *axes_skels_dyn = arena_alloc(arena, sizeof(size_t) * fas.len * 4);
+  size_t *axes_skels_copy = arena_alloc(arena, sizeof(size_t) * fas.len * 4);
+  Tooltip *tooltip = arena_alloc(arena, sizeof(Tooltip));
+  *tooltip = (Tooltip){.text = NULL};
   memcpy(axes_skels_dyn, fas.skel, sizeof(fas.skel[0]) * fas.len * 4);
-  Figure *CM_MALLOC(figure,sizeof(Figure));
+  memcpy(axes_skels_copy, fas.skel, sizeof(fas.skel[0]) * fas.len * 4);
   memset(figure, 0, sizeof(*figure));
   *figure = (Figure){
     .width = fig_size[0],
@@ -286,6 +429,7 @@ Figure *create_figure(char *figskel, int *fig_size, char *window_title, Color ba
     .zoomx_padding = 0.f,
     .vertical_limit_drag = 0.f,
     .border_percentage = border_percentage,
+    .min_refresh = RC_MIN_REFRESH,
     // .dragger=set by calling set_dragger
     .title = NULL,
     .window_title = window_title ? string_create_from_format(0, NULL, "%s", window_title) : NULL,
@@ -293,13 +437,23 @@ Figure *create_figure(char *figskel, int *fig_size, char *window_title, Color ba
     .rows = fas.rows,
     .cols = fas.cols,
     .axes_skels = axes_skels_dyn,
-    .axes_skels_copy = fas.skel,
+    .axes_skels_copy = axes_skels_copy,
     .label_length = 0,
     .axes = NULL,
     .border_dimensions = border_dimensions,
     .font = GetFontDefault(),
     .font_path = string_create_from_format(0, NULL, "%s", font_path),
     .initialized = ready_signal_create(),
+    .canvas = NULL,
+    .arena = arena,
+    .text_cache = text_cache_create(arena),
+    .tooltip = tooltip,
+    .feed = NULL,
+    .bar_file = NULL,
+    .publisher = publisher_create(arena),
+    .pacer = pacer_create(arena),
+    .resampler = resampler_create(arena),
+    .indicators = indicators_create(arena),
     .mouse_drag = {0},
     .axes_frame_color = BLACK,
     .background_color = background_color,
@@ -311,17 +465,46 @@ Figure *create_figure(char *figskel, int *fig_size, char *window_title, Color ba
     .clear_screen = false,
     .show_xlabels = true,
     .show_ylabels = true,
+    .show_profiler = false,
   };
   create_axes(figure, fas.labels);
-  CM_FREE(fas.labels);
+  fas_destroy(fas);
   return figure;
 }
 
+void destroy_figure(Figure *figure) {
+  RC_ASSERT(processId == 0 || IsWindowReady() == false,
+            "cannot destroy a figure while its window is open\n");
+  for (size_t i = 0; i < figure->axes_len; ++i) {
+    Axes *axes = figure->axes + i;
+    layers_unload((AxesLayers *)axes->layers);
+    artists_unload(axes);
+    if (axes->title != NULL)
+      string_destroy(axes->title);
+  }
+  if (figure->canvas != NULL)
+    canvas_destroy((Canvas *)figure->canvas);
+  if (figure->has_dragger)
+    string_destroy(figure->dragger.locator.format);
+  if (figure->title != NULL)
+    string_destroy(figure->title);
+  if (figure->window_title != NULL)
+    string_destroy(figure->window_title);
+  string_destroy(figure->font_path);
+  ready_signal_destroy((ReadySignal *)figure->initialized);
+  publisher_destroy((Publisher *)figure->publisher);
+  pacer_destroy((Pacer *)figure->pacer);
+  arena_destroy((Arena *)figure->arena); // everything else
+}
+
 void show(Figure *figure) {
   if (processId) {
     RC_ERROR("OpenGL context cannot be re-initialized correctly. only one "
              "show() per process\n");
   }
+  if (figure->canvas != NULL) {
+    RC_ERROR("figure was rendered with '%s', it cannot be shown\n", RC_ECHO(figure_render));
+  }
   processId = getpid();
   RC_ASSERT(figure != NULL);
   raylib_init(figure);
@@ -329,17 +512,37 @@ void show(Figure *figure) {
   // trigger updates in the first loop
   figure->force_update = true;
   while (!WindowShouldClose()) {
+    if (!pacer_frame_due(figure)) {
+      pacer_idle(figure); // nothing to redraw, the last frame stays on screen
+      continue;
+    }
+    RC_PROFILE_BEGIN(PROFILE_PHASE_FRAME);
     raylib_init_loop();
     BeginDrawing();
     ClearBackground(figure->background_color);
     if (!update_figure(figure) && (RAYCANDLE_DEBUG)) {
       RC_INFO("figure size is too small, some data will not be visible\n");
     }
+    RC_PROFILE_BEGIN(PROFILE_PHASE_END_DRAWING);
     EndDrawing();
+    RC_PROFILE_END(PROFILE_PHASE_END_DRAWING);
+    RC_PROFILE_END(PROFILE_PHASE_FRAME);
+    profiler_frame_end();
+  }
+  publisher_stop(figure);
+  for (size_t i = 0; i < figure->axes_len; ++i) {
+    layers_unload((AxesLayers *)figure->axes[i].layers);
+    artists_unload(figure->axes + i);
   }
   CloseWindow();
 }
 
+void figure_set_min_refresh(Figure *figure, float seconds) {
+  RC_ASSERT(seconds >= 0, "min_refresh must not be negative\n");
+  __atomic_store(&figure->min_refresh, &seconds, __ATOMIC_RELAXED);
+  pacer_wake((Pacer *)figure->pacer); // a sleeping loop picks it up now
+}
+
 void figure_set_title(Figure *figure, char *title) {
   RC_ASSERT(title != NULL);
   if (figure->title != NULL) {
@@ -358,20 +561,23 @@ void set_dragger(Figure *figure, size_t len, size_t timeframe, double *xdata, Fo
     RC_ERROR("dragger.len is 0, no xdata?\n");
   }
   dragger.vlen = RC_INITIAL_VISIBLE_DATA < len ? RC_INITIAL_VISIBLE_DATA : len;
-  RC_ASSERT(dragger.vlen <= RC_MAX_PLOTTABLE_LEN);
+  dragger.slots = minl(dragger.vlen, RC_MAX_PLOTTABLE_LEN);
   dragger.ulen = RC_UPDATE_LEN > RC_INITIAL_VISIBLE_DATA ? RC_INITIAL_VISIBLE_DATA - RC_UPDATE_LEN : RC_UPDATE_LEN;
   if ((dragger.timeframe = timeframe) == 0) {
     RC_ERROR("spacing is  zero\n");
   }
   dragger.start = 0;
+  dragger.xmapping = X_MAPPING_INDEX;
+  dragger.slot_fill = 1;
   if (format == NULL && ftype != FORMATTER_NULL_FORMATTER) {
     RC_ERROR("'%s' is NULL but formatter '%s' is not '%s'\n", RC_ECHO(format), RC_ECHO(FormatterType), RC_ECHO(FORMATTER_NULL_FORMATTER));
   }
   dragger.locator.ftype = ftype;
   dragger.locator.format = string_create_from_format(0, NULL, "%s", format ? format : "[NULL]");
-  CM_MALLOC(dragger.xdata_shared,RC_MAX_PLOTTABLE_LEN * sizeof(double));
+  Arena *arena = (Arena *)figure->arena;
+  dragger.xdata_shared = arena_alloc(arena, RC_MAX_PLOTTABLE_LEN * sizeof(double));
   for (size_t i = 0; i < figure->axes_len; ++i) {
-    CM_MALLOC(figure->axes[i].xdata_buffer,RC_MAX_PLOTTABLE_LEN * sizeof(double));
+    figure->axes[i].xdata_buffer = arena_alloc(arena, RC_MAX_PLOTTABLE_LEN * sizeof(double));
   }
   RC_ASSERT((dragger.xdata = xdata) != NULL);
   figure->dragger = dragger;
@@ -388,6 +594,153 @@ void update_timeframe(Figure *figure, size_t timeframe) {
   figure->dragger.timeframe = timeframe;
 }
 
+static void figure_set_capacity(Figure *figure, size_t capacity) {
+  Dragger *dragger = &figure->dragger;
+  bool owned = dragger->capacity != 0;
+  Arena *arena = (Arena *)figure->arena;
+  double *xdata = arena_alloc(arena, sizeof(double) * capacity);
+  memcpy(xdata, dragger->xdata, sizeof(double) * dragger->_len);
+  if (owned)
+    arena_release(arena, dragger->xdata, sizeof(double) * dragger->capacity);
+  dragger->xdata = xdata;
+  for (size_t i = 0; i < figure->axes_len; ++i) {
+    Axes *axes = figure->axes + i;
+    for (size_t a = 0; a < axes->artist_len; ++a) {
+      Artist *artist = get_artist(axes, a);
+      if (artist->index != NULL)
+        artist_set_capacity(artist, capacity, owned);
+    }
+  }
+  dragger->capacity = capacity;
+}
+
+bool figure_append_rows(Figure *figure, const double *x, size_t len) {
+  Dragger *dragger = &figure->dragger;
+  for (size_t i = 0; i < len; ++i)
+    RC_ASSERT(x[i] > (i ? x[i - 1] : dragger->xdata[dragger->_len - 1]), "bars must be appended in time order\n");
+  size_t first = dragger->_len;
+  if (first + len > dragger->capacity || dragger->capacity == 0) {
+    figure_set_capacity(figure, maxl(maxl(first * 2, first + len), RC_APPEND_MIN_CAPACITY));
+  }
+  bool follow = dragger->start + dragger->vlen == dragger->_len;
+  memcpy(dragger->xdata + first, x, sizeof(double) * len);
+  dragger->_len += len;
+  for (size_t i = 0; i < figure->axes_len; ++i) {
+    Axes *axes = figure->axes + i;
+    for (size_t a = 0; a < axes->artist_len; ++a) {
+      Artist *artist = get_artist(axes, a);
+      if (artist->index == NULL)
+        continue;
+      for (size_t c = 0; c < artist->gdata.cols; ++c)
+        for (size_t row = first; row < dragger->_len; ++row)
+          artist->gdata.ydata[c * artist->gdata.stride + row] = NAN;
+      range_index_resize((RangeIndex *)artist->index, &artist->gdata, dragger->_len);
+    }
+  }
+  return follow;
+}
+
+void figure_reserve(Figure *figure, size_t rows) {
+  RC_ASSERT(figure->has_dragger, "call `set_dragger` first\n");
+  RC_ASSERT(figure->feed == NULL, "the feed decides when bars are copied\n");
+  RC_ASSERT(!publish_deferred(figure),
+            "'%s' must be called before `show` or from its thread\n",
+            RC_ECHO(figure_reserve));
+  resample_base_enter(figure);
+  Dragger *dragger = &figure->dragger;
+  if (rows > dragger->capacity || dragger->capacity == 0)
+    figure_set_capacity(figure, maxl(maxl(rows, dragger->_len),
+                                     RC_APPEND_MIN_CAPACITY));
+  resample_base_leave(figure, false);
+}
+
+void figure_own_data(Figure *figure) {
+  if (figure->feed != NULL || resample_base_capacity(figure) != 0)
+    return;
+  resample_base_enter(figure);
+  figure_set_capacity(figure, maxl(figure->dragger._len, RC_APPEND_MIN_CAPACITY));
+  resample_base_leave(figure, false);
+}
+
+void figure_append_bar(Figure *figure, double x) {
+  RC_ASSERT(figure->has_dragger, "call `set_dragger` first\n");
+  if (publish_append_bar(figure, x))
+    return;
+  if (resample_append_bar(figure, x))
+    return;
+  if (figure_append_rows(figure, &x, 1)) {
+    update_from_position(figure->dragger.start + 1, figure);
+  }
+}
+
+void figure_set_xdata(Figure *figure, double *xdata) {
+  RC_ASSERT(figure->has_dragger && xdata != NULL);
+  if (publish_set_xdata(figure, xdata))
+    return;
+  resample_base_enter(figure);
+  if (figure->dragger.capacity != 0) {
+    memcpy(figure->dragger.xdata, xdata, sizeof(double) * figure->dragger._len);
+  } else {
+    figure->dragger.xdata = xdata;
+  }
+  resample_base_leave(figure, true);
+}
+
+static Canvas *figure_canvas(Figure *figure) {
+  Canvas *canvas = (Canvas *)figure->canvas;
+  if (canvas != NULL && canvas->width == figure->width && canvas->height == figure->height)
+    return canvas;
+  Canvas *resized = canvas_create(figure->width, figure->height);
+  if (canvas != NULL) {
+    resized->font = canvas->font; // keep the loaded glyphs
+    resized->atlas = canvas->atlas;
+    canvas->font.glyphs = NULL;
+    canvas_destroy(canvas);
+  } else {
+    if (!canvas_load_font(resized, figure->font_path, figure->font_size))
+      RC_WARN("cannot load font '%s', text will not be rendered\n", figure->font_path);
+    figure->font = resized->font;
+  }
+  figure->canvas = resized;
+  return resized;
+}
+
+void figure_render(Figure *figure, uint8_t *pixels) {
+  RC_ASSERT(processId == 0, "cannot render while a window is open\n");
+  RC_ASSERT(figure->sds != SCREEN_DIMENSION_STATE_DEFAULT || figure->canvas == NULL);
+  RC_PROFILE_BEGIN(PROFILE_PHASE_FRAME);
+  Canvas *canvas = figure_canvas(figure);
+  canvas_begin(canvas);
+  if (figure->sds == SCREEN_DIMENSION_STATE_DEFAULT) { // what raylib_init does for show
+    figure->sds = SCREEN_DIMENSION_STATE_CHANGED;
+    axes_set_legend(figure);
+    figure->force_update = true;
+  }
+  canvas_clear(figure->background_color);
+  if (!update_figure(figure)) {
+    RC_WARN("figure size is too small, some data will not be rendered\n");
+  }
+  canvas_end();
+  RC_PROFILE_END(PROFILE_PHASE_FRAME);
+  profiler_frame_end();
+  if (pixels != NULL)
+    memcpy(pixels, canvas->pixels, sizeof(Color) * canvas->width * canvas->height);
+}
+
+bool figure_render_to_file(Figure *figure, char *path) {
+  RC_ASSERT(path != NULL);
+  figure_render(figure, NULL);
+  return canvas_export((Canvas *)figure->canvas, path);
+}
+
+void figure_set_size(Figure *figure, int width, int height) {
+  RC_ASSERT(width > 0 && height > 0);
+  RC_ASSERT(processId == 0, "the window decides the size while it is open\n");
+  figure->width = width;
+  figure->height = height;
+  figure->force_update = true;
+}
+
 void figure_wait_initialized(Figure *figure) { ready_signal_wait((ReadySignal *)figure->initialized); }
 
 void lib_free(void) { CM_FREE_ALL(); }
@@ -7,6 +7,25 @@ figure->dragger.xdata from `figure->dragger.start`
 */
 
 #define RAY_WINDOW_TITLE "Rc"
+#define RC_APPEND_MIN_CAPACITY 1024 // rows allocated by the first append
 void update_xlim(Figure *figure);
+/**
+writes the [start,end) data indexes that are drawn as slot `slot`. Slots at
+least RC_LOD_ALIGN range index blocks (or grains) wide start on a block (or a
+grain) but the first, so their min and max come from the nodes and grains of
+the RangeIndexes without reading rows. Their widths vary by at most
+1 / RC_LOD_ALIGN
+*/
+void dragger_slot_range(const Dragger *dragger, size_t slot, size_t range[2]);
+/**
+appends `len` bars at epochs `x` with NaN rows, see `figure_append_bar`, without
+moving the window. returns whether the window was showing the last bar
+*/
+bool figure_append_rows(Figure *figure, const double *x, size_t len);
+/**
+copies xdata and the data of every artist into buffers the figure owns, as the
+first append does, unless it owns them already or reads a feed
+*/
+void figure_own_data(Figure *figure);
 /* void figure_zoom(Figure* figure, int zoom); */
 void figure_wait_initialized(Figure *figure);
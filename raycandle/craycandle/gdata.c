@@ -0,0 +1,98 @@
+#include "gdata.h"
+
+#include <string.h>
+
+#include "utils.h"
+
+size_t gdata_item_size(DataType dtype) {
+  switch (dtype) {
+  case DATA_TYPE_FLOAT64:
+    return sizeof(double);
+  case DATA_TYPE_FLOAT32:
+    return sizeof(float);
+  case DATA_TYPE_INT64:
+    return sizeof(int64_t);
+  default:
+    RC_ERROR("unknown data type %d\n", dtype);
+  }
+  return 0;
+}
+
+void gdata_read(const Gdata *gdata, size_t col, size_t from, size_t len,
+                double *out) {
+  if (gdata->last != NULL) { // the rows around last_row as their layout says
+    Gdata rows = *gdata;
+    rows.last = NULL;
+    size_t last = gdata->last_row;
+    if (last < from || last >= from + len) {
+      gdata_read(&rows, col, from, len, out);
+      return;
+    }
+    gdata_read(&rows, col, from, last - from, out);
+    out[last - from] = gdata->last[col];
+    gdata_read(&rows, col, last + 1, from + len - last - 1, out + last - from + 1);
+    return;
+  }
+  if (gdata_is_native(gdata)) {
+    memcpy(out, gdata->ydata + col * gdata->stride + from,
+           sizeof(double) * len);
+    return;
+  }
+  size_t step = gdata->row_stride != 0 ? gdata->row_stride : 1;
+  size_t item = gdata_item(gdata, col, from);
+  switch (gdata->dtype) { // a loop per type, the switch is out of them
+  case DATA_TYPE_FLOAT32: {
+    const float *in = (const float *)gdata->ydata + item;
+    for (size_t i = 0; i < len; ++i)
+      out[i] = in[i * step];
+    return;
+  }
+  case DATA_TYPE_INT64: {
+    const int64_t *in = (const int64_t *)gdata->ydata + item;
+    for (size_t i = 0; i < len; ++i)
+      out[i] = in[i * step] == INT64_MIN ? NAN : (double)in[i * step];
+    return;
+  }
+  default: {
+    const double *in = gdata->ydata + item;
+    for (size_t i = 0; i < len; ++i)
+      out[i] = in[i * step];
+  }
+  }
+}
+
+Gdata gdata_column(const Gdata *gdata, size_t col) {
+  size_t first = gdata_item(gdata, col, 0);
+  return (Gdata){
+      .cols = 1,
+      .ydata = (double *)((char *)gdata->ydata +
+                          first * gdata_item_size(gdata->dtype)),
+      .stride = 0,
+      .dtype = gdata->dtype,
+      .row_stride = gdata->row_stride,
+      .last = gdata->last != NULL ? gdata->last + col : NULL,
+      .last_row = gdata->last_row,
+  };
+}
+
+void gdata_set_view(Gdata *gdata, const Gdata *view) {
+  RC_ASSERT(view->cols == gdata->cols && view->ydata != NULL,
+            "the view must have the %zu columns of the artist\n", gdata->cols);
+  gdata_item_size(view->dtype); // a known one
+  gdata->ydata = view->ydata;
+  gdata->stride = view->stride;
+  gdata->dtype = view->dtype;
+  gdata->row_stride = view->row_stride;
+  gdata->offsets = view->offsets;
+  gdata->last = view->last;
+  gdata->last_row = view->last_row;
+}
+
+void gdata_set_native(Gdata *gdata, double *ydata, size_t stride) {
+  gdata->ydata = ydata;
+  gdata->stride = stride;
+  gdata->dtype = DATA_TYPE_FLOAT64;
+  gdata->row_stride = 0;
+  gdata->offsets = NULL;
+  gdata->last = NULL;
+}
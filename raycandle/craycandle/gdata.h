@@ -0,0 +1,92 @@
+/*
+ * Gdata
+ * -----
+ * reads and writes the items of a Gdata whatever its layout (see Gdata in
+ * raycandle.h). Data the figure allocates is always native: float64 columns
+ * `stride` items apart, which the kernels read as plain arrays. Data handed to
+ * create_artist or artist_set_view may be any layout and is read in place;
+ * paths that need contiguous doubles (candle kernels, indicators) read a
+ * window of it into a scratch buffer with gdata_read, which is a memcpy for
+ * native data. A Gdata with a `last` row is not native: its other rows are
+ * read as their layout says and row last_row from `last`.
+ */
+#ifndef __RAYCANDLE_GDATA__
+#define __RAYCANDLE_GDATA__
+
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "raycandle.h"
+
+static inline bool gdata_is_native(const Gdata *gdata) {
+  return gdata->dtype == DATA_TYPE_FLOAT64 && gdata->row_stride <= 1 &&
+         gdata->offsets == NULL && gdata->last == NULL;
+}
+
+static inline size_t gdata_item(const Gdata *gdata, size_t col, size_t row) {
+  size_t first = gdata->offsets != NULL ? gdata->offsets[col]
+                                        : col * gdata->stride;
+  return first + row * (gdata->row_stride != 0 ? gdata->row_stride : 1);
+}
+
+static inline double gdata_get(const Gdata *gdata, size_t col, size_t row) {
+  if (gdata->last != NULL && row == gdata->last_row)
+    return gdata->last[col];
+  size_t item = gdata_item(gdata, col, row);
+  switch (gdata->dtype) {
+  case DATA_TYPE_FLOAT32:
+    return ((const float *)gdata->ydata)[item];
+  case DATA_TYPE_INT64: {
+    int64_t value = ((const int64_t *)gdata->ydata)[item];
+    return value == INT64_MIN ? NAN : (double)value;
+  }
+  default:
+    return gdata->ydata[item];
+  }
+}
+
+static inline void gdata_set(Gdata *gdata, size_t col, size_t row,
+                             double value) {
+  if (gdata->last != NULL && row == gdata->last_row) {
+    gdata->last[col] = value;
+    return;
+  }
+  size_t item = gdata_item(gdata, col, row);
+  switch (gdata->dtype) {
+  case DATA_TYPE_FLOAT32:
+    ((float *)gdata->ydata)[item] = (float)value;
+    return;
+  case DATA_TYPE_INT64:
+    ((int64_t *)gdata->ydata)[item] =
+        isnan(value) ? INT64_MIN : (int64_t)llround(value);
+    return;
+  default:
+    gdata->ydata[item] = value;
+  }
+}
+
+/**
+bytes of an item of `dtype`
+*/
+size_t gdata_item_size(DataType dtype);
+/**
+copies rows [from, from + len) of column `col` to `out` as doubles
+*/
+void gdata_read(const Gdata *gdata, size_t col, size_t from, size_t len,
+                double *out);
+/**
+column `col` of `gdata` as a Gdata of 1 column, in place
+*/
+Gdata gdata_column(const Gdata *gdata, size_t col);
+/**
+the layout fields of `view`, which replaces the data of `gdata` in place
+*/
+void gdata_set_view(Gdata *gdata, const Gdata *view);
+/**
+back to native float64 columns `stride` items apart, at `ydata`
+*/
+void gdata_set_native(Gdata *gdata, double *ydata, size_t stride);
+
+#endif //__RAYCANDLE_GDATA__
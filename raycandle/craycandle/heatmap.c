@@ -0,0 +1,233 @@
+#include "heatmap.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "arena.h"
+#include "canvas.h"
+#include "figure.h"
+#include "gdata.h"
+#include "layers.h"
+#include "range_index.h"
+#include "utils.h"
+
+static void heatmap_reserve(Artist *artist, size_t slots);
+static void heatmap_rescale(Artist *artist);
+static void heatmap_shade(Artist *artist, size_t key);
+static void heatmap_upload(HeatmapPixels *heatmap);
+
+static inline Color heatmap_color(const Artist *artist, double intensity) {
+  if (isnan(intensity))
+    return (Color){0, 0, 0, 0};
+  double scale = ((HeatmapPixels *)artist->data)->scale;
+  double t = scale > 0 ? fmin(fmax(intensity / scale, 0), 1) : 1;
+  Color low = artist->color[0], high = artist->color[1];
+  return (Color){low.r + (high.r - low.r) * t, low.g + (high.g - low.g) * t,
+                 low.b + (high.b - low.b) * t, low.a + (high.a - low.a) * t};
+}
+
+static void heatmap_reserve(Artist *artist, size_t slots) {
+  HeatmapPixels *heatmap = (HeatmapPixels *)artist->data;
+  size_t columns = RC_HEATMAP_MIN_COLUMNS;
+  while (columns < slots)
+    columns *= 2;
+  if (columns <= heatmap->columns)
+    return;
+  Arena *arena = (Arena *)artist->parent->parent->arena;
+  size_t texels = heatmap->columns * heatmap->levels;
+  heatmap->texels =
+      arena_resize(arena, heatmap->texels, sizeof(Color) * texels,
+                   sizeof(Color) * columns * heatmap->levels);
+  heatmap->staging =
+      arena_resize(arena, heatmap->staging, sizeof(Color) * texels,
+                   sizeof(Color) * columns * heatmap->levels);
+  heatmap->dirty =
+      arena_resize(arena, heatmap->dirty, heatmap->columns, columns);
+  heatmap->columns = columns;
+  heatmap->keys = 0; // the keys moved to other columns
+  heatmap->reload = true;
+}
+
+static void heatmap_rescale(Artist *artist) {
+  HeatmapPixels *heatmap = (HeatmapPixels *)artist->data;
+  if (heatmap->config.intensity_max > 0) {
+    heatmap->scale = heatmap->config.intensity_max;
+    return;
+  }
+  double minmax[2];
+  range_index_query(artist->index, &artist->gdata, 0,
+                    artist->parent->parent->dragger._len, minmax);
+  heatmap->scale = minmax[1]; // NaN (nothing yet) shades anything as color[1]
+}
+
+static void heatmap_shade(Artist *artist, size_t key) {
+  HeatmapPixels *heatmap = (HeatmapPixels *)artist->data;
+  size_t row = key, range[2];
+  if (!heatmap->by_row) { // the last snapshot of the slot
+    dragger_slot_range(&artist->parent->parent->dragger, key, range);
+    row = range[1] - 1;
+  }
+  size_t column = key & (heatmap->columns - 1);
+  Color *texel = heatmap->texels + column;
+  for (size_t level = heatmap->levels; level-- > 0;
+       texel += heatmap->columns) // the top row is the top level
+    *texel = heatmap_color(artist, gdata_get(&artist->gdata, level, row));
+  heatmap->dirty[column] = 1;
+}
+
+static void heatmap_upload(HeatmapPixels *heatmap) {
+  size_t columns = heatmap->columns, levels = heatmap->levels;
+  if (heatmap->reload || !heatmap->loaded) {
+    if (heatmap->loaded)
+      UnloadTexture(heatmap->texture);
+    heatmap->texture =
+        LoadTextureFromImage((Image){.data = heatmap->texels,
+                                     .width = columns,
+                                     .height = levels,
+                                     .mipmaps = 1,
+                                     .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8});
+    heatmap->loaded = true;
+    heatmap->reload = false;
+    memset(heatmap->dirty, 0, columns);
+    return;
+  }
+  for (size_t first = 0, end; first < columns; first = end) {
+    if (!heatmap->dirty[first]) {
+      end = first + 1;
+      continue;
+    }
+    for (end = first; end < columns && heatmap->dirty[end]; ++end)
+      heatmap->dirty[end] = 0;
+    size_t width = end - first; // packed, UpdateTextureRec has no row stride
+    for (size_t level = 0; level < levels; ++level)
+      memcpy(heatmap->staging + level * width,
+             heatmap->texels + level * columns + first, sizeof(Color) * width);
+    UpdateTextureRec(heatmap->texture,
+                     (Rectangle){first, 0, width, levels}, heatmap->staging);
+  }
+}
+
+void heatmap_init(Artist *artist, void *config) {
+  HeatmapData *heatmap_data = (HeatmapData *)config;
+  RC_ASSERT(heatmap_data != NULL && heatmap_data->price_step > 0,
+            "a heatmap needs a HeatmapData with a positive price_step\n");
+  Arena *arena = (Arena *)artist->parent->parent->arena;
+  HeatmapPixels *heatmap = arena_alloc(arena, sizeof(HeatmapPixels));
+  *heatmap = (HeatmapPixels){.config = *heatmap_data,
+                             .levels = artist->gdata.cols,
+                             .columns = 0}; // see heatmap_reserve
+  artist->data = (void *)heatmap;
+  artist->ylim_consider = false; // prices set the ylims, not the whole book
+  Color *color = arena_alloc(arena, sizeof(Color) * 2);
+  if (artist->color == NULL) { // fades in from transparent
+    color[1] = axes_get_next_tableau_t10_color(artist->parent);
+    color[0] = (Color){color[1].r, color[1].g, color[1].b, 0};
+  } else {
+    memcpy(color, artist->color, sizeof(Color) * 2);
+  }
+  artist->color = color;
+}
+
+void heatmap_update_data_buffer(Artist *artist, LimitChanged lim) {
+  Axes *axes = artist->parent;
+  Dragger *dragger = &axes->parent->dragger;
+  HeatmapPixels *heatmap = (HeatmapPixels *)artist->data;
+  HeatmapData *config = &heatmap->config;
+  heatmap->top = RC_DATA_Y_2_PIXEL(
+      config->price_min + config->price_step * heatmap->levels, axes);
+  heatmap->bottom = RC_DATA_Y_2_PIXEL(config->price_min, axes);
+  if (lim == LIMIT_CHANGED_YLIM || artist->index == NULL)
+    return; // the texels do not depend on the ylims
+  heatmap_reserve(artist, dragger->slots);
+  bool by_row = dragger->slots == dragger->vlen;
+  if (artist->gdata.ydata != heatmap->source || by_row != heatmap->by_row ||
+      !by_row) // other data, or slots that moved
+    heatmap->keys = 0;
+  heatmap->source = artist->gdata.ydata;
+  heatmap->by_row = by_row;
+  if (!(heatmap->scale > 0))
+    heatmap_rescale(artist);
+  size_t first = by_row ? dragger->start : 0;
+  for (size_t key = first; key < first + dragger->slots; ++key) {
+    if (key < heatmap->first_key || key >= heatmap->first_key + heatmap->keys)
+      heatmap_shade(artist, key); // entered the window
+  }
+  heatmap->first_key = first;
+  heatmap->keys = dragger->slots;
+}
+
+void heatmap_last_changed(Artist *artist) {
+  HeatmapPixels *heatmap = (HeatmapPixels *)artist->data;
+  Dragger *dragger = &artist->parent->parent->dragger;
+  size_t row = dragger->_len - 1;
+  if (heatmap->config.intensity_max <= 0) {
+    double max = NAN;
+    for (size_t level = 0; level < heatmap->levels; ++level)
+      max = fmax(max, gdata_get(&artist->gdata, level, row));
+    if (max > heatmap->scale) { // reshade what is on screen at the new scale
+      heatmap->scale = max;
+      heatmap->keys = 0;
+      heatmap_update_data_buffer(artist, LIMIT_CHANGED_ALL_LIM);
+      return;
+    }
+  }
+  size_t key = heatmap->by_row ? row : dragger->slots - 1;
+  if (key >= heatmap->first_key && key < heatmap->first_key + heatmap->keys)
+    heatmap_shade(artist, key);
+}
+
+void heatmap_data_replaced(Artist *artist) {
+  if (artist->artist_type != ARTIST_TYPE_HEATMAP)
+    return;
+  HeatmapPixels *heatmap = (HeatmapPixels *)artist->data;
+  heatmap->keys = 0;
+  heatmap->scale = 0; // see heatmap_rescale
+  if (artist->parent->width != 0) // shown at once, not blank until a redraw
+    heatmap_update_data_buffer(artist, LIMIT_CHANGED_ALL_LIM);
+}
+
+void heatmap_plot(Artist *artist) {
+  Axes *axes = artist->parent;
+  Dragger *dragger = &axes->parent->dragger;
+  HeatmapPixels *heatmap = (HeatmapPixels *)artist->data;
+  if (heatmap->keys == 0)
+    return;
+  if (canvas_active() == NULL)
+    heatmap_upload(heatmap);
+  Texture2D texture = heatmap->texture;
+  texture.width = heatmap->columns; // what a canvas reads texels with
+  Rectangle plot = {axes->startX, axes->startY, axes->width, axes->height};
+  canvas_begin_clip(layer_clip(&((AxesLayers *)axes->layers)->data, plot));
+  const double *x = axes->xdata_buffer;
+  double swidth = axes->width * dragger->slot_fill / dragger->slots;
+  size_t mask = heatmap->columns - 1;
+  // a quad per run of adjacent slots held in adjacent columns
+  for (size_t first = 0, slot = 1; slot <= dragger->slots; ++slot) {
+    if (slot < dragger->slots &&
+        ((heatmap->first_key + slot) & mask) != 0 &&
+        fabs(x[slot] - x[slot - 1] - swidth) < 0.5)
+      continue;
+    Rectangle source = {(heatmap->first_key + first) & mask, 0, slot - first,
+                        heatmap->levels};
+    Rectangle dest = {x[first], heatmap->top,
+                      x[slot - 1] + swidth - x[first],
+                      heatmap->bottom - heatmap->top};
+    canvas_draw_texture_pro(texture, heatmap->texels, source, dest, WHITE);
+    first = slot;
+  }
+  canvas_end_clip();
+}
+
+void heatmap_ylim(Artist *artist, double minmax[2]) {
+  HeatmapPixels *heatmap = (HeatmapPixels *)artist->data;
+  minmax[0] = heatmap->config.price_min;
+  minmax[1] = heatmap->config.price_min +
+              heatmap->config.price_step * heatmap->levels;
+}
+
+void heatmap_unload(Artist *artist) {
+  HeatmapPixels *heatmap = (HeatmapPixels *)artist->data;
+  if (heatmap->loaded)
+    UnloadTexture(heatmap->texture);
+  heatmap->loaded = false;
+}
@@ -0,0 +1,61 @@
+/*
+ * Heatmap
+ * -------
+ * ARTIST_TYPE_HEATMAP: a time x price grid drawn as one texture per artist, a
+ * texel per (slot, price level). The texture is a ring of columns keyed by
+ * data row (by slot when slots are decimated): when the window scrolls only
+ * the rows entering it are shaded and uploaded with UpdateTextureRec, and a
+ * new last bar costs one column, O(price levels) whatever the history.
+ * Price levels are evenly spaced so mapping them to y pixels is the
+ * destination rectangle of the draw: ylim changes touch no texel.
+ *
+ * Columns are shaded on the CPU into `texels`, the image of the texture, when
+ * the data buffers are updated (possibly on the pool) and uploaded on the
+ * render thread when the artist is drawn. A canvas draws from `texels`.
+ */
+#ifndef __RAYCANDLE_HEATMAP__
+#define __RAYCANDLE_HEATMAP__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "locator.h"
+#include "raycandle.h"
+#include "raylib.h"
+
+#define RC_HEATMAP_MIN_COLUMNS 64 // ring width, a power of 2 >= the slots
+
+typedef struct {
+  HeatmapData config;
+  double scale;  // intensity shaded as color[1]
+  Color *texels; // columns x levels, row major, the top row is the top level
+  Color *staging; // a packed rectangle of columns for UpdateTextureRec
+  uint8_t *dirty; // per column, shaded since the last upload
+  size_t columns, levels;
+  size_t first_key, keys; // held in the ring, key k in column k % columns
+  bool by_row;            // keys are rows (a bar per slot) or slots
+  const double *source;   // gdata.ydata the columns were shaded from
+  float top, bottom;      // y pixels of the grid edges
+  Texture2D texture;
+  bool loaded, reload; // reload: the texture size changed
+} HeatmapPixels;
+
+void heatmap_init(Artist *artist, void *config);
+void heatmap_update_data_buffer(Artist *artist, LimitChanged lim);
+/**
+reshades the column of the last row, see `artist_last_changed`
+*/
+void heatmap_last_changed(Artist *artist);
+/**
+the data of `artist` was replaced: the columns on screen are reshaded
+*/
+void heatmap_data_replaced(Artist *artist);
+void heatmap_plot(Artist *artist);
+void heatmap_ylim(Artist *artist, double minmax[2]); // its price levels
+/**
+unloads the texture, must be called before CloseWindow
+*/
+void heatmap_unload(Artist *artist);
+
+#endif //__RAYCANDLE_HEATMAP__
@@ -0,0 +1,548 @@
+#include "indicator.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "artist.h"
+#include "figure.h"
+#include "gdata.h"
+#include "publish.h"
+#include "resample.h"
+#include "utils.h"
+
+#define RC_INDICATOR_CHUNK 256 // rows transformed per pass, on the stack
+
+static void indicator_init(Indicator *indicator, Arena *arena,
+                           IndicatorType type, const size_t params[3]);
+static void indicator_reset(Indicator *indicator);
+static void indicator_release(Indicator *indicator);
+static void indicator_advance(Indicator *indicator, const Gdata hlc[3],
+                              size_t len, double *const history[],
+                              double last[RC_INDICATOR_OUTPUTS]);
+static void indicator_recompute(Indicator *indicator);
+static void indicator_reserve(Indicator *indicator, size_t len);
+static void indicator_write_rows(Indicator *indicator, size_t from, size_t to);
+
+static const size_t outputs_len[INDICATOR_TYPE_LEN] = {
+    [INDICATOR_TYPE_SMA] = 1,       [INDICATOR_TYPE_EMA] = 1,
+    [INDICATOR_TYPE_RSI] = 1,       [INDICATOR_TYPE_BOLLINGER] = 3,
+    [INDICATOR_TYPE_STOCH] = 2,     [INDICATOR_TYPE_ADX] = 3,
+    [INDICATOR_TYPE_ATR] = 1,
+};
+
+// the indicators that read high and low, not only the close
+static inline bool indicator_needs_hl(IndicatorType type) {
+  return type == INDICATOR_TYPE_STOCH || type == INDICATOR_TYPE_ADX ||
+         type == INDICATOR_TYPE_ATR;
+}
+
+/**
+fmax without a branch: b if a is NaN, like pandas skipping NaN in a row max
+*/
+static inline double indicator_fmax(double a, double b) {
+  return a > b || b != b ? a : b;
+}
+
+static inline double indicator_true_range(double high, double low,
+                                          double prev_close) {
+  return indicator_fmax(
+      high - low, indicator_fmax(fabs(high - prev_close),
+                                 fabs(low - prev_close)));
+}
+
+/**
+writes the per bar inputs of `len` rows of the recurrences to in[k][i]: the
+close for SMA, EMA and Bollinger, gains and losses for RSI, high, low and close
+for Stoch, the true range and the directional moves for ATR and ADX. Row i is
+hlc[k][i + 1], hlc[k][0] being the bar before (NaN before the first bar, which
+every formula then handles like pandas). The loops have no branches and read
+contiguous columns
+*/
+static void indicator_prepare(IndicatorType type, const double *const hlc[3],
+                              size_t len,
+                              double *const in[RC_INDICATOR_INPUTS]) {
+  const double *high = hlc[0], *low = hlc[1], *close = hlc[2];
+  double *a = in[0], *b = in[1], *c = in[2];
+  switch (type) {
+  case INDICATOR_TYPE_RSI:
+    for (size_t i = 0; i < len; ++i) {
+      double diff = close[i + 1] - close[i];
+      a[i] = diff > 0 ? diff : diff * 0; // NaN stays NaN
+      b[i] = diff < 0 ? -diff : diff * 0;
+    }
+    return;
+  case INDICATOR_TYPE_STOCH:
+    for (size_t i = 0; i < len; ++i) {
+      a[i] = high[i + 1], b[i] = low[i + 1], c[i] = close[i + 1];
+    }
+    return;
+  case INDICATOR_TYPE_ATR:
+    for (size_t i = 0; i < len; ++i)
+      a[i] = indicator_true_range(high[i + 1], low[i + 1], close[i]);
+    return;
+  case INDICATOR_TYPE_ADX:
+    for (size_t i = 0; i < len; ++i) {
+      double up = high[i + 1] - high[i], down = low[i] - low[i + 1];
+      a[i] = indicator_true_range(high[i + 1], low[i + 1], close[i]);
+      b[i] = up > down && up > 0 ? up : 0; // NaN moves compare false
+      c[i] = down > up && down > 0 ? down : 0;
+    }
+    return;
+  default:
+    memcpy(a, close + 1, sizeof(double) * len);
+  }
+}
+
+static inline void window_add(IndicatorWindow *w, double x) {
+  double t = w->sum + x; // Neumaier: what t lost is kept in compensation
+  w->compensation +=
+      fabs(w->sum) >= fabs(x) ? (w->sum - t) + x : (x - t) + w->sum;
+  w->sum = t;
+  double delta = x - w->mean;
+  w->mean += delta / ++w->count;
+  w->m2 += delta * (x - w->mean);
+}
+
+static inline void window_remove(IndicatorWindow *w, double x) {
+  if (w->count == 1) {
+    w->count = 0;
+    w->sum = w->compensation = w->mean = w->m2 = 0;
+    return;
+  }
+  double t = w->sum - x;
+  w->compensation +=
+      fabs(w->sum) >= fabs(x) ? (w->sum - t) - x : (-x - t) + w->sum;
+  w->sum = t;
+  double delta = x - w->mean;
+  w->mean -= delta / --w->count;
+  w->m2 = fmax(w->m2 - delta * (x - w->mean), 0);
+}
+
+/**
+the window after adding the input of `row`, stored if `commit`
+*/
+static IndicatorWindow window_step(IndicatorWindow *w, size_t row, double x,
+                                   bool commit) {
+  size_t slot = row % w->window;
+  IndicatorWindow next = *w;
+  if (!isnan(w->ring[slot]))
+    window_remove(&next, w->ring[slot]);
+  if (!isnan(x))
+    window_add(&next, x);
+  if (commit) {
+    *w = next;
+    w->ring[slot] = x;
+  }
+  return next;
+}
+
+static inline double window_mean(const IndicatorWindow *w) {
+  return w->count >= w->window ? (w->sum + w->compensation) / w->count : NAN;
+}
+
+static inline double window_std(const IndicatorWindow *w) { // ddof=1
+  return w->count >= w->window && w->count > 1
+             ? sqrt(w->m2 / (w->count - 1))
+             : NAN;
+}
+
+static inline bool extreme_better(const IndicatorExtreme *e, double a,
+                                  double b) {
+  return e->max ? a >= b : a <= b;
+}
+
+/**
+max (min) of the window ending at `row`, NaN unless it has `window` non NaN
+values. Only the oldest entry of the deque can have left the window since
+the last commit
+*/
+static double extreme_step(IndicatorExtreme *e, size_t row, double x,
+                           bool commit) {
+  size_t slot = row % e->window;
+  size_t count = e->count - !isnan(e->ring[slot]) + !isnan(x);
+  size_t expired = e->len > 0 && e->deque[e->head] + e->window <= row;
+  double best = x;
+  if (expired < e->len) {
+    double v = e->ring[e->deque[(e->head + expired) % e->window] % e->window];
+    best = isnan(x) || extreme_better(e, v, x) ? v : x;
+  }
+  if (commit) {
+    e->head = (e->head + expired) % e->window;
+    e->len -= expired;
+    while (!isnan(x) && e->len > 0 &&
+           extreme_better(e, x,
+                          e->ring[e->deque[(e->head + e->len - 1) % e->window] %
+                                  e->window]))
+      e->len -= 1;
+    if (!isnan(x))
+      e->deque[(e->head + e->len++) % e->window] = row;
+    e->ring[slot] = x;
+    e->count = count;
+  }
+  return count >= e->window ? best : NAN;
+}
+
+/**
+pandas' ewma with ignore_na=False: every bar decays the old weights
+*/
+static IndicatorEwm ewm_step(IndicatorEwm *e, double x, bool commit) {
+  IndicatorEwm next = *e;
+  bool observed = !isnan(x);
+  if (!isnan(next.weighted)) {
+    next.old_wt *= next.factor;
+    if (observed) {
+      if (next.weighted != x)
+        next.weighted = (next.old_wt * next.weighted + next.new_wt * x) /
+                        (next.old_wt + next.new_wt);
+      next.old_wt = next.adjust ? next.old_wt + next.new_wt : 1;
+    }
+  } else if (observed) {
+    next.weighted = x;
+  }
+  if (commit)
+    *e = next;
+  return next;
+}
+
+static void indicator_step(Indicator *indicator, size_t row,
+                           const double in[RC_INDICATOR_INPUTS], bool commit,
+                           double out[RC_INDICATOR_OUTPUTS]) {
+  IndicatorWindow *windows = indicator->windows;
+  IndicatorEwm *ewms = indicator->ewms;
+  switch (indicator->type) {
+  case INDICATOR_TYPE_SMA: {
+    IndicatorWindow w = window_step(windows, row, in[0], commit);
+    out[0] = window_mean(&w);
+    return;
+  }
+  case INDICATOR_TYPE_EMA:
+  case INDICATOR_TYPE_ATR:
+    out[0] = ewm_step(ewms, in[0], commit).weighted;
+    return;
+  case INDICATOR_TYPE_RSI: {
+    IndicatorWindow up = window_step(windows, row, in[0], commit);
+    IndicatorWindow down = window_step(windows + 1, row, in[1], commit);
+    out[0] = 100 - 100 / (1 + window_mean(&up) / window_mean(&down));
+    return;
+  }
+  case INDICATOR_TYPE_BOLLINGER: {
+    IndicatorWindow w = window_step(windows, row, in[0], commit);
+    double mean = window_mean(&w), std = window_std(&w);
+    out[0] = mean + 2 * std;
+    out[1] = mean;
+    out[2] = mean - 2 * std;
+    return;
+  }
+  case INDICATOR_TYPE_STOCH: {
+    double high = extreme_step(indicator->extremes, row, in[0], commit);
+    double low = extreme_step(indicator->extremes + 1, row, in[1], commit);
+    IndicatorWindow k =
+        window_step(windows, row, (in[2] - low) / (high - low) * 100, commit);
+    out[0] = window_mean(&k);
+    IndicatorWindow d = window_step(windows + 1, row, out[0], commit);
+    out[1] = window_mean(&d);
+    return;
+  }
+  case INDICATOR_TYPE_ADX: {
+    double atr = ewm_step(ewms, in[0], commit).weighted;
+    double positive = ewm_step(ewms + 1, in[1], commit).weighted / atr * 100;
+    double negative = ewm_step(ewms + 2, in[2], commit).weighted / atr * 100;
+    double dx = fabs(positive - negative) / (positive + negative) * 100;
+    out[0] = positive;
+    out[1] = negative;
+    out[2] = ewm_step(ewms + 3, dx, commit).weighted;
+    return;
+  }
+  default:
+    RC_ERROR("unknown indicator type %d\n", indicator->type);
+  }
+}
+
+static void indicator_window_init(IndicatorWindow *w, Arena *arena,
+                                  size_t window) {
+  RC_ASSERT(window > 0, "indicator windows must not be empty\n");
+  *w = (IndicatorWindow){.window = window};
+  w->ring = arena_alloc(arena, sizeof(double) * window);
+}
+
+static void indicator_extreme_init(IndicatorExtreme *e, Arena *arena,
+                                   size_t window, bool max) {
+  RC_ASSERT(window > 0, "indicator windows must not be empty\n");
+  *e = (IndicatorExtreme){.window = window, .max = max};
+  e->ring = arena_alloc(arena, sizeof(double) * window);
+  e->deque = arena_alloc(arena, sizeof(size_t) * window);
+}
+
+// pandas ewm(alpha=alpha, adjust=adjust)
+static inline IndicatorEwm indicator_ewm(double alpha, bool adjust) {
+  return (IndicatorEwm){.factor = 1 - alpha,
+                        .new_wt = adjust ? 1 : alpha,
+                        .adjust = adjust};
+}
+
+static void indicator_init(Indicator *indicator, Arena *arena,
+                           IndicatorType type, const size_t params[3]) {
+  RC_ASSERT((unsigned)type < INDICATOR_TYPE_LEN,
+            "indicator type %d has not been implemented\n", type);
+  *indicator = (Indicator){.type = type, .arena = arena};
+  memcpy(indicator->params, params, sizeof(indicator->params));
+  size_t window = params[0];
+  RC_ASSERT(window > 0, "indicator windows must not be empty\n");
+  switch (type) {
+  case INDICATOR_TYPE_SMA:
+  case INDICATOR_TYPE_BOLLINGER:
+    indicator_window_init(indicator->windows, arena, window);
+    break;
+  case INDICATOR_TYPE_EMA: // span
+    indicator->ewms[0] = indicator_ewm(2.0 / (window + 1), true);
+    break;
+  case INDICATOR_TYPE_RSI:
+    indicator_window_init(indicator->windows, arena, window);
+    indicator_window_init(indicator->windows + 1, arena, window);
+    break;
+  case INDICATOR_TYPE_STOCH: // k, d, m
+    indicator_extreme_init(indicator->extremes, arena, window, true);
+    indicator_extreme_init(indicator->extremes + 1, arena, window, false);
+    indicator_window_init(indicator->windows, arena, params[2]);
+    indicator_window_init(indicator->windows + 1, arena, params[1]);
+    break;
+  case INDICATOR_TYPE_ATR: // cmnfunc.avg_tr passes the window as com
+    indicator->ewms[0] = indicator_ewm(1.0 / (1 + window), false);
+    break;
+  case INDICATOR_TYPE_ADX:
+    indicator->ewms[0] = indicator_ewm(1.0 / (1 + window), false);
+    for (size_t i = 1; i < 4; ++i)
+      indicator->ewms[i] = indicator_ewm(1.0 / window, false);
+    break;
+  default:
+    break;
+  }
+  indicator->outputs_len = outputs_len[type];
+  indicator_reset(indicator);
+}
+
+static void indicator_reset(Indicator *indicator) {
+  for (size_t i = 0; i < 2; ++i) {
+    IndicatorWindow *w = indicator->windows + i;
+    for (size_t r = 0; w->ring != NULL && r < w->window; ++r)
+      w->ring[r] = NAN;
+    w->count = 0;
+    w->sum = w->compensation = w->mean = w->m2 = 0;
+    IndicatorExtreme *e = indicator->extremes + i;
+    for (size_t r = 0; e->ring != NULL && r < e->window; ++r)
+      e->ring[r] = NAN;
+    e->head = e->len = e->count = 0;
+  }
+  for (size_t i = 0; i < 4; ++i) {
+    indicator->ewms[i].weighted = NAN;
+    indicator->ewms[i].old_wt = 1;
+  }
+  indicator->rows = 0;
+}
+
+static void indicator_release(Indicator *indicator) {
+  Arena *arena = indicator->arena;
+  for (size_t i = 0; i < 2; ++i) {
+    IndicatorWindow *w = indicator->windows + i;
+    arena_release(arena, w->ring, sizeof(double) * w->window);
+    IndicatorExtreme *e = indicator->extremes + i;
+    arena_release(arena, e->ring, sizeof(double) * e->window);
+    arena_release(arena, e->deque, sizeof(size_t) * e->window);
+  }
+}
+
+/**
+steps the rows [indicator->rows, len - 1) into the state and the last one on
+a copy of it, whose outputs go to `last`. Outputs of every row go to
+history[o][row] too if `history` is not NULL
+*/
+static void indicator_advance(Indicator *indicator, const Gdata hlc[3],
+                              size_t len, double *const history[],
+                              double last[RC_INDICATOR_OUTPUTS]) {
+  RC_ASSERT(len > indicator->rows);
+  double rows[3][RC_INDICATOR_CHUNK + 1]; // the bar before and the chunk
+  double scratch[RC_INDICATOR_INPUTS][RC_INDICATOR_CHUNK];
+  double *in[RC_INDICATOR_INPUTS] = {scratch[0], scratch[1], scratch[2]};
+  const double *columns[3] = {rows[0], rows[1], rows[2]};
+  for (size_t from = indicator->rows; from < len; from += RC_INDICATOR_CHUNK) {
+    size_t to = minl(from + RC_INDICATOR_CHUNK, len);
+    for (size_t k = 0; k < 3; ++k) { // as doubles, whatever the layout
+      if (hlc[k].ydata == NULL)
+        continue; // close only, not read
+      rows[k][0] = NAN;
+      size_t first = from > 0 ? from - 1 : 0;
+      gdata_read(hlc + k, 0, first, to - first, rows[k] + (from == 0));
+    }
+    indicator_prepare(indicator->type, columns, to - from, in);
+    for (size_t row = from; row < to; ++row) {
+      double values[RC_INDICATOR_INPUTS] = {
+          in[0][row - from], in[1][row - from], in[2][row - from]};
+      indicator_step(indicator, row, values, row + 1 < len, last);
+      for (size_t o = 0; history != NULL && o < indicator->outputs_len; ++o)
+        history[o][row] = last[o];
+    }
+  }
+  indicator->rows = len - 1;
+}
+
+/**
+the high, low and close columns of the base rows of `source`
+*/
+static void indicator_source_columns(Artist *source, Gdata hlc[3]) {
+  const Gdata *gdata = resample_artist_base(source);
+  hlc[0] = hlc[1] = (Gdata){.cols = 1, .ydata = NULL};
+  hlc[2] = gdata_column(gdata, gdata->cols - 1);
+  if (gdata->cols == 4) {
+    hlc[0] = gdata_column(gdata, 1);
+    hlc[1] = gdata_column(gdata, 2);
+  }
+}
+
+/**
+the whole history of the source, written to the buffers then handed to the
+outputs with artist_set_data
+*/
+static void indicator_recompute(Indicator *indicator) {
+  Figure *figure = indicator->source->parent->parent;
+  size_t len = resample_base_len(figure);
+  indicator_reserve(indicator, len);
+  Gdata hlc[3];
+  double last[RC_INDICATOR_OUTPUTS];
+  indicator_source_columns(indicator->source, hlc);
+  indicator_reset(indicator);
+  indicator_advance(indicator, hlc, len, indicator->buffers, last);
+  for (size_t o = 0; o < indicator->outputs_len; ++o)
+    artist_set_data(indicator->outputs[o], indicator->buffers[o]);
+}
+
+/**
+grows the buffers to `len` rows at least, doubling so that appends stay O(1)
+*/
+static void indicator_reserve(Indicator *indicator, size_t len) {
+  if (len <= indicator->buffers_len)
+    return;
+  size_t capacity = maxl(len, indicator->buffers_len * 2);
+  for (size_t o = 0; o < indicator->outputs_len; ++o)
+    indicator->buffers[o] = arena_resize(
+        indicator->arena, indicator->buffers[o],
+        sizeof(double) * indicator->buffers_len, sizeof(double) * capacity);
+  indicator->buffers_len = capacity;
+}
+
+/**
+hands rows [from, to) of the buffers to the base rows of the outputs. These
+are rows appended since the last update, which artist_update_last does not
+reach; the levels aggregate them again and the window is redrawn
+*/
+static void indicator_write_rows(Indicator *indicator, size_t from, size_t to) {
+  Figure *figure = indicator->source->parent->parent;
+  resample_base_enter(figure);
+  for (size_t o = 0; o < indicator->outputs_len; ++o) {
+    Artist *output = indicator->outputs[o];
+    for (size_t row = from; row < to; ++row)
+      gdata_set(&output->gdata, 0, row, indicator->buffers[o][row]);
+    for (size_t row = from; row < to;
+         row = (row / RC_RANGE_INDEX_BLOCK + 1) * RC_RANGE_INDEX_BLOCK)
+      range_index_update(output->index, &output->gdata, row);
+  }
+  resample_base_rewritten(figure, from);
+  resample_base_leave(figure, false);
+  update_from_position(figure->dragger.start, figure);
+}
+
+Indicators *indicators_create(Arena *arena) {
+  Indicators *indicators = arena_alloc(arena, sizeof(Indicators));
+  *indicators = (Indicators){.items = NULL, .arena = arena};
+  return indicators;
+}
+
+void indicators_source_updated(Artist *source) {
+  Figure *figure = source->parent->parent;
+  Indicators *indicators = (Indicators *)figure->indicators;
+  size_t len = resample_base_len(figure);
+  for (size_t i = 0; i < indicators->len; ++i) {
+    Indicator *indicator = indicators->items[i];
+    if (indicator->source != source)
+      continue;
+    Gdata hlc[3];
+    double last[RC_INDICATOR_OUTPUTS];
+    size_t from = indicator->rows + 1; // rows no update has written yet
+    indicator_source_columns(source, hlc);
+    if (from + 1 < len) { // more than one bar appended since the last update
+      indicator_reserve(indicator, len);
+      indicator_advance(indicator, hlc, len, indicator->buffers, last);
+      indicator_write_rows(indicator, from, len - 1);
+    } else {
+      indicator_advance(indicator, hlc, len, NULL, last);
+    }
+    for (size_t o = 0; o < indicator->outputs_len; ++o)
+      artist_update_last(indicator->outputs[o], last + o);
+  }
+}
+
+void indicators_source_replaced(Artist *source) {
+  Indicators *indicators = (Indicators *)source->parent->parent->indicators;
+  for (size_t i = 0; i < indicators->len; ++i) {
+    if (indicators->items[i]->source == source)
+      indicator_recompute(indicators->items[i]);
+  }
+}
+
+size_t indicator_outputs(IndicatorType type) {
+  RC_ASSERT((unsigned)type < INDICATOR_TYPE_LEN,
+            "indicator type %d has not been implemented\n", type);
+  return outputs_len[type];
+}
+
+Indicator *create_indicator(Artist *source, IndicatorType type, size_t *params,
+                            Artist **outputs) {
+  Figure *figure = source->parent->parent;
+  Indicators *indicators = (Indicators *)figure->indicators;
+  RC_ASSERT(source->index != NULL, "the source of an indicator needs data\n");
+  RC_ASSERT(figure->feed == NULL, "artists of a feed are updated by it only\n");
+  RC_ASSERT(!publish_deferred(figure),
+            "'%s' must be called before `show` or from its thread\n",
+            RC_ECHO(create_indicator));
+  RC_ASSERT(!indicator_needs_hl(type) || source->gdata.cols == 4,
+            "this indicator reads high and low, its source must be a candle\n");
+  Arena *arena = (Arena *)figure->arena;
+  Indicator *indicator = arena_alloc(arena, sizeof(Indicator));
+  indicator_init(indicator, arena, type, params);
+  indicator->source = source;
+  for (size_t o = 0; o < indicator->outputs_len; ++o) {
+    RC_ASSERT(outputs[o] != source && outputs[o]->index != NULL &&
+                  outputs[o]->gdata.cols == 1,
+              "indicator outputs are other artists with 1 column of data\n");
+    indicator->outputs[o] = outputs[o];
+  }
+  if (indicators->len == indicators->capacity) {
+    size_t capacity = maxl(indicators->capacity * 2, 8);
+    indicators->items =
+        arena_resize(arena, indicators->items,
+                     sizeof(Indicator *) * indicators->capacity,
+                     sizeof(Indicator *) * capacity);
+    indicators->capacity = capacity;
+  }
+  indicators->items[indicators->len++] = indicator;
+  indicator_recompute(indicator);
+  return indicator;
+}
+
+void indicator_compute(IndicatorType type, size_t *params, double **hlc,
+                       size_t len, double **outputs) {
+  RC_ASSERT(hlc[2] != NULL && (!indicator_needs_hl(type) ||
+                               (hlc[0] != NULL && hlc[1] != NULL)),
+            "missing input columns\n");
+  if (len == 0)
+    return;
+  Arena *arena = arena_create();
+  Indicator indicator;
+  double last[RC_INDICATOR_OUTPUTS];
+  indicator_init(&indicator, arena, type, params);
+  Gdata columns[3];
+  for (size_t k = 0; k < 3; ++k)
+    columns[k] = (Gdata){.cols = 1, .ydata = hlc[k]};
+  indicator_advance(&indicator, columns, len, outputs, last);
+  indicator_release(&indicator);
+  arena_destroy(arena);
+}
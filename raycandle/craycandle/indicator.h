@@ -0,0 +1,91 @@
+/*
+ * Indicator
+ * ---------
+ * the indicators of cmnfunc.py computed in C, with the same definitions
+ * (pandas rolling windows need `window` values that are not NaN, ewm is
+ * pandas' ewma).
+ * Each one is a state machine stepped once per bar: rolling windows keep a
+ * ring of their inputs with a running sum and Welford mean/M2, rolling
+ * extremes a monotonic deque, exponential averages their weighted mean. A
+ * step costs O(1) whatever the window.
+ *
+ * Bound to a source artist with create_indicator, an indicator writes its
+ * outputs into the Gdata of line artists. The state holds the bars before the
+ * last one: when the last bar of the source changes (artist_update_last) the
+ * rows appended since are stepped in, then the last one is stepped on a copy of
+ * the state and written with artist_update_last of each output, which redraws
+ * only the last slot and updates indicators fed by that output in turn.
+ * Replacing the source data (artist_set_data) recomputes the whole history.
+ *
+ * Computing a history runs in two passes: the per bar transforms (true range,
+ * directional moves, gains and losses) are written to scratch columns by
+ * branch free loops the compiler vectorizes, then the recurrences, which are
+ * inherently serial, step over them. The streaming path runs the same
+ * functions on a single row so both give identical values.
+ */
+#ifndef __RAYCANDLE_INDICATOR__
+#define __RAYCANDLE_INDICATOR__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "arena.h"
+#include "raycandle.h"
+
+#define RC_INDICATOR_OUTPUTS 3 // most outputs of an indicator (ADX, Bollinger)
+#define RC_INDICATOR_INPUTS 3  // per bar transforms of an indicator
+
+typedef struct {
+  double *ring;  // `window` inputs, NaN until filled
+  size_t window;
+  size_t count;  // values in the window that are not NaN
+  double sum, compensation; // Neumaier sum of them
+  double mean, m2;          // Welford, for the variance
+} IndicatorWindow;
+
+typedef struct {
+  double *ring;  // `window` inputs, NaN until filled
+  size_t *deque; // rows of decreasing (increasing for a min) values
+  size_t window, head, len;
+  size_t count; // values in the window that are not NaN
+  bool max;
+} IndicatorExtreme;
+
+typedef struct {
+  double weighted; // the average, NaN before the first value
+  double old_wt, new_wt, factor;
+  bool adjust;
+} IndicatorEwm;
+
+struct Indicator {
+  IndicatorType type;
+  size_t params[3];
+  Artist *source;
+  Artist *outputs[RC_INDICATOR_OUTPUTS];
+  size_t outputs_len;
+  size_t rows; // rows of the source stepped into the state
+  IndicatorWindow windows[2];
+  IndicatorExtreme extremes[2];
+  IndicatorEwm ewms[4];
+  double *buffers[RC_INDICATOR_OUTPUTS]; // history handed to the outputs
+  size_t buffers_len;                    // rows the buffers hold
+  Arena *arena;
+};
+
+typedef struct {
+  Indicator **items;
+  size_t len, capacity;
+  Arena *arena;
+} Indicators;
+
+Indicators *indicators_create(Arena *arena);
+/**
+the last bar of `source` changed, see above. Called by artist_update_last
+*/
+void indicators_source_updated(Artist *source);
+/**
+the data of `source` was replaced: recomputes the indicators fed by it
+*/
+void indicators_source_replaced(Artist *source);
+
+#endif //__RAYCANDLE_INDICATOR__
@@ -0,0 +1,323 @@
+#include "kernels.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define RC_KERNELS_X86
+#include <immintrin.h>
+#define RC_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+typedef struct {
+  void (*x_pixels)(const double *in, double *out, size_t len, double scale,
+                   double offset);
+  void (*points)(const double *x, const double *y, float *xy, size_t len,
+                 YPixelMap map);
+  void (*candle_pixels)(const double *const in[4], float *const out[4],
+                        uint8_t *color_indexes, size_t len, YPixelMap map);
+  void (*bar_pixels)(const double *in, float *out, uint8_t *color_indexes,
+                     size_t len, double baseline, YPixelMap map);
+} Kernels;
+
+static const char *isa_names[KERNEL_ISA_LEN] = {
+    [KERNEL_ISA_SCALAR] = "scalar",
+    [KERNEL_ISA_SSE2] = "sse2",
+    [KERNEL_ISA_AVX2] = "avx2",
+};
+
+// color indexes of up to 4 bars from the movemask of open > close (or of
+// baseline > value)
+static const uint8_t rising_lanes[16][4] = {
+    {1, 1, 1, 1}, {0, 1, 1, 1}, {1, 0, 1, 1}, {0, 0, 1, 1},
+    {1, 1, 0, 1}, {0, 1, 0, 1}, {1, 0, 0, 1}, {0, 0, 0, 1},
+    {1, 1, 1, 0}, {0, 1, 1, 0}, {1, 0, 1, 0}, {0, 0, 1, 0},
+    {1, 1, 0, 0}, {0, 1, 0, 0}, {1, 0, 0, 0}, {0, 0, 0, 0},
+};
+
+static Kernels kernels_table[KERNEL_ISA_LEN];
+static KernelIsa isa_supported = KERNEL_ISA_SCALAR, isa = KERNEL_ISA_SCALAR;
+static pthread_once_t kernels_once = PTHREAD_ONCE_INIT;
+
+static void kernels_select(void);
+static inline const Kernels *kernels_get(void);
+static void scalar_x_pixels(const double *in, double *out, size_t len,
+                            double scale, double offset);
+static void scalar_points(const double *x, const double *y, float *xy,
+                          size_t len, YPixelMap map);
+static void scalar_candle_pixels(const double *const in[4],
+                                 float *const out[4], uint8_t *color_indexes,
+                                 size_t len, YPixelMap map);
+static void scalar_bar_pixels(const double *in, float *out,
+                              uint8_t *color_indexes, size_t len,
+                              double baseline, YPixelMap map);
+
+static inline double scalar_y_pixel(double value, YPixelMap map) {
+  return (map.limit_max - value) / map.diff * map.height + map.start;
+}
+
+static void scalar_x_pixels(const double *in, double *out, size_t len,
+                            double scale, double offset) {
+  for (size_t i = 0; i < len; ++i)
+    out[i] = in[i] * scale + offset;
+}
+
+static void scalar_points(const double *x, const double *y, float *xy,
+                          size_t len, YPixelMap map) {
+  for (size_t i = 0; i < len; ++i) {
+    xy[i * 2] = (float)x[i];
+    xy[i * 2 + 1] = (float)scalar_y_pixel(y[i], map);
+  }
+}
+
+static void scalar_candle_pixels(const double *const in[4],
+                                 float *const out[4], uint8_t *color_indexes,
+                                 size_t len, YPixelMap map) {
+  for (size_t i = 0; i < len; ++i) {
+    double open = in[0][i], high = in[1][i], low = in[2][i], close = in[3][i];
+    double popen = scalar_y_pixel(open, map);
+    double pclose = scalar_y_pixel(close, map);
+    bool ogtc = open > close; // selects, not branches
+    out[0][i] = (float)scalar_y_pixel(high, map);
+    out[1][i] = (float)(ogtc ? popen : pclose);
+    out[2][i] = (float)(ogtc ? pclose : popen);
+    out[3][i] = (float)scalar_y_pixel(low, map);
+    color_indexes[i] = (uint8_t)!ogtc;
+  }
+}
+
+static void scalar_bar_pixels(const double *in, float *out,
+                              uint8_t *color_indexes, size_t len,
+                              double baseline, YPixelMap map) {
+  for (size_t i = 0; i < len; ++i) {
+    out[i] = (float)scalar_y_pixel(in[i], map);
+    color_indexes[i] = (uint8_t)!(baseline > in[i]);
+  }
+}
+
+#ifdef RC_KERNELS_X86
+#define RC_SSE2_Y_PIXEL(v)                                                     \
+  _mm_add_pd(_mm_mul_pd(_mm_div_pd(_mm_sub_pd(limit_max, (v)), diff), height), \
+             start)
+#define RC_AVX2_Y_PIXEL(v)                                                     \
+  _mm256_add_pd(                                                               \
+      _mm256_mul_pd(_mm256_div_pd(_mm256_sub_pd(limit_max, (v)), diff),        \
+                    height),                                                   \
+      start)
+// 2 doubles stored as 2 floats
+#define RC_SSE2_STORE2(ptr, v) _mm_storel_pi((__m64 *)(ptr), _mm_cvtpd_ps(v))
+
+RC_TARGET("sse2")
+static void sse2_x_pixels(const double *in, double *out, size_t len,
+                          double scale, double offset) {
+  __m128d s = _mm_set1_pd(scale), o = _mm_set1_pd(offset);
+  size_t i = 0;
+  for (; i + 2 <= len; i += 2)
+    _mm_storeu_pd(out + i, _mm_add_pd(_mm_mul_pd(_mm_loadu_pd(in + i), s), o));
+  scalar_x_pixels(in + i, out + i, len - i, scale, offset);
+}
+
+RC_TARGET("sse2")
+static void sse2_points(const double *x, const double *y, float *xy,
+                        size_t len, YPixelMap map) {
+  __m128d limit_max = _mm_set1_pd(map.limit_max), diff = _mm_set1_pd(map.diff),
+          height = _mm_set1_pd(map.height), start = _mm_set1_pd(map.start);
+  size_t i = 0;
+  for (; i + 2 <= len; i += 2) {
+    __m128 xs = _mm_cvtpd_ps(_mm_loadu_pd(x + i));
+    __m128 ys = _mm_cvtpd_ps(RC_SSE2_Y_PIXEL(_mm_loadu_pd(y + i)));
+    _mm_storeu_ps(xy + i * 2, _mm_unpacklo_ps(xs, ys)); // x0 y0 x1 y1
+  }
+  scalar_points(x + i, y + i, xy + i * 2, len - i, map);
+}
+
+RC_TARGET("sse2")
+static void sse2_candle_pixels(const double *const in[4], float *const out[4],
+                               uint8_t *color_indexes, size_t len,
+                               YPixelMap map) {
+  __m128d limit_max = _mm_set1_pd(map.limit_max), diff = _mm_set1_pd(map.diff),
+          height = _mm_set1_pd(map.height), start = _mm_set1_pd(map.start);
+  size_t i = 0;
+  for (; i + 2 <= len; i += 2) {
+    __m128d open = _mm_loadu_pd(in[0] + i), high = _mm_loadu_pd(in[1] + i),
+            low = _mm_loadu_pd(in[2] + i), close = _mm_loadu_pd(in[3] + i);
+    __m128d popen = RC_SSE2_Y_PIXEL(open), pclose = RC_SSE2_Y_PIXEL(close);
+    __m128d ogtc = _mm_cmpgt_pd(open, close);
+    RC_SSE2_STORE2(out[0] + i, RC_SSE2_Y_PIXEL(high));
+    RC_SSE2_STORE2(out[1] + i, _mm_or_pd(_mm_and_pd(ogtc, popen),
+                                         _mm_andnot_pd(ogtc, pclose)));
+    RC_SSE2_STORE2(out[2] + i, _mm_or_pd(_mm_and_pd(ogtc, pclose),
+                                         _mm_andnot_pd(ogtc, popen)));
+    RC_SSE2_STORE2(out[3] + i, RC_SSE2_Y_PIXEL(low));
+    memcpy(color_indexes + i, rising_lanes[_mm_movemask_pd(ogtc)], 2);
+  }
+  const double *const tail_in[4] = {in[0] + i, in[1] + i, in[2] + i, in[3] + i};
+  float *const tail_out[4] = {out[0] + i, out[1] + i, out[2] + i, out[3] + i};
+  scalar_candle_pixels(tail_in, tail_out, color_indexes + i, len - i, map);
+}
+
+RC_TARGET("sse2")
+static void sse2_bar_pixels(const double *in, float *out,
+                            uint8_t *color_indexes, size_t len,
+                            double baseline, YPixelMap map) {
+  __m128d limit_max = _mm_set1_pd(map.limit_max), diff = _mm_set1_pd(map.diff),
+          height = _mm_set1_pd(map.height), start = _mm_set1_pd(map.start);
+  __m128d base = _mm_set1_pd(baseline);
+  size_t i = 0;
+  for (; i + 2 <= len; i += 2) {
+    __m128d value = _mm_loadu_pd(in + i);
+    RC_SSE2_STORE2(out + i, RC_SSE2_Y_PIXEL(value));
+    memcpy(color_indexes + i,
+           rising_lanes[_mm_movemask_pd(_mm_cmpgt_pd(base, value))], 2);
+  }
+  scalar_bar_pixels(in + i, out + i, color_indexes + i, len - i, baseline,
+                    map);
+}
+
+RC_TARGET("avx2")
+static void avx2_x_pixels(const double *in, double *out, size_t len,
+                          double scale, double offset) {
+  __m256d s = _mm256_set1_pd(scale), o = _mm256_set1_pd(offset);
+  size_t i = 0;
+  for (; i + 4 <= len; i += 4)
+    _mm256_storeu_pd(out + i,
+                     _mm256_add_pd(_mm256_mul_pd(_mm256_loadu_pd(in + i), s), o));
+  scalar_x_pixels(in + i, out + i, len - i, scale, offset);
+}
+
+RC_TARGET("avx2")
+static void avx2_points(const double *x, const double *y, float *xy,
+                        size_t len, YPixelMap map) {
+  __m256d limit_max = _mm256_set1_pd(map.limit_max),
+          diff = _mm256_set1_pd(map.diff), height = _mm256_set1_pd(map.height),
+          start = _mm256_set1_pd(map.start);
+  size_t i = 0;
+  for (; i + 4 <= len; i += 4) {
+    __m128 xs = _mm256_cvtpd_ps(_mm256_loadu_pd(x + i));
+    __m128 ys = _mm256_cvtpd_ps(RC_AVX2_Y_PIXEL(_mm256_loadu_pd(y + i)));
+    _mm_storeu_ps(xy + i * 2, _mm_unpacklo_ps(xs, ys));     // x0 y0 x1 y1
+    _mm_storeu_ps(xy + i * 2 + 4, _mm_unpackhi_ps(xs, ys)); // x2 y2 x3 y3
+  }
+  scalar_points(x + i, y + i, xy + i * 2, len - i, map);
+}
+
+RC_TARGET("avx2")
+static void avx2_candle_pixels(const double *const in[4], float *const out[4],
+                               uint8_t *color_indexes, size_t len,
+                               YPixelMap map) {
+  __m256d limit_max = _mm256_set1_pd(map.limit_max),
+          diff = _mm256_set1_pd(map.diff), height = _mm256_set1_pd(map.height),
+          start = _mm256_set1_pd(map.start);
+  size_t i = 0;
+  for (; i + 4 <= len; i += 4) {
+    __m256d open = _mm256_loadu_pd(in[0] + i),
+            high = _mm256_loadu_pd(in[1] + i), low = _mm256_loadu_pd(in[2] + i),
+            close = _mm256_loadu_pd(in[3] + i);
+    __m256d popen = RC_AVX2_Y_PIXEL(open), pclose = RC_AVX2_Y_PIXEL(close);
+    __m256d ogtc = _mm256_cmp_pd(open, close, _CMP_GT_OQ);
+    _mm_storeu_ps(out[0] + i, _mm256_cvtpd_ps(RC_AVX2_Y_PIXEL(high)));
+    _mm_storeu_ps(out[1] + i,
+                  _mm256_cvtpd_ps(_mm256_blendv_pd(pclose, popen, ogtc)));
+    _mm_storeu_ps(out[2] + i,
+                  _mm256_cvtpd_ps(_mm256_blendv_pd(popen, pclose, ogtc)));
+    _mm_storeu_ps(out[3] + i, _mm256_cvtpd_ps(RC_AVX2_Y_PIXEL(low)));
+    memcpy(color_indexes + i, rising_lanes[_mm256_movemask_pd(ogtc)], 4);
+  }
+  const double *const tail_in[4] = {in[0] + i, in[1] + i, in[2] + i, in[3] + i};
+  float *const tail_out[4] = {out[0] + i, out[1] + i, out[2] + i, out[3] + i};
+  scalar_candle_pixels(tail_in, tail_out, color_indexes + i, len - i, map);
+}
+
+RC_TARGET("avx2")
+static void avx2_bar_pixels(const double *in, float *out,
+                            uint8_t *color_indexes, size_t len,
+                            double baseline, YPixelMap map) {
+  __m256d limit_max = _mm256_set1_pd(map.limit_max),
+          diff = _mm256_set1_pd(map.diff), height = _mm256_set1_pd(map.height),
+          start = _mm256_set1_pd(map.start);
+  __m256d base = _mm256_set1_pd(baseline);
+  size_t i = 0;
+  for (; i + 4 <= len; i += 4) {
+    __m256d value = _mm256_loadu_pd(in + i);
+    _mm_storeu_ps(out + i, _mm256_cvtpd_ps(RC_AVX2_Y_PIXEL(value)));
+    memcpy(color_indexes + i,
+           rising_lanes[_mm256_movemask_pd(
+               _mm256_cmp_pd(base, value, _CMP_GT_OQ))],
+           4);
+  }
+  scalar_bar_pixels(in + i, out + i, color_indexes + i, len - i, baseline,
+                    map);
+}
+
+#undef RC_SSE2_Y_PIXEL
+#undef RC_AVX2_Y_PIXEL
+#undef RC_SSE2_STORE2
+#endif // RC_KERNELS_X86
+
+static void kernels_select(void) {
+  kernels_table[KERNEL_ISA_SCALAR] = (Kernels){
+      scalar_x_pixels, scalar_points, scalar_candle_pixels, scalar_bar_pixels};
+#ifdef RC_KERNELS_X86
+  kernels_table[KERNEL_ISA_SSE2] =
+      (Kernels){sse2_x_pixels, sse2_points, sse2_candle_pixels,
+                sse2_bar_pixels};
+  kernels_table[KERNEL_ISA_AVX2] =
+      (Kernels){avx2_x_pixels, avx2_points, avx2_candle_pixels,
+                avx2_bar_pixels};
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("sse2"))
+    isa_supported = KERNEL_ISA_SSE2;
+  if (__builtin_cpu_supports("avx2"))
+    isa_supported = KERNEL_ISA_AVX2;
+#endif
+  isa = isa_supported;
+  const char *cap = getenv("RAYCANDLE_SIMD");
+  for (size_t i = 0; cap != NULL && i < KERNEL_ISA_LEN; ++i) {
+    if (strcmp(cap, isa_names[i]) == 0 && (KernelIsa)i < isa)
+      isa = (KernelIsa)i;
+  }
+}
+
+// isa may be changed while pool workers map pixels: a relaxed atomic suffices,
+// a worker uses either table for a whole kernel call
+static inline const Kernels *kernels_get(void) {
+  pthread_once(&kernels_once, kernels_select);
+  return kernels_table + __atomic_load_n(&isa, __ATOMIC_RELAXED);
+}
+
+KernelIsa kernels_isa(void) {
+  pthread_once(&kernels_once, kernels_select);
+  return __atomic_load_n(&isa, __ATOMIC_RELAXED);
+}
+
+void kernels_set_isa(KernelIsa requested) {
+  pthread_once(&kernels_once, kernels_select);
+  __atomic_store_n(&isa, requested < isa_supported ? requested : isa_supported,
+                   __ATOMIC_RELAXED);
+}
+
+const char *kernels_isa_name(KernelIsa requested) {
+  return requested < KERNEL_ISA_LEN ? isa_names[requested] : "unknown";
+}
+
+void kernel_x_pixels(const double *in, double *out, size_t len, double scale,
+                     double offset) {
+  kernels_get()->x_pixels(in, out, len, scale, offset);
+}
+
+void kernel_points(const double *x, const double *y, float *xy, size_t len,
+                   YPixelMap map) {
+  kernels_get()->points(x, y, xy, len, map);
+}
+
+void kernel_candle_pixels(const double *const in[4], float *const out[4],
+                          uint8_t *color_indexes, size_t len, YPixelMap map) {
+  kernels_get()->candle_pixels(in, out, color_indexes, len, map);
+}
+
+void kernel_bar_pixels(const double *in, float *out, uint8_t *color_indexes,
+                       size_t len, double baseline, YPixelMap map) {
+  kernels_get()->bar_pixels(in, out, color_indexes, len, baseline, map);
+}
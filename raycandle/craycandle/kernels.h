@@ -0,0 +1,57 @@
+/*
+ * Kernels
+ * -------
+ * data to pixel transforms over a whole window of slots. Each kernel has a
+ * scalar, an SSE2 and an AVX2 version; the widest one the CPU supports is
+ * picked on first use (RAYCANDLE_SIMD=scalar|sse2|avx2 caps it). All versions
+ * use the same operations in the same order as RC_DATA_Y_2_PIXEL so they give
+ * bit identical pixels. Pixels are computed in double and stored as the
+ * float32 the draw calls consume.
+ */
+#ifndef __RAYCANDLE_KERNELS__
+#define __RAYCANDLE_KERNELS__
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+  KERNEL_ISA_SCALAR,
+  KERNEL_ISA_SSE2,
+  KERNEL_ISA_AVX2,
+  KERNEL_ISA_LEN,
+} KernelIsa;
+
+typedef struct {
+  // pixel = (limit_max - value) / diff * height + start, see RC_DATA_Y_2_PIXEL
+  double limit_max, diff, height, start;
+} YPixelMap;
+
+KernelIsa kernels_isa(void);
+void kernels_set_isa(KernelIsa isa); // capped to what the CPU supports
+const char *kernels_isa_name(KernelIsa isa);
+/**
+out[i] = in[i] * scale + offset
+*/
+void kernel_x_pixels(const double *in, double *out, size_t len, double scale,
+                     double offset);
+/**
+writes `len` interleaved (x, y pixel) float points, a Vector2 array, from x
+pixels and y data values
+*/
+void kernel_points(const double *x, const double *y, float *xy, size_t len,
+                   YPixelMap map);
+/**
+maps `len` bars of in={open,high,low,close} to out={high, body top, body
+bottom, low} pixels and sets color_indexes to 1 for a rising bar (open <= close)
+and 0 otherwise
+*/
+void kernel_candle_pixels(const double *const in[4], float *const out[4],
+                          uint8_t *color_indexes, size_t len, YPixelMap map);
+/**
+maps `len` bar values to pixels and sets color_indexes to 1 for a value >=
+`baseline` and 0 otherwise
+*/
+void kernel_bar_pixels(const double *in, float *out, uint8_t *color_indexes,
+                       size_t len, double baseline, YPixelMap map);
+
+#endif //__RAYCANDLE_KERNELS__
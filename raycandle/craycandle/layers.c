@@ -0,0 +1,83 @@
+#include "layers.h"
+
+#include "canvas.h"
+#include "rlgl.h"
+#include "utils.h"
+
+static void layer_unload(Layer *layer);
+
+static void layer_unload(Layer *layer) {
+  if (layer->loaded)
+    UnloadRenderTexture(layer->texture);
+  layer->loaded = false;
+  layer->dirty = true;
+}
+
+AxesLayers *layers_create(Arena *arena) {
+  AxesLayers *layers = arena_alloc(arena, sizeof(AxesLayers));
+  *layers = (AxesLayers){.decorations = {.dirty = true, .loaded = false},
+                         .data = {.dirty = true, .loaded = false}};
+  return layers;
+}
+
+void layers_invalidate(AxesLayers *layers) {
+  layer_invalidate(&layers->decorations);
+  layer_invalidate(&layers->data);
+}
+
+void layer_invalidate(Layer *layer) { layer->dirty = true; }
+
+bool layer_begin(Layer *layer, Rectangle rec, Color clear) {
+  if (rec.width < 1 || rec.height < 1)
+    return false;
+  if (canvas_active() != NULL) {
+    layer->rec = rec;
+    canvas_fill_rect(rec, clear);
+    return true;
+  }
+  bool resized = !layer->loaded || rec.width != layer->rec.width ||
+                 rec.height != layer->rec.height;
+  if (!resized && !layer->dirty && rec.x == layer->rec.x &&
+      rec.y == layer->rec.y)
+    return false;
+  if (resized) {
+    layer_unload(layer);
+    layer->texture = LoadRenderTexture(rec.width, rec.height);
+    layer->loaded = true;
+  }
+  layer->rec = rec;
+  BeginTextureMode(layer->texture);
+  ClearBackground(clear);
+  rlPushMatrix();
+  rlTranslatef(-rec.x, -rec.y, 0); // callers keep drawing in screen space
+  return true;
+}
+
+void layer_end(Layer *layer) {
+  if (canvas_active() != NULL)
+    return;
+  rlPopMatrix();
+  EndTextureMode();
+  layer->dirty = false;
+}
+
+void layer_draw(const Layer *layer) {
+  if (!layer->loaded || canvas_active() != NULL)
+    return;
+  // render textures are stored bottom up
+  DrawTextureRec(layer->texture.texture,
+                 (Rectangle){0, 0, layer->rec.width, -layer->rec.height},
+                 (Vector2){layer->rec.x, layer->rec.y}, WHITE);
+}
+
+Rectangle layer_clip(const Layer *layer, Rectangle rec) {
+  if (canvas_active() != NULL)
+    return rec;
+  return (Rectangle){rec.x - layer->rec.x, rec.y - layer->rec.y, rec.width,
+                     rec.height};
+}
+
+void layers_unload(AxesLayers *layers) {
+  layer_unload(&layers->decorations);
+  layer_unload(&layers->data);
+}
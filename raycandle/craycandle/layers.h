@@ -0,0 +1,51 @@
+/*
+ * AxesLayers
+ * ----------
+ * render textures cached between frames for each axes. The decorations layer
+ * holds the frame, facecolor, title and y labels; the data layer holds the
+ * artists and the legend. A layer is only redrawn after it was invalidated
+ * (data, limits, size or style changed); otherwise it is blitted as is and
+ * only the mouse overlay (cursors, mouse y label, tooltip) is drawn each frame.
+ * While a canvas is active, layers are pass through: everything is drawn
+ * straight into the canvas.
+ */
+#ifndef __RAYCANDLE_LAYERS__
+#define __RAYCANDLE_LAYERS__
+
+#include <stdbool.h>
+
+#include "arena.h"
+#include "raylib.h"
+
+typedef struct {
+  RenderTexture2D texture;
+  Rectangle rec; // screen area covered by the texture
+  bool dirty, loaded;
+} Layer;
+
+typedef struct {
+  Layer decorations, data;
+} AxesLayers;
+
+AxesLayers *layers_create(Arena *arena);
+void layers_invalidate(AxesLayers *layers); // redraw every layer
+void layer_invalidate(Layer *layer);
+/**
+starts drawing into `layer` if it is dirty or `rec` moved, in which case the
+texture is cleared with `clear` and screen coordinates can be used as is.
+returns false, without starting anything, when the cached texture is valid
+*/
+bool layer_begin(Layer *layer, Rectangle rec, Color clear);
+void layer_end(Layer *layer);
+void layer_draw(const Layer *layer); // blit the cached texture at layer->rec
+/**
+`rec` in the coordinates scissor boxes use while drawing into `layer`; they
+ignore the layer's translation
+*/
+Rectangle layer_clip(const Layer *layer, Rectangle rec);
+/**
+unloads the textures, must be called before CloseWindow
+*/
+void layers_unload(AxesLayers *layers);
+
+#endif //__RAYCANDLE_LAYERS__
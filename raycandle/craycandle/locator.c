@@ -2,29 +2,34 @@
 #include <time.h>
 
 #include "artist.h"
+#include "kernels.h"
+#include "layers.h"
+#include "profiler.h"
 #include "raycandle.h"
 #include "utils.h"
 
 void locator_update_data_buffers(Axes *axes, LimitChanged lim) {
   if (lim == LIMIT_CHANGED_ALL_LIM) {
-    RC_ASSERT(axes->artist_len != 0 && axes->artist != NULL);
+    RC_ASSERT(axes->artist_len != 0);
   }
-  size_t rows = axes->parent->dragger.vlen;
+  RC_PROFILE_BEGIN(PROFILE_PHASE_LOCATOR_UPDATE);
+  size_t rows = axes->parent->dragger.slots;
   if (rows == 0) {
     RC_ERROR("unreachable function '%s'  when figure has no xdataa\n",
              RC_ECHO(locator_update_data_buffers));
   }
   if (lim == LIMIT_CHANGED_XLIM || lim == LIMIT_CHANGED_ALL_LIM) {
-    double *xdata = axes->parent->dragger.xdata_shared;
-    size_t width = axes->width;
-    size_t startX = axes->startX;
-    for (size_t i = 0; i < rows; ++i) {
-      axes->xdata_buffer[i] = xdata[i] * width + startX;
-    }
-  }
-  for (size_t i = 0; i < axes->artist_len; ++i) {
-    artist_update_data_buffer(get_artist(axes, i), lim);
+    locator_update_xdata_buffer(axes);
   }
+  artists_update_data_buffers(axes, lim);
+  // the decorations layer is only redrawn if draw_axes finds new y labels
+  layer_invalidate(&((AxesLayers *)axes->layers)->data);
+  RC_PROFILE_END(PROFILE_PHASE_LOCATOR_UPDATE);
+}
+
+void locator_update_xdata_buffer(Axes *axes) {
+  kernel_x_pixels(axes->parent->dragger.xdata_shared, axes->xdata_buffer,
+                  axes->parent->dragger.slots, axes->width, axes->startX);
 }
 
 void epoch2strftime(int epoch, Str buffer, const char *format) {
@@ -10,6 +10,7 @@ typedef enum {
 } LimitChanged;
 
 void locator_update_data_buffers(Axes *axes, LimitChanged lim);
+void locator_update_xdata_buffer(Axes *axes); // x pixels of the slots
 void locator_tooltip_mouse_position(Axes *axes, Str buffer, int mouseX,
                                     int mouseY);
 /**
@@ -8,11 +8,25 @@
 #include "artist.h"
 #include "axes.h"
 #include "figure.h"
+#include "layers.h"
+#include "locator.h"
+#include "pool.h"
+#include "profiler.h"
+#include "publish.h"
+#include "range_index.h"
 #include "raycandle.h"
+#include "resample.h"
+#include "text.h"
 #include "utils.h"
 
+typedef struct {
+  Figure *figure;
+  size_t *first; // first artist task of each axes, axes_len + 1 items
+} FigureTasks;
+
 static void update_from_diffx(float diffx, Figure *figure);
-static void update_ylim_not_static(Axes *axes);
+static void update_axes_task(void *ctx, size_t index);
+static void update_artist_task(void *ctx, size_t index);
 
 void zoomx(Figure *figure, int move) {
   figure->zoomx_padding += move / 100.f;
@@ -23,20 +37,20 @@ void zoomx(Figure *figure, int move) {
 
 void zoomy(Figure *figure, int move) {
   RC_ASSERT(RC_ZOOMY_SCALE >= 1);
-  long int vlen, start, temp;
+  long int vlen, start, temp, step;
   start = figure->dragger.start;
   vlen = figure->dragger.vlen;
-  temp = RC_MAX_PLOTTABLE_LEN > figure->dragger._len ? figure->dragger._len
-                                                     : RC_MAX_PLOTTABLE_LEN;
+  temp = figure->dragger._len; // wide windows are decimated, no need to cap
+  step = maxl(RC_ZOOMY_SCALE, vlen / RC_ZOOMY_RATIO);
 #define ZOOMING_IN move == -1
   if (ZOOMING_IN) {
-    vlen = vlen == temp ? vlen : minl(temp, vlen + 2 * RC_ZOOMY_SCALE);
-    start = vlen == temp ? start : maxl(0, start - RC_ZOOMY_SCALE);
+    vlen = vlen == temp ? vlen : minl(temp, vlen + 2 * step);
+    start = vlen == temp ? start : maxl(0, start - step);
     if (start + vlen > (long int)figure->dragger._len)
       start = figure->dragger._len - vlen;
   } else {
-    vlen = vlen == 1 ? 1 : maxl(1, vlen - 2 * RC_ZOOMY_SCALE);
-    start = vlen == 1 ? start : start + RC_ZOOMY_SCALE;
+    vlen = vlen == 1 ? 1 : maxl(1, vlen - 2 * step);
+    start = vlen == 1 ? start : start + step;
     if (start + vlen > (long int)figure->dragger._len)
       start = figure->dragger._len - 1;
   }
@@ -131,10 +145,23 @@ void mouse_updates(Figure *figure) {
     start = figure->dragger.start + (figure->dragger.vlen * ratio) -
             (RC_INITIAL_VISIBLE_DATA * ratio);
     figure->vertical_limit_drag = figure->zoomx_padding = 0;
-    figure->dragger.vlen = RC_INITIAL_VISIBLE_DATA;
+    // a coarse timeframe may have fewer bars
+    figure->dragger.vlen = minl(RC_INITIAL_VISIBLE_DATA, figure->dragger._len);
     start = minl(maxl(start, 0), figure->dragger._len - figure->dragger.vlen);
     figure->dragger.start = start;
     figure->force_update = true;
+    return;
+  }
+
+  /**
+     5. Pressing 1 to 9 to show the timeframes set by figure_set_timeframes
+  */
+  Resampler *resampler = (Resampler *)figure->resampler;
+  for (size_t k = 0; k < resampler->keys_len; ++k) {
+    if (IsKeyPressed(KEY_ONE + (int)k)) {
+      resample_key(figure, k);
+      return;
+    }
   }
 }
 
@@ -154,26 +181,19 @@ static void update_from_diffx(float diffx, Figure *figure) {
   update_from_position((size_t)start, figure);
 }
 
-static void update_ylim_not_static(Axes *axes) {
+void update_ylim_not_static(Axes *axes) {
   RC_ASSERT(!axes->ylocator.limit.is_static);
-  double lmax = NAN, lmin = NAN, value;
+  RC_PROFILE_BEGIN(PROFILE_PHASE_UPDATE_YLIM);
+  double lmax = NAN, lmin = NAN, minmax[2];
   size_t start = axes->parent->dragger.start;
   for (size_t a = 0; a < axes->artist_len; ++a) {
-    Artist artist = *get_artist(axes, a);
-    if (!artist.ylim_consider)
+    Artist *artist = get_artist(axes, a);
+    if (!artist->ylim_consider)
       continue;
-    RC_ASSERT(artist.gdata.ydata != NULL && artist.gdata.cols > 0);
-    for (size_t i = 0; i < artist.gdata.cols; ++i) {
-      double *ydata = &(*artist.gdata.ydata) + (i * axes->parent->dragger._len);
-      for (size_t s = start; s < axes->parent->dragger.vlen + start; s++) {
-        value = ydata[s];
-        if (!isfinite(value)) {
-          continue;
-        }
-        lmax = fmax(lmax, value);
-        lmin = fmin(lmin, value);
-      }
-    }
+    RC_ASSERT(artist->index != NULL && artist->gdata.cols > 0);
+    artist_ylim(artist, start, start + axes->parent->dragger.vlen, minmax);
+    lmin = fmin(lmin, minmax[0]);
+    lmax = fmax(lmax, minmax[1]);
   }
   float diff = lmax - lmin;
   float vertical_limit_drag = diff * axes->parent->vertical_limit_drag;
@@ -185,33 +205,80 @@ static void update_ylim_not_static(Axes *axes) {
   lmin -= dadd;
   axes->ylocator.limit =
       (Limit){.limit_max = lmax, .limit_min = lmin, .diff = diff};
+  RC_PROFILE_END(PROFILE_PHASE_UPDATE_YLIM);
 }
 
 #define BUF_LEN 128
 void measure_ylabel(Axes *axes) {
+  RC_PROFILE_BEGIN(PROFILE_PHASE_MEASURE_YLABEL);
   char _buffer[BUF_LEN] = {0};
   Str string = string_create(BUF_LEN, _buffer);
+  TextCache *cache = (TextCache *)axes->parent->text_cache;
   string_append(string, "    %.5f ", axes->ylocator.limit.limit_min);
   axes->ylabel_len =
-    MeasureTextEx(FIGURE_FONT(axes->parent), string,
-                    RC_LABEL_FONT_SIZE, axes->parent->font_spacing)
+      text_measure(cache, FIGURE_FONT(axes->parent), string,
+                   RC_LABEL_FONT_SIZE, axes->parent->font_spacing)
           .x;
   string_clear(string);
   string_append(string, "    ");
   axes->ylabel_padding =
-      MeasureTextEx(FIGURE_FONT(axes->parent), string,
-                    RC_LABEL_FONT_SIZE, axes->parent->font_spacing)
+      text_measure(cache, FIGURE_FONT(axes->parent), string,
+                   RC_LABEL_FONT_SIZE, axes->parent->font_spacing)
           .x;
   string_destroy(string);
+  RC_PROFILE_END(PROFILE_PHASE_MEASURE_YLABEL);
 }
 #undef BUF_LEN
 
+static void update_axes_task(void *ctx, size_t index) {
+  Axes *axes = ((FigureTasks *)ctx)->figure->axes + index;
+  if (axes->artist_len == 0)
+    return;
+  if (!axes->ylocator.limit.is_static)
+    update_ylim_not_static(axes);
+  locator_update_xdata_buffer(axes);
+}
+
+static void update_artist_task(void *ctx, size_t index) {
+  FigureTasks *tasks = (FigureTasks *)ctx;
+  size_t a = 0;
+  while (tasks->first[a + 1] <= index)
+    ++a;
+  artist_update_data_buffer(
+      get_artist(tasks->figure->axes + a, index - tasks->first[a]),
+      LIMIT_CHANGED_ALL_LIM);
+}
+
 void update_from_position(size_t start, Figure *figure) {
   RC_ASSERT(figure->has_dragger);
+  if (publish_update(figure, start))
+    return; // the asserts below read what the renderer writes
   RC_ASSERT(start <= figure->dragger._len);
   RC_ASSERT(start + figure->dragger.vlen <= figure->dragger._len);
+  RC_PROFILE_BEGIN(PROFILE_PHASE_UPDATE_FROM_POSITION);
   figure->dragger.start = start;
   update_xlim(figure);
+  size_t first[figure->axes_len + 1];
+  first[0] = 0;
+  for (size_t i = 0; i < figure->axes_len; ++i)
+    first[i + 1] = first[i] + figure->axes[i].artist_len;
+  if (first[figure->axes_len] * figure->dragger.slots >= RC_POOL_MIN_SLOTS) {
+    // axes only share the x limits set above: autoscale them, then every
+    // artist, on the pool
+    FigureTasks tasks = {.figure = figure, .first = first};
+    pool_run(update_axes_task, &tasks, figure->axes_len);
+    RC_PROFILE_BEGIN(PROFILE_PHASE_LOCATOR_UPDATE);
+    pool_run(update_artist_task, &tasks, first[figure->axes_len]);
+    RC_PROFILE_END(PROFILE_PHASE_LOCATOR_UPDATE);
+    for (size_t i = 0; i < figure->axes_len; ++i) {
+      if (figure->axes[i].artist_len == 0)
+        continue;
+      measure_ylabel(figure->axes + i); // the text cache is not thread safe
+      layer_invalidate(&((AxesLayers *)figure->axes[i].layers)->data);
+    }
+    RC_PROFILE_END(PROFILE_PHASE_UPDATE_FROM_POSITION);
+    return;
+  }
   for (size_t i = 0; i < figure->axes_len; ++i) {
     if (figure->axes[i].artist_len == 0) {
       continue;
@@ -224,4 +291,5 @@ void update_from_position(size_t start, Figure *figure) {
     measure_ylabel(&figure->axes[i]);
     locator_update_data_buffers(figure->axes + i, LIMIT_CHANGED_ALL_LIM);
   }
+  RC_PROFILE_END(PROFILE_PHASE_UPDATE_FROM_POSITION);
 }
@@ -8,6 +8,9 @@ updates can be triggered by:
     3. Normal left click and drag
 */
 void mouse_updates(Figure *figure);
+void update_ylim_not_static(Axes *axes); // ylims from the visible window
+void measure_ylabel(Axes *axes);
 
 #define RC_ZOOMX_SCALE 2
 #define RC_ZOOMY_SCALE 5
+#define RC_ZOOMY_RATIO 20 // wide windows zoom by vlen/RC_ZOOMY_RATIO per side
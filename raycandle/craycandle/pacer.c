@@ -0,0 +1,90 @@
+#define _POSIX_C_SOURCE 200112L // clock_gettime, pthread_condattr_setclock
+#include "pacer.h"
+
+#include <math.h>
+#include <time.h>
+
+#include "feed.h"
+#include "utils.h"
+
+static bool pacer_input(Figure *figure);
+
+static inline double pacer_min_refresh(Figure *figure) {
+  float seconds; // figure_set_min_refresh may be called from any thread
+  __atomic_load(&figure->min_refresh, &seconds, __ATOMIC_RELAXED);
+  return seconds;
+}
+
+Pacer *pacer_create(Arena *arena) {
+  Pacer *pacer = arena_alloc(arena, sizeof(Pacer));
+  *pacer = (Pacer){.woken = false, .last_frame = -INFINITY, .changed = 0};
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(&pacer->wake, &attr);
+  pthread_condattr_destroy(&attr);
+  pthread_mutex_init(&pacer->lock, NULL);
+  return pacer;
+}
+
+void pacer_destroy(Pacer *pacer) {
+  pthread_cond_destroy(&pacer->wake);
+  pthread_mutex_destroy(&pacer->lock);
+}
+
+void pacer_wake(Pacer *pacer) {
+  pthread_mutex_lock(&pacer->lock);
+  __atomic_store_n(&pacer->woken, true, __ATOMIC_RELEASE);
+  pthread_cond_signal(&pacer->wake);
+  pthread_mutex_unlock(&pacer->lock);
+}
+
+/**
+whether the input polled last may change the figure: the mouse moved, scrolled
+or is dragging, a key was pressed or the window was resized
+*/
+static bool pacer_input(Figure *figure) {
+  Vector2 delta = GetMouseDelta(), wheel = GetMouseWheelMoveV();
+  if (delta.x != 0 || delta.y != 0 || wheel.x != 0 || wheel.y != 0)
+    return true;
+  if (IsMouseButtonDown(MOUSE_BUTTON_LEFT) ||
+      IsMouseButtonReleased(MOUSE_BUTTON_LEFT))
+    return true;
+  if (GetKeyPressed() != 0 || IsKeyDown(KEY_LEFT) || IsKeyDown(KEY_RIGHT))
+    return true; // the arrows scroll for as long as they are held
+  return IsWindowResized() || GetScreenWidth() != figure->width ||
+         GetScreenHeight() != figure->height;
+}
+
+bool pacer_frame_due(Figure *figure) {
+  Pacer *pacer = (Pacer *)figure->pacer;
+  double now = GetTime(), min_refresh = pacer_min_refresh(figure);
+  bool changed = min_refresh <= 0 || figure->force_update ||
+                 pacer_input(figure) ||
+                 __atomic_exchange_n(&pacer->woken, false, __ATOMIC_ACQ_REL) ||
+                 (figure->feed != NULL && feed_pending(figure));
+  if (changed)
+    pacer->changed = now;
+  else if (now - pacer->changed >= RC_PACER_LINGER &&
+           now - pacer->last_frame < min_refresh)
+    return false; // a refresh is a single frame, it does not linger
+  pacer->last_frame = now;
+  return true;
+}
+
+void pacer_idle(Figure *figure) {
+  Pacer *pacer = (Pacer *)figure->pacer;
+  double refresh = pacer->last_frame + pacer_min_refresh(figure) - GetTime();
+  double seconds = fmax(fmin(RC_PACER_POLL, refresh), 0);
+  struct timespec until;
+  clock_gettime(CLOCK_MONOTONIC, &until);
+  until.tv_nsec += (long)(seconds * 1e9);
+  until.tv_sec += until.tv_nsec / 1000000000L;
+  until.tv_nsec %= 1000000000L;
+  pthread_mutex_lock(&pacer->lock);
+  while (!__atomic_load_n(&pacer->woken, __ATOMIC_ACQUIRE) &&
+         pthread_cond_timedwait(&pacer->wake, &pacer->lock, &until) == 0)
+    ; // a spurious wake up, woken is still false
+  pthread_mutex_unlock(&pacer->lock);
+  PollInputEvents();
+}
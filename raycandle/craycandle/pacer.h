@@ -0,0 +1,47 @@
+/*
+ * Pacer
+ * -----
+ * decides when `show` draws a frame. One is due when something may have
+ * changed what the window shows: input, a resize, a change published by
+ * another thread (see publish.h), feed bars, or `min_refresh` seconds without
+ * a frame (the tooltip clock, a bar rewritten in place by C code). Frames come
+ * at the target fps while changes last and RC_PACER_LINGER seconds more. In
+ * between the render thread sleeps on a condition variable that publishers
+ * signal, waking every RC_PACER_POLL seconds to poll input and feeds.
+ */
+#ifndef __RAYCANDLE_PACER__
+#define __RAYCANDLE_PACER__
+
+#include <pthread.h>
+#include <stdbool.h>
+
+#include "arena.h"
+#include "raycandle.h"
+
+#define RC_PACER_POLL 0.016  // seconds between input polls while idle
+#define RC_PACER_LINGER 0.25 // seconds of frames after the last change
+#define RC_MIN_REFRESH 1.0   // default Figure.min_refresh
+
+typedef struct {
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  bool woken;        // a change was published since the last frame
+  double last_frame; // GetTime() of the last frame
+  double changed;    // GetTime() of the last change seen
+} Pacer;
+
+Pacer *pacer_create(Arena *arena);
+void pacer_destroy(Pacer *pacer);
+void pacer_wake(Pacer *pacer); // from any thread, a frame is due
+/**
+whether the render loop should draw now. Reads the input polled by the last
+frame or pacer_idle
+*/
+bool pacer_frame_due(Figure *figure);
+/**
+sleeps until woken, the next input poll or the next min_refresh frame,
+whichever comes first, then polls input
+*/
+void pacer_idle(Figure *figure);
+
+#endif //__RAYCANDLE_PACER__
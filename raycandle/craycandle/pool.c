@@ -0,0 +1,107 @@
+#define _POSIX_C_SOURCE 200112L // sysconf
+#include "pool.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "utils.h"
+
+typedef struct {
+  pthread_mutex_t lock, busy; // busy: held by the pool_run in flight
+  pthread_cond_t start, done;
+  PoolTask task;
+  void *ctx;
+  size_t len, generation, pending, threads;
+  pthread_t workers[RC_POOL_MAX_THREADS];
+} Pool;
+
+static Pool pool = {.lock = PTHREAD_MUTEX_INITIALIZER,
+                    .busy = PTHREAD_MUTEX_INITIALIZER,
+                    .start = PTHREAD_COND_INITIALIZER,
+                    .done = PTHREAD_COND_INITIALIZER,
+                    .threads = 1};
+static pthread_once_t pool_once = PTHREAD_ONCE_INIT;
+static __thread size_t pool_self = 0; // thread index of a worker
+
+static void pool_start(void);
+static void pool_after_fork(void);
+static void *pool_worker(void *arg);
+static void pool_run_thread(size_t thread);
+
+static void pool_start(void) {
+  long threads = sysconf(_SC_NPROCESSORS_ONLN);
+  const char *count = getenv("RAYCANDLE_THREADS");
+  if (count != NULL && atol(count) > 0)
+    threads = atol(count);
+  threads = minl(maxl(threads, 1), RC_POOL_MAX_THREADS);
+  pthread_atfork(NULL, NULL, pool_after_fork);
+  for (long t = 1; t < threads; ++t) {
+    if (pthread_create(pool.workers + t, NULL, pool_worker, (void *)t) != 0) {
+      RC_WARN("pool runs with %ld threads\n", t);
+      break;
+    }
+    pool.threads = t + 1;
+  }
+}
+
+static void pool_after_fork(void) { // the workers did not survive the fork
+  pool = (Pool){.lock = PTHREAD_MUTEX_INITIALIZER,
+                .busy = PTHREAD_MUTEX_INITIALIZER,
+                .start = PTHREAD_COND_INITIALIZER,
+                .done = PTHREAD_COND_INITIALIZER,
+                .threads = 1};
+}
+
+static void pool_run_thread(size_t thread) {
+  for (size_t i = thread; i < pool.len; i += pool.threads)
+    pool.task(pool.ctx, i);
+}
+
+static void *pool_worker(void *arg) {
+  size_t thread = (size_t)arg, generation = 0;
+  pool_self = thread;
+  for (;;) {
+    pthread_mutex_lock(&pool.lock);
+    while (pool.generation == generation)
+      pthread_cond_wait(&pool.start, &pool.lock);
+    generation = pool.generation;
+    pthread_mutex_unlock(&pool.lock);
+    pool_run_thread(thread);
+    pthread_mutex_lock(&pool.lock);
+    if (--pool.pending == 0)
+      pthread_cond_signal(&pool.done);
+    pthread_mutex_unlock(&pool.lock);
+  }
+  return NULL;
+}
+
+size_t pool_threads(void) {
+  pthread_once(&pool_once, pool_start);
+  return pool.threads;
+}
+
+size_t pool_thread(void) { return pool_self; }
+
+void pool_run(PoolTask task, void *ctx, size_t len) {
+  if (len < 2 || pool_threads() == 1 || pthread_mutex_trylock(&pool.busy)) {
+    for (size_t i = 0; i < len; ++i)
+      task(ctx, i);
+    return;
+  }
+  pthread_mutex_lock(&pool.lock);
+  pool.task = task;
+  pool.ctx = ctx;
+  pool.len = len;
+  pool.pending = pool.threads - 1;
+  pool.generation += 1;
+  pthread_cond_broadcast(&pool.start);
+  pthread_mutex_unlock(&pool.lock);
+  pool_run_thread(0);
+  pthread_mutex_lock(&pool.lock);
+  while (pool.pending != 0)
+    pthread_cond_wait(&pool.done, &pool.lock);
+  pthread_mutex_unlock(&pool.lock);
+  pthread_mutex_unlock(&pool.busy);
+}
@@ -0,0 +1,26 @@
+/*
+ * Pool
+ * ----
+ * a persistent pool of worker threads, started on first use and shared by
+ * every figure. pool_run fans `len` independent tasks out and returns once all
+ * of them ran. Scheduling is static: task i always runs on thread i % threads
+ * (the caller is thread 0), so a given task count maps to the same threads on
+ * every run. There is a thread per online core unless RAYCANDLE_THREADS=n sets
+ * the count; 1 runs everything on the caller. A pool_run issued while another
+ * one is in flight, or from a task, runs serially on its caller.
+ */
+#ifndef __RAYCANDLE_POOL__
+#define __RAYCANDLE_POOL__
+
+#include <stddef.h>
+
+#define RC_POOL_MAX_THREADS 16
+#define RC_POOL_MIN_SLOTS 2048 // slots*artists below which fanning out is slower
+
+typedef void (*PoolTask)(void *ctx, size_t index);
+
+size_t pool_threads(void); // including the caller, >= 1
+size_t pool_thread(void);  // index of the calling worker, 0 off the pool
+void pool_run(PoolTask task, void *ctx, size_t len);
+
+#endif //__RAYCANDLE_POOL__
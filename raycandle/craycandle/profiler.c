@@ -0,0 +1,179 @@
+#define _POSIX_C_SOURCE 199309L // clock_gettime
+#include "profiler.h"
+
+#include <inttypes.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "pool.h"
+#include "utils.h"
+
+typedef struct {
+  ProfilePhase phase;
+  uint64_t start, duration;
+  size_t thread; // pool thread that timed the phase, 0 for the render thread
+} TraceEvent;
+
+bool profiler_enabled = false;
+
+static const char *phase_names[PROFILE_PHASE_LEN] = {
+    [PROFILE_PHASE_FRAME] = "frame",
+    [PROFILE_PHASE_UPDATE_FIGURE] = "update_figure",
+    [PROFILE_PHASE_UPDATE_FROM_POSITION] = "update_from_position",
+    [PROFILE_PHASE_UPDATE_YLIM] = "update_ylim_not_static",
+    [PROFILE_PHASE_MEASURE_YLABEL] = "measure_ylabel",
+    [PROFILE_PHASE_LOCATOR_UPDATE] = "locator_update_data_buffers",
+    [PROFILE_PHASE_MOUSE_UPDATES] = "mouse_updates",
+    [PROFILE_PHASE_DRAW_AXES] = "draw_axes",
+    [PROFILE_PHASE_DRAW_ARTIST] = "draw_artist",
+    [PROFILE_PHASE_BATCH_DRAW] = "batch_draw",
+    [PROFILE_PHASE_TEXT] = "text",
+    [PROFILE_PHASE_END_DRAWING] = "EndDrawing",
+};
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t frame_totals[PROFILE_PHASE_LEN];
+static bool frame_ran[PROFILE_PHASE_LEN];
+static double windows[PROFILE_PHASE_LEN][RC_PROFILER_WINDOW]; // microseconds
+static size_t window_len[PROFILE_PHASE_LEN], window_head[PROFILE_PHASE_LEN];
+static TraceEvent *trace = NULL; // ring of the last trace_capacity events
+static size_t trace_capacity = 0, trace_len = 0, trace_head = 0;
+static uint64_t trace_origin = 0;
+
+static int profiler_compare(const void *a, const void *b);
+
+static int profiler_compare(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+uint64_t profiler_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  uint64_t now = (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+  return now != 0 ? now : 1;
+}
+
+void profiler_record(ProfilePhase phase, uint64_t start) {
+  uint64_t duration = profiler_now() - start;
+  // phases timed on pool threads add up the time spent on every thread
+  __atomic_fetch_add(frame_totals + phase, duration, __ATOMIC_RELAXED);
+  __atomic_store_n(frame_ran + phase, true, __ATOMIC_RELAXED);
+  if (trace == NULL)
+    return;
+  pthread_mutex_lock(&lock);
+  if (trace != NULL) {
+    trace[trace_head] = (TraceEvent){phase, start, duration, pool_thread()};
+    trace_head = (trace_head + 1) % trace_capacity;
+    trace_len = minl(trace_len + 1, trace_capacity);
+  }
+  pthread_mutex_unlock(&lock);
+}
+
+void profiler_frame_end(void) {
+  if (!profiler_enabled)
+    return;
+  pthread_mutex_lock(&lock);
+  for (size_t p = 0; p < PROFILE_PHASE_LEN; ++p) {
+    if (!frame_ran[p])
+      continue;
+    windows[p][window_head[p]] = frame_totals[p] / 1e3;
+    window_head[p] = (window_head[p] + 1) % RC_PROFILER_WINDOW;
+    window_len[p] = minl(window_len[p] + 1, RC_PROFILER_WINDOW);
+    frame_totals[p] = 0;
+    frame_ran[p] = false;
+  }
+  pthread_mutex_unlock(&lock);
+}
+
+void profiler_enable(bool enable) { profiler_enabled = enable; }
+
+void profiler_reset(void) {
+  pthread_mutex_lock(&lock);
+  memset(frame_totals, 0, sizeof(frame_totals));
+  memset(frame_ran, 0, sizeof(frame_ran));
+  memset(window_len, 0, sizeof(window_len));
+  memset(window_head, 0, sizeof(window_head));
+  trace_len = trace_head = 0;
+  pthread_mutex_unlock(&lock);
+}
+
+double profiler_percentile(ProfilePhase phase, double q) {
+  RC_ASSERT(phase < PROFILE_PHASE_LEN && q >= 0. && q <= 1.);
+  double sorted[RC_PROFILER_WINDOW];
+  pthread_mutex_lock(&lock);
+  size_t len = window_len[phase];
+  memcpy(sorted, windows[phase], sizeof(double) * len);
+  pthread_mutex_unlock(&lock);
+  if (len == 0)
+    return NAN;
+  qsort(sorted, len, sizeof(double), profiler_compare);
+  double rank = q * (len - 1);
+  size_t below = (size_t)rank;
+  if (below + 1 >= len)
+    return sorted[len - 1];
+  return sorted[below] + (sorted[below + 1] - sorted[below]) * (rank - below);
+}
+
+size_t profiler_samples(ProfilePhase phase) {
+  RC_ASSERT(phase < PROFILE_PHASE_LEN);
+  return window_len[phase];
+}
+
+const char *profiler_phase_name(ProfilePhase phase) {
+  RC_ASSERT(phase < PROFILE_PHASE_LEN);
+  return phase_names[phase];
+}
+
+void profiler_trace_start(size_t max_events) {
+  RC_ASSERT(max_events > 0);
+  TraceEvent *CM_MALLOC(events, sizeof(TraceEvent) * max_events);
+  pthread_mutex_lock(&lock);
+  if (trace != NULL)
+    CM_FREE(trace);
+  trace = events;
+  trace_capacity = max_events;
+  trace_len = trace_head = 0;
+  trace_origin = profiler_now();
+  pthread_mutex_unlock(&lock);
+  profiler_enabled = true;
+}
+
+void profiler_trace_stop(void) {
+  pthread_mutex_lock(&lock);
+  if (trace != NULL)
+    CM_FREE(trace);
+  trace = NULL;
+  trace_capacity = trace_len = trace_head = 0;
+  pthread_mutex_unlock(&lock);
+}
+
+bool profiler_trace_dump(char *path) {
+  FILE *file = fopen(path, "w");
+  if (file == NULL)
+    return false;
+  int pid = getpid();
+  pthread_mutex_lock(&lock);
+  fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+  size_t first = (trace_head + trace_capacity - trace_len) %
+                 (trace_capacity ? trace_capacity : 1);
+  for (size_t i = 0; i < trace_len; ++i) {
+    TraceEvent *event = trace + (first + i) % trace_capacity;
+    // integer formatting, LC_NUMERIC may use a decimal comma
+    uint64_t ts = event->start > trace_origin ? event->start - trace_origin : 0;
+    fprintf(file,
+            "%s\n{\"name\":\"%s\",\"cat\":\"raycandle\",\"ph\":\"X\","
+            "\"ts\":%" PRIu64 ".%03" PRIu64 ",\"dur\":%" PRIu64 ".%03" PRIu64
+            ",\"pid\":%d,\"tid\":%zu}",
+            i ? "," : "", phase_names[event->phase], ts / 1000, ts % 1000,
+            event->duration / 1000, event->duration % 1000, pid, event->thread);
+  }
+  pthread_mutex_unlock(&lock);
+  fprintf(file, "\n]}\n");
+  return fclose(file) == 0;
+}
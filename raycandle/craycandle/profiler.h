@@ -0,0 +1,34 @@
+/*
+ * Profiler
+ * --------
+ * per phase timers for the render loop. RC_PROFILE_BEGIN/RC_PROFILE_END
+ * bracket a phase; the time spent in each phase is summed over a frame and the
+ * last RC_PROFILER_WINDOW frame totals are kept for percentiles. While tracing,
+ * every bracket is also recorded as a Chrome trace event.
+ * When the profiler is disabled a bracket costs one branch on a global.
+ */
+#ifndef __RAYCANDLE_PROFILER__
+#define __RAYCANDLE_PROFILER__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "raycandle.h"
+
+#define RC_PROFILER_WINDOW 512 // frames kept per phase for percentiles
+
+extern bool profiler_enabled;
+
+#define RC_PROFILE_BEGIN(phase)                                                \
+  uint64_t _rc_profile_##phase = profiler_enabled ? profiler_now() : 0
+#define RC_PROFILE_END(phase)                                                  \
+  do {                                                                         \
+    if (_rc_profile_##phase != 0)                                              \
+      profiler_record(phase, _rc_profile_##phase);                             \
+  } while (0)
+
+uint64_t profiler_now(void); // monotonic nanoseconds, never 0
+void profiler_record(ProfilePhase phase, uint64_t start);
+void profiler_frame_end(void); // push the frame totals into the windows
+
+#endif //__RAYCANDLE_PROFILER__
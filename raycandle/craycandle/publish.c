@@ -0,0 +1,430 @@
+#define _POSIX_C_SOURCE 200112L // nanosleep
+#include "publish.h"
+
+#include <string.h>
+#include <time.h>
+
+#include "artist.h"
+#include "gdata.h"
+#include "heatmap.h"
+#include "indicator.h"
+#include "pacer.h"
+#include "resample.h"
+#include "utils.h"
+
+static Generation *publisher_acquire(Figure *figure);
+static void publisher_release(Figure *figure);
+static void publisher_publish(Figure *figure);
+static void publisher_wait(Figure *figure);
+static PublishOp *publish_push(Publisher *publisher, Generation *gen);
+static void publish_apply(Figure *figure, Generation *gen, PublishOp *op);
+static void publish_apply_xdata(Figure *figure, PublishOp *op);
+static void publish_apply_data(Generation *gen, PublishOp *op);
+
+static inline bool publisher_live(Publisher *publisher) {
+  return __atomic_load_n(&publisher->live, __ATOMIC_ACQUIRE);
+}
+
+// the Publisher whose figure_publish_begin the calling thread is in, if any
+static __thread Publisher *publish_batch = NULL;
+
+static inline bool publisher_in_batch(Publisher *publisher) {
+  return publish_batch == publisher;
+}
+
+/**
+grows `*ptr`, an array of `*capacity` items of `item` bytes, to hold `len`
+*/
+static void publish_reserve(Arena *arena, void **ptr, size_t *capacity,
+                            size_t len, size_t item) {
+  if (len <= *capacity)
+    return;
+  size_t grown = maxl(maxl(*capacity * 2, len), 8);
+  *ptr = arena_resize(arena, *ptr, item * *capacity, item * grown);
+  *capacity = grown;
+}
+
+Publisher *publisher_create(Arena *arena) {
+  Publisher *publisher = arena_alloc(arena, sizeof(Publisher));
+  *publisher = (Publisher){.published = 0, .consumed = 0, .arena = arena};
+  pthread_mutex_init(&publisher->writer, NULL);
+  return publisher;
+}
+
+void publisher_destroy(Publisher *publisher) {
+  pthread_mutex_destroy(&publisher->writer); // the arena owns the rest
+}
+
+void publisher_start(Publisher *publisher) {
+  publisher->render_thread = pthread_self();
+  __atomic_store_n(&publisher->live, true, __ATOMIC_RELEASE);
+}
+
+void publisher_stop(Figure *figure) {
+  Publisher *publisher = (Publisher *)figure->publisher;
+  // writers stop waiting for frames first, one may hold the lock doing so
+  __atomic_store_n(&publisher->live, false, __ATOMIC_RELEASE);
+  pthread_mutex_lock(&publisher->writer);
+  publisher_consume(figure);
+  pthread_mutex_unlock(&publisher->writer);
+}
+
+bool publisher_consume(Figure *figure) {
+  Publisher *publisher = (Publisher *)figure->publisher;
+  uint64_t published =
+      __atomic_load_n(&publisher->published, __ATOMIC_ACQUIRE);
+  if (published == __atomic_load_n(&publisher->consumed, __ATOMIC_RELAXED))
+    return false;
+  Generation *gen = &publisher->generations[published & 1];
+  for (size_t i = 0; i < gen->len; ++i)
+    publish_apply(figure, gen, gen->ops + i);
+  resample_refresh(figure); // stale levels are rebuilt once per generation
+  gen->len = gen->values_len = gen->appended = 0;
+  __atomic_store_n(&publisher->consumed, published, __ATOMIC_RELEASE);
+  return true;
+}
+
+bool publisher_try_lock(Figure *figure) {
+  Publisher *publisher = (Publisher *)figure->publisher;
+  if (!publisher_live(publisher))
+    return true;
+  return pthread_mutex_trylock(&publisher->writer) == 0;
+}
+
+void publisher_unlock(Figure *figure) {
+  Publisher *publisher = (Publisher *)figure->publisher;
+  if (publisher_live(publisher))
+    pthread_mutex_unlock(&publisher->writer);
+}
+
+bool publish_deferred(Figure *figure) {
+  Publisher *publisher = (Publisher *)figure->publisher;
+  if (publisher_in_batch(publisher))
+    return true; // staged until figure_publish_end, even if the loop stopped
+  return publisher_live(publisher) &&
+         !pthread_equal(publisher->render_thread, pthread_self());
+}
+
+/**
+waits until the renderer applied everything published so far. If the render
+loop stopped meanwhile the caller, holding the lock, applies it instead
+*/
+static void publisher_wait(Figure *figure) {
+  Publisher *publisher = (Publisher *)figure->publisher;
+  struct timespec pause = {.tv_sec = 0, .tv_nsec = RC_PUBLISH_WAIT_NS};
+  while (__atomic_load_n(&publisher->consumed, __ATOMIC_ACQUIRE) !=
+         __atomic_load_n(&publisher->published, __ATOMIC_RELAXED)) {
+    if (!publisher_live(publisher)) {
+      publisher_consume(figure);
+      return;
+    }
+    nanosleep(&pause, NULL);
+  }
+}
+
+/**
+the generation a change of the calling thread goes to, with the writer lock
+held, or NULL if the change must be applied right away
+*/
+static Generation *publisher_acquire(Figure *figure) {
+  Publisher *publisher = (Publisher *)figure->publisher;
+  if (!publish_deferred(figure))
+    return NULL;
+  if (!publisher_in_batch(publisher)) {
+    pthread_mutex_lock(&publisher->writer);
+    publisher_wait(figure);
+    if (!publisher_live(publisher)) { // nothing left to race with
+      pthread_mutex_unlock(&publisher->writer);
+      return NULL;
+    }
+  }
+  return &publisher->generations[(publisher->published + 1) & 1];
+}
+
+static void publisher_release(Figure *figure) {
+  Publisher *publisher = (Publisher *)figure->publisher;
+  if (publisher_in_batch(publisher))
+    return;
+  publisher_publish(figure);
+  pthread_mutex_unlock(&publisher->writer);
+}
+
+static void publisher_publish(Figure *figure) {
+  Publisher *publisher = (Publisher *)figure->publisher;
+  if (publisher->generations[(publisher->published + 1) & 1].len == 0)
+    return;
+  __atomic_store_n(&publisher->published, publisher->published + 1,
+                   __ATOMIC_RELEASE);
+  if (!publisher_live(publisher))
+    publisher_consume(figure); // no frame will
+  else
+    pacer_wake((Pacer *)figure->pacer);
+}
+
+static PublishOp *publish_push(Publisher *publisher, Generation *gen) {
+  publish_reserve(publisher->arena, (void **)&gen->ops, &gen->capacity,
+                  gen->len + 1, sizeof(PublishOp));
+  PublishOp *op = gen->ops + gen->len++;
+  *op = (PublishOp){.artist = NULL, .data = NULL, .index = NULL};
+  return op;
+}
+
+void figure_publish_begin(Figure *figure) {
+  Publisher *publisher = (Publisher *)figure->publisher;
+  if (publisher_in_batch(publisher)) {
+    publisher->batch_depth += 1;
+    return;
+  }
+  RC_ASSERT(publish_batch == NULL,
+            "a thread may only publish to one figure at a time\n");
+  pthread_mutex_lock(&publisher->writer);
+  publisher_wait(figure);
+  publish_batch = publisher;
+  publisher->batch_depth = 1;
+}
+
+void figure_publish_end(Figure *figure) {
+  Publisher *publisher = (Publisher *)figure->publisher;
+  RC_ASSERT(publisher_in_batch(publisher), "'%s' without '%s'\n",
+            RC_ECHO(figure_publish_end), RC_ECHO(figure_publish_begin));
+  if (--publisher->batch_depth > 0)
+    return;
+  publish_batch = NULL;
+  publisher_publish(figure);
+  pthread_mutex_unlock(&publisher->writer);
+}
+
+bool publish_set_xdata(Figure *figure, double *xdata) {
+  Generation *gen = publisher_acquire(figure);
+  if (gen == NULL)
+    return false;
+  Publisher *publisher = (Publisher *)figure->publisher;
+  size_t capacity = resample_base_capacity(figure); // a level may be shown
+  PublishOp *op = publish_push(publisher, gen);
+  *op = (PublishOp){.type = PUBLISH_OP_SET_XDATA, .data = xdata};
+  if (capacity != 0 || gen->appended != 0) { // copied, off the frame
+    size_t rows = resample_base_len(figure) + gen->appended;
+    op->owned = true;
+    op->stride = maxl(capacity, rows);
+    op->data = arena_alloc(publisher->arena, sizeof(double) * op->stride);
+    memcpy(op->data, xdata, sizeof(double) * rows);
+  }
+  publisher_release(figure);
+  return true;
+}
+
+bool publish_set_view(Artist *artist, Gdata view) {
+  Figure *figure = artist->parent->parent;
+  Generation *gen = publisher_acquire(figure);
+  if (gen == NULL)
+    return false;
+  Publisher *publisher = (Publisher *)figure->publisher;
+  size_t rows = resample_base_len(figure) + gen->appended;
+  size_t capacity = resample_base_capacity(figure); // a level may be shown
+  if (view.stride == 0)
+    view.stride = rows;
+  view.label = artist->gdata.label;
+  bool owned = capacity != 0 || gen->appended != 0;
+  if (owned) { // the figure keeps a copy, made here rather than in a frame
+    size_t stride = maxl(capacity, rows);
+    double *ydata =
+        arena_alloc(publisher->arena, sizeof(double) * view.cols * stride);
+    for (size_t c = 0; c < view.cols; ++c)
+      gdata_read(&view, c, 0, rows, ydata + c * stride);
+    gdata_set_native(&view, ydata, stride);
+  }
+  RangeIndex *index = NULL;
+  if (gen->spares_len > 0) {
+    index = gen->spares[--gen->spares_len];
+    range_index_rebuild(index, &view, rows, view.stride);
+  } else {
+    index = range_index_create(publisher->arena, &view, rows, view.stride);
+  }
+  // room for the index the renderer retires in exchange
+  publish_reserve(publisher->arena, (void **)&gen->spares,
+                  &gen->spares_capacity, gen->spares_len + gen->len + 1,
+                  sizeof(RangeIndex *));
+  PublishOp *op = publish_push(publisher, gen);
+  *op = (PublishOp){.type = PUBLISH_OP_SET_DATA,
+                    .artist = artist,
+                    .view = view,
+                    .index = index,
+                    .owned = owned};
+  publisher_release(figure);
+  return true;
+}
+
+bool publish_update_last(Artist *artist, double *values) {
+  Figure *figure = artist->parent->parent;
+  Generation *gen = publisher_acquire(figure);
+  if (gen == NULL)
+    return false;
+  RC_ASSERT(artist->index != NULL, "artist has no data to update\n");
+  Publisher *publisher = (Publisher *)figure->publisher;
+  size_t cols = artist->gdata.cols;
+  publish_reserve(publisher->arena, (void **)&gen->values,
+                  &gen->values_capacity, gen->values_len + cols,
+                  sizeof(double));
+  memcpy(gen->values + gen->values_len, values, sizeof(double) * cols);
+  PublishOp *op = publish_push(publisher, gen);
+  *op = (PublishOp){.type = PUBLISH_OP_UPDATE_LAST,
+                    .artist = artist,
+                    .value = gen->values_len};
+  gen->values_len += cols;
+  publisher_release(figure);
+  return true;
+}
+
+bool publish_append_bar(Figure *figure, double x) {
+  Generation *gen = publisher_acquire(figure);
+  if (gen == NULL)
+    return false;
+  Publisher *publisher = (Publisher *)figure->publisher;
+  *publish_push(publisher, gen) =
+      (PublishOp){.type = PUBLISH_OP_APPEND_BAR, .x = x};
+  gen->appended += 1;
+  publisher_release(figure);
+  return true;
+}
+
+bool publish_update(Figure *figure, size_t start) {
+  Generation *gen = publisher_acquire(figure);
+  if (gen == NULL)
+    return false;
+  Publisher *publisher = (Publisher *)figure->publisher;
+  *publish_push(publisher, gen) =
+      (PublishOp){.type = PUBLISH_OP_UPDATE, .value = start};
+  publisher_release(figure);
+  return true;
+}
+
+bool publish_goto_time(Figure *figure, double epoch) {
+  Generation *gen = publisher_acquire(figure);
+  if (gen == NULL)
+    return false;
+  Publisher *publisher = (Publisher *)figure->publisher;
+  *publish_push(publisher, gen) =
+      (PublishOp){.type = PUBLISH_OP_GOTO_TIME, .x = epoch};
+  publisher_release(figure);
+  return true;
+}
+
+bool publish_set_xlim(Figure *figure, double xminmax[2]) {
+  Generation *gen = publisher_acquire(figure);
+  if (gen == NULL)
+    return false;
+  Publisher *publisher = (Publisher *)figure->publisher;
+  *publish_push(publisher, gen) = (PublishOp){
+      .type = PUBLISH_OP_SET_XLIM, .x = xminmax[0], .x_max = xminmax[1]};
+  publisher_release(figure);
+  return true;
+}
+
+bool publish_set_xmapping(Figure *figure, XMapping xmapping) {
+  Generation *gen = publisher_acquire(figure);
+  if (gen == NULL)
+    return false;
+  Publisher *publisher = (Publisher *)figure->publisher;
+  *publish_push(publisher, gen) =
+      (PublishOp){.type = PUBLISH_OP_SET_XMAPPING, .value = xmapping};
+  publisher_release(figure);
+  return true;
+}
+
+bool publish_resample(Figure *figure, size_t timeframe) {
+  Generation *gen = publisher_acquire(figure);
+  if (gen == NULL)
+    return false;
+  Publisher *publisher = (Publisher *)figure->publisher;
+  *publish_push(publisher, gen) =
+      (PublishOp){.type = PUBLISH_OP_RESAMPLE, .value = timeframe};
+  publisher_release(figure);
+  return true;
+}
+
+static void publish_apply(Figure *figure, Generation *gen, PublishOp *op) {
+  switch (op->type) {
+  case PUBLISH_OP_SET_XDATA: // to the base, even while a level is shown
+    resample_base_enter(figure);
+    publish_apply_xdata(figure, op);
+    resample_base_leave(figure, true);
+    return;
+  case PUBLISH_OP_SET_DATA:
+    resample_base_enter(figure);
+    publish_apply_data(gen, op);
+    resample_base_leave(figure, true);
+    heatmap_data_replaced(op->artist);
+    indicators_source_replaced(op->artist);
+    return;
+  case PUBLISH_OP_UPDATE_LAST:
+    artist_update_last(op->artist, gen->values + op->value);
+    return;
+  case PUBLISH_OP_APPEND_BAR:
+    figure_append_bar(figure, op->x);
+    return;
+  case PUBLISH_OP_UPDATE: {
+    Dragger *dragger = &figure->dragger;
+    update_from_position(minl(op->value, dragger->_len - dragger->vlen),
+                         figure);
+    return;
+  }
+  case PUBLISH_OP_GOTO_TIME:
+    figure_goto_time(figure, op->x);
+    return;
+  case PUBLISH_OP_SET_XLIM:
+    figure_set_xlim(figure, (double[2]){op->x, op->x_max});
+    return;
+  case PUBLISH_OP_SET_XMAPPING:
+    figure_set_xmapping(figure, (XMapping)op->value);
+    return;
+  case PUBLISH_OP_RESAMPLE:
+    figure_resample(figure, op->value);
+    return;
+  default:
+    RC_ERROR("unknown publish op %d\n", op->type);
+  }
+}
+
+static void publish_apply_xdata(Figure *figure, PublishOp *op) {
+  Dragger *dragger = &figure->dragger;
+  if (!op->owned) {
+    figure_set_xdata(figure, op->data);
+    return;
+  }
+  if (op->stride == dragger->capacity) { // swap the copy in
+    arena_release((Arena *)figure->arena, dragger->xdata,
+                  sizeof(double) * dragger->capacity);
+    dragger->xdata = op->data;
+    return;
+  }
+  // appends of the same generation reallocated the rows
+  memcpy(dragger->xdata, op->data, sizeof(double) * dragger->_len);
+  arena_release((Arena *)figure->arena, op->data, sizeof(double) * op->stride);
+}
+
+static void publish_apply_data(Generation *gen, PublishOp *op) {
+  Artist *artist = op->artist;
+  Figure *figure = artist->parent->parent;
+  Dragger *dragger = &figure->dragger;
+  Gdata *gdata = &artist->gdata;
+  RangeIndex *retired;
+  if (op->owned == (dragger->capacity != 0) &&
+      (!op->owned || op->view.stride == dragger->capacity)) { // swap it all in
+    if (op->owned)
+      arena_release((Arena *)figure->arena, gdata->ydata,
+                    sizeof(double) * gdata->cols * gdata->stride);
+    gdata_set_view(gdata, &op->view);
+    retired = (RangeIndex *)artist->index;
+    artist->index = op->index;
+  } else { // appends of the same generation reallocated the rows
+    for (size_t c = 0; c < gdata->cols; ++c)
+      gdata_read(&op->view, c, 0, dragger->_len,
+                 gdata->ydata + c * gdata->stride);
+    range_index_rebuild(artist->index, gdata, dragger->_len, gdata->stride);
+    if (op->owned)
+      arena_release((Arena *)figure->arena, op->view.ydata,
+                    sizeof(double) * gdata->cols * op->view.stride);
+    retired = op->index;
+  }
+  gen->spares[gen->spares_len++] = retired;
+}
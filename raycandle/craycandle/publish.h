@@ -0,0 +1,126 @@
+/*
+ * Publisher
+ * ---------
+ * hands data changes made on other threads to the render thread without ever
+ * blocking it. While `show` runs, artist_set_data, figure_set_xdata,
+ * artist_update_last, figure_append_bar, update_from_position and the
+ * navigation of time_index.h and figure_resample called from another thread do not touch what the renderer reads: they are staged as
+ * PublishOps into a Generation.
+ *
+ * There are two generations. Publishing one bumps `published` (release); at
+ * the start of a frame the renderer applies the latest published generation,
+ * clears it and stores `consumed` (release). A writer only starts filling a
+ * generation once consumed == published, so the other one is never in use:
+ * writers wait at most a frame when they publish faster than frames are
+ * drawn, the renderer never waits. Writers are serialized by a mutex, held
+ * between figure_publish_begin and figure_publish_end so that several changes
+ * (new xdata and the data of every artist) show up in the same frame.
+ *
+ * The O(n) part of artist_set_data, building the RangeIndex of the new data
+ * (and copying it when the figure owns the data), runs on the writer; the
+ * renderer swaps the index in and retires the old one for the next writer.
+ */
+#ifndef __RAYCANDLE_PUBLISH__
+#define __RAYCANDLE_PUBLISH__
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "arena.h"
+#include "range_index.h"
+#include "raycandle.h"
+
+#define RC_PUBLISH_WAIT_NS 100000 // writer poll period while a frame applies
+
+typedef enum {
+  PUBLISH_OP_SET_XDATA,
+  PUBLISH_OP_SET_DATA,
+  PUBLISH_OP_UPDATE_LAST,
+  PUBLISH_OP_APPEND_BAR,
+  PUBLISH_OP_UPDATE,
+  PUBLISH_OP_GOTO_TIME,
+  PUBLISH_OP_SET_XLIM,
+  PUBLISH_OP_SET_XMAPPING,
+  PUBLISH_OP_RESAMPLE,
+} PublishOpType;
+
+typedef struct {
+  PublishOpType type;
+  Artist *artist;
+  double *data;      // SET_XDATA: what the figure reads next
+  size_t stride;     // rows allocated for `data` if owned
+  Gdata view;        // SET_DATA: what the artist reads next, native if owned
+  RangeIndex *index; // SET_DATA: over `view`, built by the writer
+  bool owned;        // `data`/`view` is a copy in the arena, the figure owns
+                     // its data
+  size_t value;      // UPDATE_LAST: first of its values, UPDATE: start,
+                     // SET_XMAPPING: the XMapping, RESAMPLE: timeframe
+  double x;          // APPEND_BAR, GOTO_TIME, SET_XLIM: xmin
+  double x_max;      // SET_XLIM
+} PublishOp;
+
+typedef struct {
+  PublishOp *ops;
+  double *values; // rows of the UPDATE_LAST ops
+  RangeIndex **spares; // indexes retired by the renderer, reused by writers
+  size_t len, capacity;
+  size_t values_len, values_capacity;
+  size_t spares_len, spares_capacity;
+  size_t appended; // APPEND_BAR ops, the writer's view of the rows is ahead
+} Generation;
+
+typedef struct {
+  Generation generations[2]; // published & 1 is the latest one
+  uint64_t published, consumed; // accessed atomically
+  bool live;                    // accessed atomically, a render loop runs
+  pthread_t render_thread;      // valid while live
+  pthread_mutex_t writer;
+  size_t batch_depth; // nested figure_publish_begin, of the lock holder
+  Arena *arena;       // of the figure, it is thread safe
+} Publisher;
+
+Publisher *publisher_create(Arena *arena);
+void publisher_destroy(Publisher *publisher);
+/**
+the calling thread becomes the render thread; changes from any other thread
+are published from now on
+*/
+void publisher_start(Publisher *publisher);
+/**
+applies whatever was published and stops publishing. Called by `show` once
+its loop exits
+*/
+void publisher_stop(Figure *figure);
+/**
+applies the latest published generation, at the start of every frame.
+Returns whether there was one
+*/
+bool publisher_consume(Figure *figure);
+/**
+takes the writer lock if no writer holds it, for the renderer to change what
+writers read (the rows of the base, see resample.h) between their changes.
+Always succeeds without a render loop, when there are no writers to exclude
+*/
+bool publisher_try_lock(Figure *figure);
+void publisher_unlock(Figure *figure);
+/**
+whether a change made by the calling thread must be published rather than
+applied
+*/
+bool publish_deferred(Figure *figure);
+/**
+the publishing side of the functions they are named after, called first by
+them. Each returns false if the caller applies the change itself
+*/
+bool publish_set_xdata(Figure *figure, double *xdata);
+bool publish_set_view(Artist *artist, Gdata view);
+bool publish_update_last(Artist *artist, double *values);
+bool publish_append_bar(Figure *figure, double x);
+bool publish_update(Figure *figure, size_t start);
+bool publish_goto_time(Figure *figure, double epoch);
+bool publish_set_xlim(Figure *figure, double xminmax[2]);
+bool publish_set_xmapping(Figure *figure, XMapping xmapping);
+bool publish_resample(Figure *figure, size_t timeframe);
+
+#endif //__RAYCANDLE_PUBLISH__
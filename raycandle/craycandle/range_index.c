@@ -0,0 +1,253 @@
+#include "range_index.h"
+
+#include <math.h>
+
+#include "gdata.h"
+#include "utils.h"
+
+static void range_index_scan(const RangeIndex *index, const Gdata *gdata,
+                             size_t start, size_t end, double minmax[2]);
+static void range_index_set_block(RangeIndex *index, const Gdata *gdata,
+                                  size_t block);
+static size_t range_index_tree_size(size_t len);
+static void range_index_reserve(RangeIndex *index, size_t len);
+static void range_index_build_nodes(RangeIndex *index);
+static void range_index_fold(const double *min, const double *max, size_t start,
+                             size_t end, double minmax[2]);
+
+static void range_index_scan(const RangeIndex *index, const Gdata *gdata,
+                             size_t start, size_t end, double minmax[2]) {
+  double value;
+  if (gdata->last != NULL) { // the rows around last_row as their layout says
+    Gdata rows = *gdata;
+    rows.last = NULL;
+    size_t last = gdata->last_row;
+    if (last < start || last >= end) {
+      range_index_scan(index, &rows, start, end, minmax);
+      return;
+    }
+    range_index_scan(index, &rows, start, last, minmax);
+    range_index_scan(index, &rows, last + 1, end, minmax);
+    for (size_t c = 0; c < gdata->cols; ++c) {
+      if (isfinite(value = gdata->last[c])) {
+        minmax[0] = fmin(minmax[0], value);
+        minmax[1] = fmax(minmax[1], value);
+      }
+    }
+    return;
+  }
+  if (!gdata_is_native(gdata)) { // a view, read item by item
+    Gdata view = *gdata;
+    view.stride = index->stride;
+    for (size_t c = 0; c < gdata->cols; ++c) {
+      for (size_t s = start; s < end; ++s) {
+        value = gdata_get(&view, c, s);
+        if (!isfinite(value)) {
+          continue;
+        }
+        minmax[0] = fmin(minmax[0], value);
+        minmax[1] = fmax(minmax[1], value);
+      }
+    }
+    return;
+  }
+  double low = minmax[0], high = minmax[1];
+  for (size_t c = 0; c < gdata->cols; ++c) {
+    const double *ydata = gdata->ydata + c * index->stride;
+    for (size_t s = start; s < end; ++s) {
+      value = ydata[s];
+      if (!isfinite(value)) {
+        continue;
+      }
+      // comparisons rather than fmin/fmax calls; NaN bounds are replaced
+      low = value >= low ? low : value;
+      high = value <= high ? high : value;
+    }
+  }
+  minmax[0] = low;
+  minmax[1] = high;
+}
+
+static void range_index_set_block(RangeIndex *index, const Gdata *gdata,
+                                  size_t block) {
+  double minmax[2] = {NAN, NAN};
+  for (size_t g = 0; g < RC_RANGE_INDEX_GRAINS; ++g) {
+    double grain[2] = {NAN, NAN};
+    size_t start = block * RC_RANGE_INDEX_BLOCK + g * RC_RANGE_INDEX_GRAIN;
+    size_t end = minl(start + RC_RANGE_INDEX_GRAIN, index->len);
+    if (start < end)
+      range_index_scan(index, gdata, start, end, grain);
+    index->grain_min[block * RC_RANGE_INDEX_GRAINS + g] = grain[0];
+    index->grain_max[block * RC_RANGE_INDEX_GRAINS + g] = grain[1];
+    minmax[0] = fmin(minmax[0], grain[0]);
+    minmax[1] = fmax(minmax[1], grain[1]);
+  }
+  size_t node = index->size + block;
+  index->min[node] = minmax[0];
+  index->max[node] = minmax[1];
+}
+
+// min and max of the summaries [start,end) of `min` and `max` into `minmax`
+static void range_index_fold(const double *min, const double *max, size_t start,
+                             size_t end, double minmax[2]) {
+  for (size_t i = start; i < end; ++i) {
+    minmax[0] = fmin(minmax[0], min[i]);
+    minmax[1] = fmax(minmax[1], max[i]);
+  }
+}
+
+static size_t range_index_tree_size(size_t len) {
+  size_t blocks = (len + RC_RANGE_INDEX_BLOCK - 1) / RC_RANGE_INDEX_BLOCK;
+  size_t size = 1;
+  while (size < blocks)
+    size <<= 1;
+  return size;
+}
+
+RangeIndex *range_index_create(Arena *arena, const Gdata *gdata, size_t len,
+                               size_t stride) {
+  RangeIndex *index = arena_alloc(arena, sizeof(RangeIndex));
+  *index = (RangeIndex){.arena = arena};
+  range_index_rebuild(index, gdata, len, stride);
+  return index;
+}
+
+// 2*size nodes and RC_RANGE_INDEX_GRAINS*size grains, for min and for max
+#define RANGE_INDEX_ITEMS(size) ((size) * (4 + 2 * RC_RANGE_INDEX_GRAINS))
+
+void range_index_destroy(RangeIndex *index) {
+  arena_release(index->arena, index->min,
+                sizeof(double) * RANGE_INDEX_ITEMS(index->size));
+  arena_release(index->arena, index, sizeof(RangeIndex));
+}
+
+static void range_index_reserve(RangeIndex *index, size_t len) {
+  size_t size = range_index_tree_size(len);
+  if (size != index->size) {
+    arena_release(index->arena, index->min,
+                  sizeof(double) * RANGE_INDEX_ITEMS(index->size));
+    index->min = arena_alloc(index->arena, sizeof(double) * RANGE_INDEX_ITEMS(size));
+    index->max = index->min + size * 2;
+    index->grain_min = index->max + size * 2;
+    index->grain_max = index->grain_min + size * RC_RANGE_INDEX_GRAINS;
+    index->size = size;
+  }
+  index->len = len;
+}
+
+static void range_index_build_nodes(RangeIndex *index) {
+  size_t size = index->size;
+  for (size_t n = size - 1; n > 0; --n) {
+    index->min[n] = fmin(index->min[n * 2], index->min[n * 2 + 1]);
+    index->max[n] = fmax(index->max[n * 2], index->max[n * 2 + 1]);
+  }
+}
+
+void range_index_rebuild(RangeIndex *index, const Gdata *gdata, size_t len,
+                         size_t stride) {
+  RC_ASSERT(gdata->ydata != NULL && gdata->cols > 0 && len > 0);
+  range_index_reserve(index, len);
+  index->stride = stride;
+  index->grained = true;
+  size_t size = index->size;
+  size_t blocks = (len + RC_RANGE_INDEX_BLOCK - 1) / RC_RANGE_INDEX_BLOCK;
+  for (size_t b = 0; b < size; ++b) {
+    if (b < blocks) {
+      range_index_set_block(index, gdata, b);
+    } else {
+      index->min[size + b] = index->max[size + b] = NAN;
+      for (size_t g = 0; g < RC_RANGE_INDEX_GRAINS; ++g)
+        index->grain_min[b * RC_RANGE_INDEX_GRAINS + g] =
+            index->grain_max[b * RC_RANGE_INDEX_GRAINS + g] = NAN;
+    }
+  }
+  range_index_build_nodes(index);
+}
+
+RangeIndex *range_index_create_from_blocks(Arena *arena, const Gdata *gdata,
+                                           size_t len, size_t stride,
+                                           const double *block_min,
+                                           const double *block_max,
+                                           size_t block_stride) {
+  RC_ASSERT(gdata->ydata != NULL && gdata->cols > 0 && len > 0);
+  RangeIndex *index = arena_alloc(arena, sizeof(RangeIndex));
+  *index = (RangeIndex){.arena = arena, .stride = stride, .grained = false};
+  range_index_reserve(index, len);
+  size_t size = index->size;
+  size_t blocks = (len + RC_RANGE_INDEX_BLOCK - 1) / RC_RANGE_INDEX_BLOCK;
+  for (size_t b = 0; b < size; ++b) {
+    double min = NAN, max = NAN;
+    for (size_t c = 0; b < blocks && c < gdata->cols; ++c) {
+      min = fmin(min, block_min[c * block_stride + b]);
+      max = fmax(max, block_max[c * block_stride + b]);
+    }
+    index->min[size + b] = min;
+    index->max[size + b] = max;
+  }
+  range_index_build_nodes(index);
+  return index;
+}
+
+void range_index_resize(RangeIndex *index, const Gdata *gdata, size_t len) {
+  if (range_index_tree_size(len) != index->size || len < index->len) {
+    range_index_rebuild(index, gdata, len, index->stride);
+    return;
+  }
+  size_t row = index->len;
+  index->len = len;
+  for (; row < len; row += RC_RANGE_INDEX_BLOCK) // every new block
+    range_index_update(index, gdata, row);
+  range_index_update(index, gdata, len - 1);
+}
+
+void range_index_update(RangeIndex *index, const Gdata *gdata, size_t row) {
+  RC_ASSERT(row < index->len);
+  size_t block = row / RC_RANGE_INDEX_BLOCK;
+  range_index_set_block(index, gdata, block);
+  for (size_t n = (index->size + block) / 2; n > 0; n /= 2) {
+    index->min[n] = fmin(index->min[n * 2], index->min[n * 2 + 1]);
+    index->max[n] = fmax(index->max[n * 2], index->max[n * 2 + 1]);
+  }
+}
+
+void range_index_query(const RangeIndex *index, const Gdata *gdata,
+                       size_t start, size_t end, double minmax[2]) {
+  RC_ASSERT(start <= end && end <= index->len);
+  minmax[0] = minmax[1] = NAN;
+  size_t grain = index->grained ? RC_RANGE_INDEX_GRAIN : RC_RANGE_INDEX_BLOCK;
+  size_t first = (start + grain - 1) / grain; // whole grains [first,last)
+  size_t last = end / grain;
+  if (first >= last) { // no whole grain in range
+    range_index_scan(index, gdata, start, end, minmax);
+    return;
+  }
+  range_index_scan(index, gdata, start, first * grain, minmax);
+  range_index_scan(index, gdata, last * grain, end, minmax);
+  if (index->grained) { // the grains around whole blocks
+    size_t grains = first, grains_end = last;
+    first = (grains + RC_RANGE_INDEX_GRAINS - 1) / RC_RANGE_INDEX_GRAINS;
+    last = grains_end / RC_RANGE_INDEX_GRAINS;
+    if (first >= last) {
+      range_index_fold(index->grain_min, index->grain_max, grains, grains_end,
+                       minmax);
+      return;
+    }
+    range_index_fold(index->grain_min, index->grain_max, grains,
+                     first * RC_RANGE_INDEX_GRAINS, minmax);
+    range_index_fold(index->grain_min, index->grain_max,
+                     last * RC_RANGE_INDEX_GRAINS, grains_end, minmax);
+  }
+  for (size_t l = first + index->size, r = last + index->size; l < r;
+       l /= 2, r /= 2) {
+    if (l & 1) {
+      minmax[0] = fmin(minmax[0], index->min[l]);
+      minmax[1] = fmax(minmax[1], index->max[l]);
+      l++;
+    }
+    if (r & 1) {
+      r--;
+      minmax[0] = fmin(minmax[0], index->min[r]);
+      minmax[1] = fmax(minmax[1], index->max[r]);
+    }
+  }
+}
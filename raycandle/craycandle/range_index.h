@@ -0,0 +1,70 @@
+/*
+ * RangeIndex
+ * ----------
+ * min/max acceleration structure over an artist's `Gdata.ydata`.
+ * rows are grouped in blocks of RC_RANGE_INDEX_BLOCK; each block stores the
+ * min/max over all its rows and columns (non finite values are skipped) and the
+ * blocks are the leaves of a segment tree. Each block also keeps the min/max of
+ * its grains of RC_RANGE_INDEX_GRAIN rows, so a query over any window reads
+ * O(log n) nodes and grains plus O(RC_RANGE_INDEX_GRAIN * cols) values at its
+ * edges, none for a window that starts and ends on grains.
+ */
+#ifndef __RAYCANDLE_RANGE_INDEX__
+#define __RAYCANDLE_RANGE_INDEX__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "arena.h"
+#include "raycandle.h"
+
+#define RC_RANGE_INDEX_BLOCK 32
+#define RC_RANGE_INDEX_GRAIN 8 // divides RC_RANGE_INDEX_BLOCK
+#define RC_RANGE_INDEX_GRAINS (RC_RANGE_INDEX_BLOCK / RC_RANGE_INDEX_GRAIN)
+
+typedef struct {
+  size_t len;    // rows indexed
+  size_t stride; // distance between 2 columns in `Gdata.ydata`
+  size_t size;   // number of tree leaves, a power of 2 >= number of blocks
+  double *min, *max; // 1-based heap layout of 2*size nodes each
+  double *grain_min, *grain_max; // RC_RANGE_INDEX_GRAINS per leaf
+  bool grained;      // false while the grains of some block are not known
+  Arena *arena;      // owns the index and its tree
+} RangeIndex;
+
+/**
+builds an index over the first `len` rows of `gdata`. columns are `stride`
+items apart
+*/
+RangeIndex *range_index_create(Arena *arena, const Gdata *gdata, size_t len,
+                               size_t stride);
+void range_index_rebuild(RangeIndex *index, const Gdata *gdata, size_t len,
+                         size_t stride);
+void range_index_destroy(RangeIndex *index); // back to its arena
+/**
+like range_index_create, but the leaves come from precomputed per column block
+summaries instead of the rows: column c's block b spans the same rows as a
+leaf and has min block_min[c*block_stride+b] and max block_max[c*block_stride+b].
+Queries then read the rows of partial blocks until the index is rebuilt
+*/
+RangeIndex *range_index_create_from_blocks(Arena *arena, const Gdata *gdata,
+                                           size_t len, size_t stride,
+                                           const double *block_min,
+                                           const double *block_max,
+                                           size_t block_stride);
+/**
+grows the index to `len` rows. The tree is only rebuilt when it is full
+*/
+void range_index_resize(RangeIndex *index, const Gdata *gdata, size_t len);
+/**
+recomputes the block holding `row` after its values changed
+*/
+void range_index_update(RangeIndex *index, const Gdata *gdata, size_t row);
+/**
+writes min and max of the finite values in rows [start,end) into `minmax`.
+both are NaN if there is no finite value in the range
+*/
+void range_index_query(const RangeIndex *index, const Gdata *gdata,
+                       size_t start, size_t end, double minmax[2]);
+
+#endif //__RAYCANDLE_RANGE_INDEX__
@@ -37,6 +37,9 @@ typedef enum {
 typedef enum {
   ARTIST_TYPE_LINE = 0,
   ARTIST_TYPE_CANDLE = 1,
+  ARTIST_TYPE_BAR = 2, // volumes, histograms: config is a BarData or NULL
+  ARTIST_TYPE_HEATMAP = 3, // depth behind prices: config is a HeatmapData
+  ARTIST_TYPE_LEN,
 } ArtistType;
 
 typedef enum {
@@ -51,15 +54,77 @@ typedef enum {
   FORMATTER_NULL_FORMATTER = 2,
 } FormatterType;
 
+typedef enum {
+  X_MAPPING_INDEX = 0, // bars evenly spaced, gaps between sessions collapse
+  X_MAPPING_TIME = 1,  // bars at their timestamps, gaps are empty space
+} XMapping;
+
+typedef enum {
+  AGGREGATION_LAST = 0,  // value of the last bar of the bucket
+  AGGREGATION_FIRST = 1, // value of its first bar
+  AGGREGATION_MAX = 2,
+  AGGREGATION_MIN = 3,
+  AGGREGATION_SUM = 4, // volumes
+  AGGREGATION_OHLC = 5, // 4 columns: first, max, min and last, for candles
+} Aggregation;
+
+typedef enum {
+  INDICATOR_TYPE_SMA = 0,       // params: window. Outputs: sma
+  INDICATOR_TYPE_EMA = 1,       // params: span. Outputs: ema
+  INDICATOR_TYPE_RSI = 2,       // params: period. Outputs: rsi
+  INDICATOR_TYPE_BOLLINGER = 3, // params: window. Outputs: ub, mb, lb
+  INDICATOR_TYPE_STOCH = 4,     // params: k, d, m. Outputs: k, d
+  INDICATOR_TYPE_ADX = 5,       // params: window. Outputs: +dmi, -dmi, adx
+  INDICATOR_TYPE_ATR = 6,       // params: window. Outputs: atr
+  INDICATOR_TYPE_LEN,
+} IndicatorType;
+
+typedef enum {
+  PROFILE_PHASE_FRAME, // one iteration of the render loop
+  PROFILE_PHASE_UPDATE_FIGURE,
+  PROFILE_PHASE_UPDATE_FROM_POSITION,
+  PROFILE_PHASE_UPDATE_YLIM,
+  PROFILE_PHASE_MEASURE_YLABEL,
+  PROFILE_PHASE_LOCATOR_UPDATE,
+  PROFILE_PHASE_MOUSE_UPDATES,
+  PROFILE_PHASE_DRAW_AXES,
+  PROFILE_PHASE_DRAW_ARTIST,
+  PROFILE_PHASE_BATCH_DRAW,
+  PROFILE_PHASE_TEXT, // labels, legend, title and tooltip
+  PROFILE_PHASE_END_DRAWING, // buffer swap and fps wait
+  PROFILE_PHASE_LEN,
+} ProfilePhase;
+
 typedef struct Artist Artist;
 typedef struct Axes Axes;
 typedef struct Figure Figure;
 typedef struct Limit Limit;
+typedef struct Indicator Indicator;
+
+typedef enum {
+  DATA_TYPE_FLOAT64 = 0,
+  DATA_TYPE_FLOAT32 = 1, // half the memory of float64
+  DATA_TYPE_INT64 = 2,   // e.g epochs or volumes, INT64_MIN reads as NaN
+} DataType;
 
+/**
+the item of column c at `row` is ydata[offsets[c] + row * row_stride], in
+items of `dtype` (ydata is cast). Zeroed layout fields describe float64
+columns `stride` items apart: row-major records (row_stride = fields, stride 1
+or offsets) and numpy views are read in place without a copy. If `last` is not
+NULL the items of row `last_row` are last[c] instead, doubles the figure owns:
+the live bar of a feed read in place, which its producer may be rewriting
+*/
 typedef struct {
   size_t cols;
   double *ydata; // array of len mostly figure->dragger->len_data*cols.
   char *label;   // col labels, of len cols
+  size_t stride; // items between 2 columns of ydata. 0 means dragger._len
+  DataType dtype;
+  size_t row_stride; // items between 2 rows. 0 means 1
+  size_t *offsets;   // first item of each column. NULL means c * stride
+  double *last;      // items of row last_row, or NULL
+  size_t last_row;
 } Gdata;
 
 struct Limit {
@@ -78,10 +143,14 @@ typedef struct {
   size_t _len;      // len of data to being plotted
   size_t start;     // start of currently visible data
   size_t vlen;      // len of visible data on the screen >=1
+  size_t slots;     // drawn items; vlen is decimated to this many if larger
   size_t ulen;      // len of data points to move when updating
   size_t timeframe; // current timeframe in seconds
+  size_t capacity;  // rows allocated once the figure owns the data, else 0
   Locator locator;
-  double *xdata;        // xdata, in epochs shared by all axes
+  XMapping xmapping; // see figure_set_xmapping
+  double slot_fill;  // share of a slot its bars span, < 1 only across gaps
+  double *xdata;        // increasing epochs shared by all axes
   double *xdata_shared; // scaled xdata , in epochs shared by all axes
 } Dragger;
 
@@ -90,21 +159,53 @@ void set_dragger(Figure *figure, size_t len, size_t timeframe, double *xdata,
 
 struct Artist {
   Axes *parent;
-  Artist *next; // next artist if any
   void *data;   // any special data that maybe needed by the artist
+  void *index;  // RangeIndex over gdata used for autoscaling. NULL if no ydata
   Gdata gdata;
   float thickness;
   ArtistType artist_type;
   CFFI_Color *color;
   bool ylim_consider; // whether this artist will be used to find ylims
   bool state_changed;
+  Aggregation aggregation; // of its columns at coarser timeframes
 };
 
 typedef struct {
-  double *data;
+  CFFI_Vector2 *points; // draw ready pixels of LINE_TYPE_S_LINE
+  double *x, *y;        // x pixel and y data of the points before mapping
+  double position;      // data value of LINE_TYPE_H_LINE/LINE_TYPE_V_LINE
+  float pixel;          // and its pixel
   LINE_TYPE line_type;
+  size_t len;      // points
+  size_t tail;     // first point of the last slot
+  size_t capacity; // points allocated, grows with the slots
 } LineData;
 
+/**
+config of ARTIST_TYPE_BAR, NULL is baseline 0 coloured by sign. Bars span from
+`baseline` to their value with the width of a candle body, in color[1] when
+rising and color[0] otherwise. Rising is value >= baseline, or the bar of the
+candle `color_by` (of the same figure) rising, e.g volumes under prices. A slot
+holding several bars draws the value farthest from the baseline
+*/
+typedef struct {
+  double baseline;
+  Artist *color_by; // an ARTIST_TYPE_CANDLE, or NULL
+} BarData;
+
+/**
+config of ARTIST_TYPE_HEATMAP: a time x price grid, e.g resting liquidity. Its
+Gdata has a column per price level: level c spans [price_min + c * price_step,
+price_min + (c + 1) * price_step), and a row per bar. Intensities are shaded
+from color[0] at 0 to color[1] at `intensity_max`, NaN is transparent.
+`intensity_max` <= 0 follows the largest intensity seen. Heatmaps are not
+considered for the ylims unless ylim_consider is set back
+*/
+typedef struct {
+  double price_min, price_step;
+  double intensity_max;
+} HeatmapData;
+
 typedef enum {
   LEGEND_POSITION_NO_LEGEND = 0,
   LEGEND_POSITION_TOP_LEFT = 1,
@@ -124,8 +225,11 @@ struct Axes {
   float ylabel_len, ylabel_padding;
   Figure *parent;
   char *title;
-  Artist *artist;
+  void *artists; // ArtistGroups, the artists packed by ArtistType
   size_t artist_len;
+  void *batch;  // GeomBatch the artists append their geometry to
+  void *layers; // AxesLayers cached between frames
+  void *yticks; // YTicks, the y labels of the decorations layer
   float padding;
   Locator ylocator; // transforms pixel positions to&from data values
   Legend legend;
@@ -153,6 +257,8 @@ struct Figure {
   int font_spacing;
   float zoomx_padding, vertical_limit_drag;
   float border_percentage;
+  float min_refresh; // seconds between frames while nothing changes, 0: every
+                     // frame is drawn. See figure_set_min_refresh
   Dragger dragger;
   char *title, *window_title;
   size_t axes_len;
@@ -165,6 +271,16 @@ struct Figure {
   size_t *border_dimensions;
   CFFI_FONT font;
   void *initialized;
+  void *canvas; // Canvas used by figure_render, NULL until then
+  void *arena;  // Arena owning the figure, its axes and artists
+  void *text_cache; // TextCache of the strings the figure draws
+  void *tooltip;    // text of the tooltip, rebuilt when what it shows changes
+  void *feed;       // FeedReader of the attached Feed, NULL if none
+  void *bar_file;   // BarFile the dragger reads, NULL if none
+  void *publisher;  // Publisher of the changes other threads make while shown
+  void *pacer;      // Pacer deciding when `show` draws
+  void *resampler;  // Resampler of figure_resample
+  void *indicators; // Indicators of create_indicator
   CFFI_Str font_path;
   MouseDrag mouse_drag;
   CFFI_Color axes_frame_color;
@@ -172,7 +288,7 @@ struct Figure {
   CFFI_Color text_color;
   ScreenDimensionState sds;
   bool show_cursors, force_update, has_dragger, clear_screen, show_xlabels,
-      show_ylabels;
+      show_ylabels, show_profiler;
 };
 
 /**
@@ -202,23 +318,240 @@ Figure *create_figure(char *figskel, int *fig_size, char *window_title,
 show calls InitWindow which will then draw the figure on screen
  */
 void show(Figure *figure);
+/**
+frees the figure with its axes and artists. Data passed in by the caller is not
+touched. The window of a shown figure must have been closed
+*/
+void destroy_figure(Figure *figure);
 void figure_set_title(Figure *figure, char *title);
+/**
+`show` only draws while something changes (input, resizes, published data,
+feed bars) and sleeps otherwise, drawing at least every `seconds` so clocks
+and bars updated in place stay current. 0 draws every frame at the target
+fps. Defaults to RC_MIN_REFRESH
+*/
+void figure_set_min_refresh(Figure *figure, float seconds);
 void axes_set_title(Axes *axes, char *title); // set title of the axes
 void axes_set_yformatter(Axes *axes, char *formatter);
 void axes_show_legend(Axes *axes, LegendPosition legend_position);
+/**
+shows the bars whose epochs are in [xminmax[0], xminmax[1]], or goes to the
+next bar if there are none
+*/
 void figure_set_xlim(Figure *figure, double xminmax[2]);
+/**
+shows the bar at or after `epoch` (the last one if none) in the middle of the
+window, keeping its width. O(log n): a binary search of the xdata
+*/
+void figure_goto_time(Figure *figure, double epoch);
+/**
+writes the rows [range[0], range[1]) of the bars whose epochs are in [from, to]
+and returns how many there are. Reads the xdata: call it from the thread that
+changes the data
+*/
+size_t figure_time_range(Figure *figure, double from, double to,
+                         size_t range[2]);
+/**
+how bars are placed along the x-axis, see XMapping. Defaults to X_MAPPING_INDEX
+*/
+void figure_set_xmapping(Figure *figure, XMapping xmapping);
+/**
+shows the bars aggregated to `timeframe` seconds, a multiple of the timeframe
+of set_dragger (which shows the bars as they are). Buckets are aligned to
+1970-01-01 UTC, weeks to Mondays, and each artist's columns are combined by its
+Aggregation. Levels are cached: appends and artist_update_last keep the shown
+one current in O(1). Not for figures with a feed
+*/
+void figure_resample(Figure *figure, size_t timeframe);
+/**
+the timeframes the keys 1 to `len` (at most 9) show while the window is open
+*/
+void figure_set_timeframes(Figure *figure, size_t *timeframes, size_t len);
+/**
+rows of the bars of set_dragger, dragger._len being the rows shown
+*/
+size_t figure_base_len(Figure *figure);
+/**
+how figure_resample combines the rows of a bucket. Defaults to AGGREGATION_OHLC
+for candles and AGGREGATION_LAST for other artists
+*/
+void artist_set_aggregation(Artist *artist, Aggregation aggregation);
+/**
+computes the indicator `type` of cmnfunc.py over `source` into `outputs`
+(indicator_outputs(type) line artists with data) and keeps them current:
+artist_update_last of the source updates the last row of the outputs in O(1)
+(and the rows of bars appended since the previous update, if several were),
+artist_set_data recomputes them. Indicators may feed others through their
+outputs. STOCH, ADX and ATR read a candle (high, low, close), the others the
+last column of the source. Must be called before `show` or from its thread,
+not for figures with a feed
+*/
+Indicator *create_indicator(Artist *source, IndicatorType type, size_t *params,
+                            Artist **outputs);
+size_t indicator_outputs(IndicatorType type);
+/**
+the indicator over `len` rows of hlc (high, low and close columns, high and low
+may be NULL unless STOCH, ADX or ATR) into indicator_outputs(type) columns
+*/
+void indicator_compute(IndicatorType type, size_t *params, double **hlc,
+                       size_t len, double **outputs);
 void update_timeframe(Figure *figure,
                       size_t timeframe); // set a new timeframe
 void axes_set_ylim(Axes *axes, double yminmax[2]);
+/**
+ydata_minmax may be NULL in which case the limits are taken from the artist's
+range index. Once the figure owns its data (figure_append_bar,
+artist_update_last) `gdata` is copied in rather than read in place
+*/
 Artist *create_artist(Axes *axes, ArtistType artist_type, Gdata gdata,
                       double ydata_minmax[2], float thickness,
                       CFFI_Color *color, void *config);
+void artist_set_data(Artist *artist,
+                     double *ydata); // swap ydata and rebuild its range index
+/**
+artist_set_data for data laid out as `view` describes (gdata.cols columns, a
+stride of 0 meaning dragger._len), read in place until the figure owns copies
+*/
+void artist_set_view(Artist *artist, Gdata view);
+/**
+appends a bar at epoch `x` to the figure. every artist with data gets a NaN row
+that is then filled with `artist_update_last`. The first call copies xdata and
+all ydata into growable buffers owned by the figure, and so does every call
+that outgrows them (doubling them): those calls cost O(history) on the frame
+they run on, the others O(1). Call `figure_reserve` before `show` to pay for
+the copy up front. If the window is showing the last bar, it moves forward by
+one bar
+*/
+void figure_append_bar(Figure *figure, double x);
+/**
+moves xdata and all ydata into buffers owned by the figure holding at least
+`rows` bars, so that appends up to `rows` bars never copy the history. Call it
+after the artists are created, before `show` or from its thread. Not for
+figures with a feed
+*/
+void figure_reserve(Figure *figure, size_t rows);
+/**
+sets the last row of the artist to `values` (gdata.cols items) and only
+recomputes the last slot unless the ylims changed. The first call copies the
+data of the figure into buffers it owns, as figure_append_bar does: the data
+passed to create_artist or artist_set_view is never written
+*/
+void artist_update_last(Artist *artist, double *values);
+void figure_set_xdata(Figure *figure, double *xdata); // len must be dragger._len
+/**
+while `show` runs on another thread, the 6 functions above,
+update_from_position, figure_set_xlim, figure_goto_time, figure_set_xmapping
+and figure_resample only publish their change; the render thread applies it
+at the start of its next frame, without tearing. Changes made between
+figure_publish_begin and figure_publish_end (which may nest) are applied in
+the same frame. Data passed to them must stay valid until the next change is
+published
+*/
+void figure_publish_begin(Figure *figure);
+void figure_publish_end(Figure *figure);
+/**
+a Feed is a ring of `capacity` bars in POSIX shared memory ("/name"), written
+by a single producer process and read by any number of figures without locks.
+Every bar has an epoch and `cols` values. Bars are published in time order with
+sequence numbers 0,1,2...; the producer never waits, a reader that falls more
+than `capacity` bars behind loses the oldest ones. See feed.h for the layout.
+feed_create and feed_open return NULL if the shared memory cannot be mapped
+*/
+typedef struct Feed Feed;
+Feed *feed_create(char *name, size_t cols, size_t capacity, size_t timeframe);
+Feed *feed_open(char *name); // read only
+void feed_close(Feed *feed); // unmaps; attached figures must be destroyed first
+bool feed_unlink(char *name); // removes the name, mappings stay valid
+void feed_publish(Feed *feed, double x, double *values); // values: cols items
+void feed_update_last(Feed *feed, double *values); // rewrites the last bar
+uint64_t feed_published(Feed *feed); // bars published so far
+size_t feed_cols(Feed *feed);
+/**
+sets the dragger of the figure to the bars of `feed` and picks up new and
+updated bars at the start of every frame. At least one bar must be published.
+While the ring has not wrapped and at most half of it is used, the figure reads
+it in place; after that new bars are copied into buffers owned by the figure as
+they arrive, as with `figure_append_bar`. The ring should hold many more bars
+than the producer publishes between two frames
+*/
+void figure_attach_feed(Figure *figure, Feed *feed, FormatterType ftype,
+                        char *format);
+/**
+Gdata of the `cols` value columns of the attached feed starting at `col`, to
+create artists with. Such artists are updated by the feed only
+*/
+Gdata figure_feed_gdata(Figure *figure, size_t col, size_t cols, char *label);
+/**
+a BarFile holds `rows` bars (epochs and `cols` value columns) in columns a
+figure maps instead of loading; see bar_file.h. Opening one reads none of its
+rows, they are paged in as they are drawn and the page cache is shared by every
+process mapping the file
+*/
+typedef struct BarFile BarFile;
+/**
+writes `xdata` and the gdata.cols columns of `gdata.ydata` (gdata.stride items
+apart, 0 means rows) to `path`, replacing it atomically. `names` has gdata.cols
+column names or is NULL. returns false if the file cannot be written
+*/
+bool bar_file_write(char *path, size_t rows, size_t timeframe, double *xdata,
+                    Gdata gdata, char **names);
+BarFile *bar_file_open(char *path); // NULL if it cannot be mapped
+void bar_file_close(BarFile *file); // figures reading it must be destroyed first
+size_t bar_file_rows(BarFile *file);
+size_t bar_file_cols(BarFile *file);
+long bar_file_find(BarFile *file, char *name); // value column or -1
+/**
+sets the dragger of the figure to the bars of `file`, see `set_dragger`
+*/
+void figure_attach_bar_file(Figure *figure, BarFile *file, FormatterType ftype,
+                            char *format);
+/**
+Gdata of the `cols` value columns of `file` starting at `col`. Artists created
+with it on a figure attached to `file` build their range index from the block
+summaries of the file instead of its rows
+*/
+Gdata bar_file_gdata(BarFile *file, size_t col, size_t cols, char *label);
+/**
+renders the figure into a CPU framebuffer of fig_size, without a window or
+GL, and copies it to `pixels` (width*height*4 bytes, RGBA rows from the top)
+unless NULL. Can be called any number of times, e.g after updating data, but a
+rendered figure cannot be shown
+*/
+void figure_render(Figure *figure, uint8_t *pixels);
+/**
+renders like `figure_render` and writes a PNG if `path` ends with ".png",
+otherwise raw RGBA. returns false if the file cannot be written
+*/
+bool figure_render_to_file(Figure *figure, char *path);
+void figure_set_size(Figure *figure, int width,
+                     int height); // size of the next render
+/**
+the profiler times each ProfilePhase of the render loop. It is off by default;
+while off the timers cost about one branch each. KEY_P (or
+`figure->show_profiler`) toggles it together with an on screen overlay
+*/
+void profiler_enable(bool enable);
+void profiler_reset(void); // drop all samples and trace events
+/**
+`q` in [0,1] quantile, in microseconds, of the time spent in `phase` per frame
+over the last RC_PROFILER_WINDOW frames in which it ran. NaN if none
+*/
+double profiler_percentile(ProfilePhase phase, double q);
+size_t profiler_samples(ProfilePhase phase); // frames in the window
+const char *profiler_phase_name(ProfilePhase phase);
+/**
+enables the profiler and records every timed phase, keeping the last
+`max_events`, until `profiler_trace_stop`
+*/
+void profiler_trace_start(size_t max_events);
+void profiler_trace_stop(void);
+bool profiler_trace_dump(char *path); // Chrome trace event JSON
 void update_from_position(
     size_t new_position,
     Figure *figure); // sets the current postion to
                      // `new_position` and updates all artists
 Axes *get_axes_under_mouse(Figure *figure);
-void lib_free(); // frees all allocated memory
+void lib_free(); // frees every cust_malloc allocation; figures use destroy_figure
 void figure_wait_initialized(Figure *figure);
 
 
@@ -254,7 +587,11 @@ void raylib_init_loop();            // routines for raylib  in each loop
 bool update_figure(Figure *figure); // main update
 
 #define RC_LABEL_FONT_SIZE 16
-#define RC_MAX_PLOTTABLE_LEN 500
+#define RC_MAX_PLOTTABLE_LEN 500 // max slots; wider windows are decimated
+#define RC_LOD_SLOT_PIXELS 2     // min width in pixels of one slot
+#define RC_LOD_LINE_POINTS 4     // first, min, max and last of a slot
+#define RC_LOD_ALIGN 8           // slots this many range index blocks (or
+                                 // grains) wide start on one
 #define RC_UPDATE_LEN 10
 #define RC_INITIAL_VISIBLE_DATA 120
 
@@ -0,0 +1,532 @@
+#include "resample.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "artist.h"
+#include "figure.h"
+#include "gdata.h"
+#include "publish.h"
+#include "time_index.h"
+#include "utils.h"
+
+#define RC_RESAMPLE_WEEK 604800
+#define RC_RESAMPLE_MONDAY 345600  // 1970-01-05, weeks are aligned to it
+#define RC_RESAMPLE_MIN_CAPACITY 64 // level rows allocated at first
+
+static void resample_select(Figure *figure, size_t timeframe);
+static Level *resample_level(Figure *figure, size_t timeframe);
+static void resample_level_destroy(Resampler *resampler, Level *level);
+static void resample_level_reserve(Resampler *resampler, Level *level,
+                                   size_t rows);
+static void resample_sync_artist(Figure *figure, Level *level, size_t a,
+                                 size_t from, size_t len, bool rebuild);
+static void resample_sync(Figure *figure, Level *level);
+static void resample_take_base(Figure *figure);
+static void resample_put_base(Figure *figure);
+static void resample_put_level(Figure *figure, Level *level);
+
+static inline Resampler *resampler_of(Figure *figure) {
+  return (Resampler *)figure->resampler;
+}
+
+// the base is what the dragger and artists hold, not a level
+static inline bool resample_base_in_figure(const Resampler *resampler) {
+  return resampler->shown == NULL || resampler->base_depth > 0;
+}
+
+/**
+the start of the calendar bucket of `timeframe` seconds holding `epoch`
+*/
+static inline double resample_bucket(double epoch, size_t timeframe) {
+  double origin = timeframe % RC_RESAMPLE_WEEK == 0 ? RC_RESAMPLE_MONDAY : 0;
+  return floor((epoch - origin) / timeframe) * timeframe + origin;
+}
+
+static inline Aggregation resample_aggregation(const Artist *artist,
+                                               size_t col) {
+  static const Aggregation ohlc[4] = {AGGREGATION_FIRST, AGGREGATION_MAX,
+                                      AGGREGATION_MIN, AGGREGATION_LAST};
+  return artist->aggregation == AGGREGATION_OHLC ? ohlc[col % 4]
+                                                 : artist->aggregation;
+}
+
+/**
+`acc`, the aggregate of some rows, combined with the next row `value`. NaN
+rows (bars not filled yet) are skipped
+*/
+static inline double resample_combine(Aggregation aggregation, double acc,
+                                      double value) {
+  switch (aggregation) {
+  case AGGREGATION_FIRST:
+    return isnan(acc) ? value : acc;
+  case AGGREGATION_MAX:
+    return fmax(acc, value);
+  case AGGREGATION_MIN:
+    return fmin(acc, value);
+  case AGGREGATION_SUM:
+    return isnan(acc) ? value : isnan(value) ? acc : acc + value;
+  case AGGREGATION_LAST:
+  default:
+    return isnan(value) ? acc : value;
+  }
+}
+
+Resampler *resampler_create(Arena *arena) {
+  Resampler *resampler = arena_alloc(arena, sizeof(Resampler));
+  *resampler = (Resampler){.levels = NULL, .shown = NULL, .arena = arena};
+  return resampler;
+}
+
+void resampler_reset(Figure *figure) {
+  Resampler *resampler = resampler_of(figure);
+  RC_ASSERT(resampler->shown == NULL,
+            "artists cannot be created while a coarser timeframe is shown\n");
+  for (size_t i = 0; i < resampler->levels_len; ++i)
+    resample_level_destroy(resampler, resampler->levels[i]);
+  resampler->levels_len = 0;
+  size_t len = resampler->artists_len;
+  arena_release(resampler->arena, resampler->artists, sizeof(Artist *) * len);
+  arena_release(resampler->arena, resampler->base, sizeof(BaseArtist) * len);
+  resampler->artists = NULL;
+  resampler->base = NULL;
+  resampler->artists_len = 0;
+}
+
+size_t resample_base_len(Figure *figure) {
+  Resampler *resampler = resampler_of(figure);
+  return resample_base_in_figure(resampler) ? figure->dragger._len
+                                            : resampler->len;
+}
+
+size_t resample_base_capacity(Figure *figure) {
+  Resampler *resampler = resampler_of(figure);
+  return resample_base_in_figure(resampler) ? figure->dragger.capacity
+                                            : resampler->capacity;
+}
+
+size_t figure_base_len(Figure *figure) { return resample_base_len(figure); }
+
+/**
+the base timestamps and the base gdata of the artist `a` of the resampler
+*/
+static inline const double *resample_base_xdata(Figure *figure) {
+  Resampler *resampler = resampler_of(figure);
+  return resample_base_in_figure(resampler) ? figure->dragger.xdata
+                                            : resampler->xdata;
+}
+
+static inline const Gdata *resample_base_gdata(Figure *figure, size_t a) {
+  Resampler *resampler = resampler_of(figure);
+  return resample_base_in_figure(resampler) ? &resampler->artists[a]->gdata
+                                            : &resampler->base[a].gdata;
+}
+
+static size_t resample_artist(Resampler *resampler, Artist *artist) {
+  for (size_t a = 0; a < resampler->artists_len; ++a) {
+    if (resampler->artists[a] == artist)
+      return a;
+  }
+  RC_ERROR("the artist was created after the timeframes were resampled\n");
+  return 0;
+}
+
+const Gdata *resample_artist_base(Artist *artist) {
+  Resampler *resampler = resampler_of(artist->parent->parent);
+  if (resample_base_in_figure(resampler))
+    return &artist->gdata;
+  return &resampler->base[resample_artist(resampler, artist)].gdata;
+}
+
+static void resample_take_base(Figure *figure) {
+  Resampler *resampler = resampler_of(figure);
+  Dragger *dragger = &figure->dragger;
+  resampler->xdata = dragger->xdata;
+  resampler->len = dragger->_len;
+  resampler->capacity = dragger->capacity;
+  resampler->timeframe = dragger->timeframe;
+  for (size_t a = 0; a < resampler->artists_len; ++a) {
+    Artist *artist = resampler->artists[a];
+    resampler->base[a] =
+        (BaseArtist){.gdata = artist->gdata, .index = artist->index};
+  }
+}
+
+static void resample_put_base(Figure *figure) {
+  Resampler *resampler = resampler_of(figure);
+  Dragger *dragger = &figure->dragger;
+  dragger->xdata = resampler->xdata;
+  dragger->_len = resampler->len;
+  dragger->capacity = resampler->capacity;
+  dragger->timeframe = resampler->timeframe;
+  for (size_t a = 0; a < resampler->artists_len; ++a) {
+    Artist *artist = resampler->artists[a];
+    artist->gdata = resampler->base[a].gdata;
+    artist->index = resampler->base[a].index;
+  }
+}
+
+static void resample_put_level(Figure *figure, Level *level) {
+  Resampler *resampler = resampler_of(figure);
+  Dragger *dragger = &figure->dragger;
+  dragger->xdata = level->xdata;
+  dragger->_len = level->len;
+  dragger->capacity = level->capacity;
+  dragger->timeframe = level->timeframe;
+  for (size_t a = 0; a < resampler->artists_len; ++a) {
+    Artist *artist = resampler->artists[a];
+    gdata_set_native(&artist->gdata, level->artists[a].ydata,
+                     level->capacity);
+    artist->index = level->artists[a].index;
+  }
+}
+
+/**
+the level of `timeframe`, created empty the first time. The artists it holds
+columns for are the ones with data when the first level is created
+*/
+static Level *resample_level(Figure *figure, size_t timeframe) {
+  Resampler *resampler = resampler_of(figure);
+  for (size_t i = 0; i < resampler->levels_len; ++i) {
+    if (resampler->levels[i]->timeframe == timeframe)
+      return resampler->levels[i];
+  }
+  Arena *arena = resampler->arena;
+  if (resampler->levels_len == 0) {
+    size_t len = 0;
+    for (size_t i = 0; i < figure->axes_len; ++i) {
+      for (size_t a = 0; a < figure->axes[i].artist_len; ++a)
+        len += get_artist(figure->axes + i, a)->index != NULL;
+    }
+    resampler->artists = arena_alloc(arena, sizeof(Artist *) * len);
+    resampler->base = arena_alloc(arena, sizeof(BaseArtist) * len);
+    resampler->artists_len = 0;
+    for (size_t i = 0; i < figure->axes_len; ++i) {
+      for (size_t a = 0; a < figure->axes[i].artist_len; ++a) {
+        Artist *artist = get_artist(figure->axes + i, a);
+        if (artist->index != NULL)
+          resampler->artists[resampler->artists_len++] = artist;
+      }
+    }
+  }
+  Level *level = arena_alloc(arena, sizeof(Level));
+  *level = (Level){.timeframe = timeframe, .xdata = NULL, .first_rows = NULL};
+  level->artists =
+      arena_alloc(arena, sizeof(LevelArtist) * resampler->artists_len);
+  for (size_t a = 0; a < resampler->artists_len; ++a) {
+    size_t cols = resampler->artists[a]->gdata.cols;
+    level->artists[a] = (LevelArtist){
+        .ydata = NULL,
+        .index = NULL,
+        .prev = arena_alloc(arena, sizeof(double) * cols),
+    };
+  }
+  if (resampler->levels_len == resampler->levels_capacity) {
+    size_t capacity = maxl(resampler->levels_capacity * 2, RC_RESAMPLE_KEYS);
+    resampler->levels = arena_resize(
+        arena, resampler->levels, sizeof(Level *) * resampler->levels_capacity,
+        sizeof(Level *) * capacity);
+    resampler->levels_capacity = capacity;
+  }
+  resampler->levels[resampler->levels_len++] = level;
+  return level;
+}
+
+static void resample_level_destroy(Resampler *resampler, Level *level) {
+  Arena *arena = resampler->arena;
+  for (size_t a = 0; a < resampler->artists_len; ++a) {
+    LevelArtist *columns = level->artists + a;
+    size_t cols = resampler->artists[a]->gdata.cols;
+    arena_release(arena, columns->ydata,
+                  sizeof(double) * cols * level->capacity);
+    arena_release(arena, columns->prev, sizeof(double) * cols);
+    if (columns->index != NULL)
+      range_index_destroy(columns->index);
+  }
+  arena_release(arena, level->artists,
+                sizeof(LevelArtist) * resampler->artists_len);
+  arena_release(arena, level->xdata, sizeof(double) * level->capacity);
+  arena_release(arena, level->first_rows, sizeof(size_t) * level->capacity);
+  arena_release(arena, level, sizeof(Level));
+}
+
+static void resample_level_reserve(Resampler *resampler, Level *level,
+                                   size_t rows) {
+  if (rows <= level->capacity)
+    return;
+  Arena *arena = resampler->arena;
+  size_t capacity =
+      maxl(maxl(level->capacity * 2, rows), RC_RESAMPLE_MIN_CAPACITY);
+  level->xdata = arena_resize(arena, level->xdata,
+                              sizeof(double) * level->capacity,
+                              sizeof(double) * capacity);
+  level->first_rows = arena_resize(arena, level->first_rows,
+                                   sizeof(size_t) * level->capacity,
+                                   sizeof(size_t) * capacity);
+  for (size_t a = 0; a < resampler->artists_len; ++a) {
+    LevelArtist *columns = level->artists + a;
+    size_t cols = resampler->artists[a]->gdata.cols;
+    double *ydata = arena_alloc(arena, sizeof(double) * cols * capacity);
+    for (size_t c = 0; c < cols && level->len > 0; ++c)
+      memcpy(ydata + c * capacity, columns->ydata + c * level->capacity,
+             sizeof(double) * level->len);
+    arena_release(arena, columns->ydata,
+                  sizeof(double) * cols * level->capacity);
+    columns->ydata = ydata;
+  }
+  level->capacity = capacity;
+}
+
+/**
+recomputes the rows [from, level->len) of the columns of the artist `a` from
+the first `len` base rows. The last bucket continues from its aggregate without
+the last base row if the level saw part of it, so it costs O(1) per new row
+*/
+static void resample_sync_artist(Figure *figure, Level *level, size_t a,
+                                 size_t from, size_t len, bool rebuild) {
+  Resampler *resampler = resampler_of(figure);
+  Artist *artist = resampler->artists[a];
+  LevelArtist *columns = level->artists + a;
+  const Gdata *base = resample_base_gdata(figure, a);
+  for (size_t c = 0; c < base->cols; ++c) {
+    Aggregation aggregation = resample_aggregation(artist, c);
+    double *out = columns->ydata + c * level->capacity;
+    for (size_t k = from; k < level->len; ++k) {
+      size_t first = level->first_rows[k], row = first;
+      size_t end = k + 1 < level->len ? level->first_rows[k + 1] : len;
+      double acc = NAN;
+      if (k == from && level->base_len > first) { // continue the cached one
+        acc = columns->prev[c];
+        row = level->base_len - 1;
+      }
+      for (; row + 1 < end; ++row)
+        acc = resample_combine(aggregation, acc, gdata_get(base, c, row));
+      columns->prev[c] = acc;
+      out[k] =
+          resample_combine(aggregation, acc, gdata_get(base, c, end - 1));
+    }
+  }
+  Gdata gdata = {.cols = base->cols,
+                 .ydata = columns->ydata,
+                 .label = base->label,
+                 .stride = level->capacity};
+  if (columns->index == NULL) {
+    columns->index =
+        range_index_create(resampler->arena, &gdata, level->len, gdata.stride);
+  } else if (rebuild) {
+    range_index_rebuild(columns->index, &gdata, level->len, gdata.stride);
+  } else {
+    range_index_resize(columns->index, &gdata, level->len);
+    for (size_t row = from; row < level->len;
+         row = (row / RC_RANGE_INDEX_BLOCK + 1) * RC_RANGE_INDEX_BLOCK)
+      range_index_update(columns->index, &gdata, row);
+  }
+}
+
+/**
+aggregates the base rows `level` has not seen yet, and the last one it has as
+it may have been updated since. Rows of the level before its last bucket never
+change: only that bucket is recomputed
+*/
+static void resample_sync(Figure *figure, Level *level) {
+  Resampler *resampler = resampler_of(figure);
+  const double *xdata = resample_base_xdata(figure);
+  size_t len = resample_base_len(figure), capacity = level->capacity;
+  bool rebuild = level->stale;
+  if (level->stale) {
+    level->len = level->base_len = 0;
+    level->stale = false;
+  }
+  size_t from = level->len > 0 ? level->len - 1 : 0; // first row recomputed
+  for (size_t row = level->base_len; row < len; ++row) {
+    double bucket = resample_bucket(xdata[row], level->timeframe);
+    if (level->len > 0 && bucket == level->xdata[level->len - 1])
+      continue;
+    resample_level_reserve(resampler, level, level->len + 1);
+    level->xdata[level->len] = bucket;
+    level->first_rows[level->len++] = row;
+  }
+  rebuild = rebuild || capacity != level->capacity;
+  for (size_t a = 0; a < resampler->artists_len; ++a)
+    resample_sync_artist(figure, level, a, from, len, rebuild);
+  level->base_len = len;
+}
+
+void resample_base_enter(Figure *figure) {
+  Resampler *resampler = resampler_of(figure);
+  if (resampler->shown == NULL || resampler->base_depth++ > 0)
+    return; // nested, figure_set_xdata applying a published op
+  resampler->start = figure->dragger.start;
+  resampler->vlen = figure->dragger.vlen;
+  resample_put_base(figure);
+}
+
+void resample_base_leave(Figure *figure, bool replaced) {
+  Resampler *resampler = resampler_of(figure);
+  for (size_t i = 0; replaced && i < resampler->levels_len; ++i)
+    resampler->levels[i]->stale = true; // rebuilt once by resample_refresh
+  if (resampler->shown == NULL || --resampler->base_depth > 0)
+    return;
+  resample_take_base(figure);
+  if (!resampler->shown->stale)
+    resample_sync(figure, resampler->shown);
+  resample_put_level(figure, resampler->shown);
+  figure->dragger.start = resampler->start;
+  figure->dragger.vlen = resampler->vlen;
+}
+
+bool resample_append_bar(Figure *figure, double x) {
+  Resampler *resampler = resampler_of(figure);
+  if (resampler->shown == NULL)
+    return false;
+  Dragger *dragger = &figure->dragger;
+  bool follow = dragger->start + dragger->vlen == dragger->_len;
+  size_t len = dragger->_len;
+  resample_base_enter(figure);
+  figure_append_rows(figure, &x, 1);
+  resample_base_leave(figure, false);
+  if (follow && dragger->_len > len)
+    update_from_position(dragger->start + 1, figure);
+  return true;
+}
+
+void resample_base_rewritten(Figure *figure, size_t row) {
+  Resampler *resampler = resampler_of(figure);
+  for (size_t i = 0; i < resampler->levels_len; ++i) {
+    Level *level = resampler->levels[i];
+    if (level->stale || level->base_len <= row)
+      continue; // the rows are new to it
+    size_t k = level->len - 1;
+    while (level->first_rows[k] > row)
+      --k;
+    level->len = k + 1; // bucket k is aggregated again from its first row
+    level->base_len = level->first_rows[k];
+  }
+}
+
+bool resample_update_last(Artist *artist, double *values) {
+  Figure *figure = artist->parent->parent;
+  Resampler *resampler = resampler_of(figure);
+  if (resampler->shown == NULL)
+    return false;
+  Level *level = resampler->shown;
+  size_t a = resample_artist(resampler, artist), row = resampler->len - 1;
+  BaseArtist *base = resampler->base + a;
+  for (size_t c = 0; c < base->gdata.cols; ++c)
+    gdata_set(&base->gdata, c, row, values[c]);
+  range_index_update(base->index, &base->gdata, row);
+  if (level->stale)
+    return true; // the level is rebuilt from it anyway
+  // appends synced the rows, only the last bucket of this artist changes
+  resample_sync_artist(figure, level, a, level->len - 1, resampler->len, false);
+  artist_last_changed(artist);
+  return true;
+}
+
+void resample_key(Figure *figure, size_t key) {
+  Resampler *resampler = resampler_of(figure);
+  RC_ASSERT(key < resampler->keys_len);
+  resampler->pending = resampler->keys[key];
+  figure->force_update = true; // a frame shows it
+}
+
+void resample_refresh(Figure *figure) {
+  Resampler *resampler = resampler_of(figure);
+  Level *shown = resampler->shown;
+  if (shown != NULL && shown->stale) {
+    Dragger *dragger = &figure->dragger;
+    resample_sync(figure, shown);
+    resample_put_level(figure, shown);
+    dragger->vlen = minl(dragger->vlen, dragger->_len);
+    dragger->start = minl(dragger->start, dragger->_len - dragger->vlen);
+    figure->force_update = true;
+  }
+  if (resampler->pending != 0) {
+    resample_select(figure, resampler->pending);
+    resampler->pending = 0;
+  }
+}
+
+/**
+shows the bars of `timeframe`: the base if it is its timeframe, else the level
+of `timeframe`. The window keeps its number of bars and the time in its middle,
+or keeps showing the last bar
+*/
+static void resample_select(Figure *figure, size_t timeframe) {
+  Resampler *resampler = resampler_of(figure);
+  Dragger *dragger = &figure->dragger;
+  size_t base_timeframe =
+      resampler->shown ? resampler->timeframe : dragger->timeframe;
+  RC_ASSERT(timeframe >= base_timeframe,
+            "timeframe %zu is finer than the %zu of the bars\n", timeframe,
+            base_timeframe);
+  RC_ASSERT(timeframe % base_timeframe == 0,
+            "timeframe %zu is not a multiple of the %zu of the bars\n",
+            timeframe, base_timeframe);
+  Level *level =
+      timeframe == base_timeframe ? NULL : resample_level(figure, timeframe);
+  if (level == resampler->shown)
+    return;
+  bool follow = dragger->start + dragger->vlen == dragger->_len;
+  double middle = dragger->xdata[dragger->start + dragger->vlen / 2];
+  size_t vlen = dragger->vlen;
+  if (resampler->shown == NULL)
+    resample_take_base(figure);
+  if (level == NULL) {
+    resample_put_base(figure);
+  } else {
+    resampler->shown = level; // the base is read from where it was just saved
+    resample_sync(figure, level);
+    resample_put_level(figure, level);
+  }
+  resampler->shown = level;
+  dragger->vlen = minl(vlen, dragger->_len);
+  size_t row = time_index_lower_bound(
+      dragger->xdata, dragger->_len,
+      level ? resample_bucket(middle, timeframe) : middle);
+  row = minl(row, dragger->_len - 1);
+  size_t start = row > dragger->vlen / 2 ? row - dragger->vlen / 2 : 0;
+  if (follow)
+    start = dragger->_len - dragger->vlen;
+  dragger->start = minl(start, dragger->_len - dragger->vlen);
+  figure->force_update = true;
+}
+
+void figure_resample(Figure *figure, size_t timeframe) {
+  RC_ASSERT(figure->has_dragger, "call `set_dragger` first\n");
+  RC_ASSERT(figure->feed == NULL, "figures with a feed cannot be resampled\n");
+  if (publish_resample(figure, timeframe))
+    return;
+  resample_select(figure, timeframe);
+}
+
+void figure_set_timeframes(Figure *figure, size_t *timeframes, size_t len) {
+  RC_ASSERT(figure->has_dragger, "call `set_dragger` first\n");
+  Resampler *resampler = resampler_of(figure);
+  RC_ASSERT(len <= RC_RESAMPLE_KEYS, "at most %d timeframes have keys\n",
+            RC_RESAMPLE_KEYS);
+  RC_ASSERT(!publish_deferred(figure),
+            "'%s' must be called before `show` or from its thread\n",
+            RC_ECHO(figure_set_timeframes));
+  size_t base_timeframe =
+      resampler->shown ? resampler->timeframe : figure->dragger.timeframe;
+  for (size_t i = 0; i < len; ++i) // checked now rather than on a key press
+    RC_ASSERT(timeframes[i] > 0 && timeframes[i] % base_timeframe == 0,
+              "timeframe %zu is not a multiple of the %zu of the bars\n",
+              timeframes[i], base_timeframe);
+  memcpy(resampler->keys, timeframes, sizeof(size_t) * len);
+  resampler->keys_len = len;
+}
+
+void artist_set_aggregation(Artist *artist, Aggregation aggregation) {
+  Figure *figure = artist->parent->parent;
+  Resampler *resampler = resampler_of(figure);
+  RC_ASSERT(aggregation != AGGREGATION_OHLC || artist->gdata.cols == 4,
+            "only artists of 4 columns are aggregated as OHLC\n");
+  RC_ASSERT(!publish_deferred(figure),
+            "'%s' must be called before `show` or from its thread\n",
+            RC_ECHO(artist_set_aggregation));
+  artist->aggregation = aggregation;
+  for (size_t i = 0; i < resampler->levels_len; ++i)
+    resampler->levels[i]->stale = true;
+}
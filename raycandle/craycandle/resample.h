@@ -0,0 +1,116 @@
+/*
+ * Resampler
+ * ---------
+ * shows the bars of the figure (the base) at coarser timeframes without
+ * leaving C. A Level holds the base aggregated to one timeframe: its rows are
+ * calendar aligned buckets (multiples of the timeframe since 1970-01-01 UTC,
+ * weeks start on Monday) and every artist column is combined by the
+ * artist's Aggregation: candles take O=first, H=max, L=min, C=last, lines the
+ * last value unless set otherwise (AGGREGATION_SUM for volumes).
+ *
+ * Levels are built on demand and cached. Each one remembers how many base rows
+ * it aggregated and the aggregate of its last bucket without the last base
+ * row, so that new bars and artist_update_last cost O(1) per level: the shown
+ * level follows the base as it changes, the others catch up when shown again.
+ * Replacing the base (figure_set_xdata, artist_set_data) rebuilds them.
+ *
+ * Showing a level swaps its xdata, ydata and RangeIndexes into the dragger and
+ * artists, so drawing and navigation do not know about it; changes to the
+ * base swap the base back in while they are applied. Feeds cannot be resampled.
+ */
+#ifndef __RAYCANDLE_RESAMPLE__
+#define __RAYCANDLE_RESAMPLE__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "arena.h"
+#include "range_index.h"
+#include "raycandle.h"
+
+#define RC_RESAMPLE_KEYS 9 // timeframes selected with the keys 1 to 9
+
+typedef struct {
+  double *ydata;     // the artist's gdata.cols columns of Level.capacity rows
+  RangeIndex *index; // over ydata, NULL until the level has rows
+  double *prev;      // per column, the last bucket without its last base row
+} LevelArtist;
+
+typedef struct {
+  size_t timeframe;
+  double *xdata;        // bucket starts
+  size_t *first_rows;   // base row each bucket starts at
+  size_t len, capacity;
+  size_t base_len;      // base rows aggregated
+  bool stale;           // the base was replaced, aggregate it again from row 0
+  LevelArtist *artists; // one per Resampler.artists
+} Level;
+
+typedef struct {
+  Gdata gdata;
+  RangeIndex *index;
+} BaseArtist;
+
+typedef struct {
+  Level **levels;
+  size_t levels_len, levels_capacity;
+  Level *shown;      // NULL while the base is
+  size_t base_depth; // nested resample_base_enter, the base is swapped in
+  // the base while a level is shown
+  double *xdata;
+  size_t len, capacity, timeframe;
+  size_t start, vlen; // window of the shown level while the base is entered
+  Artist **artists;   // with data, when the first level was built
+  BaseArtist *base;   // of `artists`
+  size_t artists_len;
+  size_t keys[RC_RESAMPLE_KEYS]; // see figure_set_timeframes
+  size_t keys_len;
+  size_t pending; // timeframe of a key, shown once no writer holds the lock
+  Arena *arena;
+} Resampler;
+
+Resampler *resampler_create(Arena *arena);
+/**
+drops every level. Called when an artist with data is created
+*/
+void resampler_reset(Figure *figure);
+/**
+rows of the base, whether or not a level is shown
+*/
+size_t resample_base_len(Figure *figure);
+size_t resample_base_capacity(Figure *figure);
+/**
+the base rows of `artist`, whether or not a level is shown
+*/
+const Gdata *resample_artist_base(Artist *artist);
+/**
+swaps the base back in if a level is shown, for a change to be applied to it.
+resample_base_leave shows the level again, `replaced` if the change replaced
+the base data rather than appending to it
+*/
+void resample_base_enter(Figure *figure);
+void resample_base_leave(Figure *figure, bool replaced);
+/**
+the shown level side of figure_append_bar and artist_update_last, called first
+by them. Each returns false if the base is shown and the caller applies the
+change itself
+*/
+bool resample_append_bar(Figure *figure, double x);
+bool resample_update_last(Artist *artist, double *values);
+/**
+base rows from `row` on were rewritten, between resample_base_enter and
+resample_base_leave: every level aggregates them again from the bucket holding
+`row` the next time it syncs, instead of only its last bucket
+*/
+void resample_base_rewritten(Figure *figure, size_t row);
+/**
+the timeframe of the key `key` (0 for the key 1) is shown by resample_refresh
+*/
+void resample_key(Figure *figure, size_t key);
+/**
+at the start of a frame, after the published changes: rebuilds the shown level
+if the base was replaced and shows the timeframe of a pressed key
+*/
+void resample_refresh(Figure *figure);
+
+#endif //__RAYCANDLE_RESAMPLE__
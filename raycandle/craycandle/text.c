@@ -0,0 +1,175 @@
+#include "text.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "canvas.h"
+
+#define RC_TEXT_DEFAULT_FONT_SIZE 10 // of MeasureText
+
+typedef struct {
+  int index; // into the font glyphs
+  float x;   // pen position from the start of the string
+} TextGlyph;
+
+typedef struct {
+  uint64_t hash, used; // used: clock of the last lookup, 0 while empty
+  unsigned int texture; // font.texture.id and font.glyphs identify the font
+  const GlyphInfo *glyphs;
+  float font_size, spacing;
+  Vector2 size;
+  bool shaped; // `run` is valid
+  size_t run_len;
+  TextGlyph run[RC_TEXT_CACHE_STR_LEN];
+  char text[RC_TEXT_CACHE_STR_LEN];
+} TextEntry;
+
+struct TextCache {
+  uint64_t clock;
+  TextEntry entries[RC_TEXT_CACHE_SETS * RC_TEXT_CACHE_WAYS];
+};
+
+static TextEntry *text_cache_lookup(TextCache *cache, Font font,
+                                    const char *text, float font_size,
+                                    float spacing);
+static void text_entry_shape(TextEntry *entry, Font font);
+
+TextCache *text_cache_create(Arena *arena) {
+  TextCache *cache = arena_alloc(arena, sizeof(TextCache));
+  memset(cache, 0, sizeof(TextCache));
+  return cache;
+}
+
+/**
+returns the entry of `text`, filling the least recently used entry of its set
+on a miss, or NULL if `text` cannot be cached
+*/
+static TextEntry *text_cache_lookup(TextCache *cache, Font font,
+                                    const char *text, float font_size,
+                                    float spacing) {
+  uint64_t hash = 1469598103934665603u; // FNV-1a
+  size_t len = 0;
+  for (; text[len] != '\0'; ++len) {
+    if (len == RC_TEXT_CACHE_STR_LEN - 1 || text[len] == '\n')
+      return NULL;
+    hash = (hash ^ (unsigned char)text[len]) * 1099511628211u;
+  }
+  TextEntry *set =
+      cache->entries + (hash % RC_TEXT_CACHE_SETS) * RC_TEXT_CACHE_WAYS;
+  TextEntry *victim = set;
+  cache->clock += 1;
+  for (size_t w = 0; w < RC_TEXT_CACHE_WAYS; ++w) {
+    TextEntry *entry = set + w;
+    if (entry->used != 0 && entry->hash == hash &&
+        entry->texture == font.texture.id && entry->glyphs == font.glyphs &&
+        entry->font_size == font_size && entry->spacing == spacing &&
+        strcmp(entry->text, text) == 0) {
+      entry->used = cache->clock;
+      return entry;
+    }
+    if (entry->used < victim->used)
+      victim = entry;
+  }
+  victim->hash = hash;
+  victim->used = cache->clock;
+  victim->texture = font.texture.id;
+  victim->glyphs = font.glyphs;
+  victim->font_size = font_size;
+  victim->spacing = spacing;
+  victim->size = MeasureTextEx(font, text, font_size, spacing);
+  victim->shaped = false;
+  memcpy(victim->text, text, len + 1);
+  return victim;
+}
+
+/**
+lays the glyphs out the way DrawTextEx does. Stays unshaped while there is no
+font to take the glyphs from (before the window is opened)
+*/
+static void text_entry_shape(TextEntry *entry, Font font) {
+  if (font.texture.id == 0)
+    font = GetFontDefault();
+  if (font.glyphs == NULL)
+    return;
+  float scale = entry->font_size / font.baseSize, x = 0.f;
+  entry->run_len = 0;
+  for (int size = 0, i = 0; entry->text[i] != '\0'; i += size) {
+    int codepoint = GetCodepointNext(entry->text + i, &size);
+    int index = GetGlyphIndex(font, codepoint);
+    if (codepoint != ' ' && codepoint != '\t')
+      entry->run[entry->run_len++] = (TextGlyph){.index = index, .x = x};
+    x += (font.glyphs[index].advanceX == 0 ? font.recs[index].width
+                                           : font.glyphs[index].advanceX) *
+             scale +
+         entry->spacing;
+  }
+  entry->shaped = true;
+}
+
+Vector2 text_measure(TextCache *cache, Font font, const char *text,
+                     float font_size, float spacing) {
+  TextEntry *entry;
+  if (canvas_active() != NULL ||
+      (entry = text_cache_lookup(cache, font, text, font_size, spacing)) ==
+          NULL)
+    return canvas_measure_text(font, text, font_size, spacing);
+  return entry->size;
+}
+
+void text_draw(TextCache *cache, Font font, const char *text, Vector2 position,
+               float font_size, float spacing, Color tint) {
+  TextEntry *entry;
+  if (canvas_active() != NULL ||
+      (entry = text_cache_lookup(cache, font, text, font_size, spacing)) ==
+          NULL) {
+    canvas_draw_text(font, text, position, font_size, spacing, tint);
+    return;
+  }
+  if (!entry->shaped)
+    text_entry_shape(entry, font);
+  if (!entry->shaped) {
+    DrawTextEx(font, text, position, font_size, spacing, tint);
+    return;
+  }
+  if (font.texture.id == 0)
+    font = GetFontDefault();
+  // same rectangles as DrawTextCodepoint
+  float scale = font_size / font.baseSize, padding = font.glyphPadding;
+  for (size_t i = 0; i < entry->run_len; ++i) {
+    int index = entry->run[i].index;
+    Rectangle rec = font.recs[index];
+    Rectangle source = {rec.x - padding, rec.y - padding,
+                        rec.width + 2.f * padding, rec.height + 2.f * padding};
+    Rectangle dest = {
+        position.x + entry->run[i].x + font.glyphs[index].offsetX * scale -
+            padding * scale,
+        position.y + font.glyphs[index].offsetY * scale - padding * scale,
+        source.width * scale, source.height * scale};
+    DrawTexturePro(font.texture, source, dest, (Vector2){0, 0}, 0.f, tint);
+  }
+}
+
+float text_align(TextCache *cache, Font font, const char *text, int width,
+                 int font_size, int spacing, Rc_Alignment alignment) {
+  float f = text_measure(cache, font, text, font_size, spacing).x;
+  if (f == 0.f && canvas_active() == NULL) { // as MeasureText
+    int size = maxl(font_size, RC_TEXT_DEFAULT_FONT_SIZE);
+    f = (int)text_measure(cache, GetFontDefault(), text, size,
+                          size / RC_TEXT_DEFAULT_FONT_SIZE)
+            .x;
+  }
+  if ((float)width < f) {
+    return 0.f;
+  }
+  switch (alignment) {
+  case RC_ALIGNMENT_CENTER:
+    return (width - f) / 2;
+  case RC_ALIGNMENT_LEFT:
+    return 0.f;
+  case RC_ALIGNMENT_RIGHT:
+    return width - f;
+  }
+  RC_ERROR("non reachable condition\n");
+  return 0.f;
+}
@@ -0,0 +1,43 @@
+/*
+ * TextCache
+ * ---------
+ * layouts of the strings a figure draws, keyed by (string, font, size,
+ * spacing). An entry keeps the measured size and, once drawn, the glyph run:
+ * the glyph index and pen x of every visible character. Drawing a cached
+ * string is then one DrawTexturePro per glyph, without utf8 decoding, glyph
+ * lookups or measuring. Entries live in RC_TEXT_CACHE_SETS sets of
+ * RC_TEXT_CACHE_WAYS and the least recently used one of a set is replaced.
+ * Strings of RC_TEXT_CACHE_STR_LEN bytes or more, strings with new lines and
+ * everything drawn into a canvas bypass the cache.
+ */
+#ifndef __RAYCANDLE_TEXT__
+#define __RAYCANDLE_TEXT__
+
+#include "arena.h"
+#include "raylib.h"
+#include "utils.h"
+
+#define RC_TEXT_CACHE_SETS 32
+#define RC_TEXT_CACHE_WAYS 4
+#define RC_TEXT_CACHE_STR_LEN 128 // bytes, with the terminating NUL
+
+typedef struct TextCache TextCache;
+
+TextCache *text_cache_create(Arena *arena);
+/**
+same as canvas_measure_text
+*/
+Vector2 text_measure(TextCache *cache, Font font, const char *text,
+                     float font_size, float spacing);
+/**
+same as canvas_draw_text
+*/
+void text_draw(TextCache *cache, Font font, const char *text, Vector2 position,
+               float font_size, float spacing, Color tint);
+/**
+x offset of `text` aligned in `width` pixels; 0 if it does not fit
+*/
+float text_align(TextCache *cache, Font font, const char *text, int width,
+                 int font_size, int spacing, Rc_Alignment alignment);
+
+#endif //__RAYCANDLE_TEXT__
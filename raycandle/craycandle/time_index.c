@@ -0,0 +1,116 @@
+#include "time_index.h"
+
+#include <math.h>
+#include <stdbool.h>
+
+#include "figure.h"
+#include "publish.h"
+#include "utils.h"
+
+/**
+the first of `xdata` after `epoch` if `upper` else at or after it. Branchless:
+the next probe only depends on a comparison, so the loads of a search over
+millions of rows are not serialized behind mispredicted branches
+*/
+static inline size_t time_index_search(const double *xdata, size_t len,
+                                       double epoch, bool upper) {
+  if (len == 0)
+    return 0;
+  const double *base = xdata;
+  while (len > 1) {
+    size_t half = len / 2;
+    base += (upper ? base[half] <= epoch : base[half] < epoch) ? half : 0;
+    len -= half;
+  }
+  return (base - xdata) + (upper ? *base <= epoch : *base < epoch);
+}
+
+size_t time_index_lower_bound(const double *xdata, size_t len, double epoch) {
+  return time_index_search(xdata, len, epoch, false);
+}
+
+size_t time_index_upper_bound(const double *xdata, size_t len, double epoch) {
+  return time_index_search(xdata, len, epoch, true);
+}
+
+void time_index_map_slots(Dragger *dragger) {
+  if (dragger->xmapping == X_MAPPING_INDEX) {
+    for (size_t i = 0; i < dragger->slots; ++i)
+      dragger->xdata_shared[i] = (double)i / dragger->slots;
+    dragger->slot_fill = 1;
+    return;
+  }
+  // a slot starts where the timeframe of its first bar does, limit_min is
+  // half a timeframe before the first visible bar
+  double first = dragger->xdata[dragger->start];
+  double diff = dragger->locator.limit.diff;
+  size_t range[2];
+  for (size_t i = 0; i < dragger->slots; ++i) {
+    dragger_slot_range(dragger, i, range);
+    dragger->xdata_shared[i] = (dragger->xdata[range[0]] - first) / diff;
+  }
+  dragger->slot_fill = fmin(1, dragger->vlen * (double)dragger->timeframe / diff);
+}
+
+size_t time_index_row_at_pixel(Axes *axes, int pixel) {
+  Dragger *dragger = &axes->parent->dragger;
+  double ratio = (pixel - axes->startX) / (double)axes->width;
+  if (dragger->xmapping == X_MAPPING_INDEX) {
+    double row = fmax(ratio * dragger->vlen, 0);
+    return dragger->start + minl((size_t)row, dragger->vlen - 1);
+  }
+  // the last bar whose timeframe starts at or before the time under `pixel`
+  double epoch = dragger->locator.limit.limit_min +
+                 ratio * dragger->locator.limit.diff + dragger->timeframe / 2.f;
+  size_t rows = time_index_upper_bound(dragger->xdata + dragger->start,
+                                       dragger->vlen, epoch);
+  return dragger->start + (rows ? rows - 1 : 0);
+}
+
+size_t figure_time_range(Figure *figure, double from, double to,
+                         size_t range[2]) {
+  RC_ASSERT(figure->has_dragger, "call `set_dragger` first\n");
+  Dragger *dragger = &figure->dragger;
+  range[0] = time_index_lower_bound(dragger->xdata, dragger->_len, from);
+  range[1] = maxl(time_index_upper_bound(dragger->xdata, dragger->_len, to),
+                  range[0]);
+  return range[1] - range[0];
+}
+
+void figure_goto_time(Figure *figure, double epoch) {
+  RC_ASSERT(figure->has_dragger, "call `set_dragger` first\n");
+  if (publish_goto_time(figure, epoch))
+    return;
+  Dragger *dragger = &figure->dragger;
+  size_t row = minl(time_index_lower_bound(dragger->xdata, dragger->_len, epoch),
+                    dragger->_len - 1);
+  size_t start = row > dragger->vlen / 2 ? row - dragger->vlen / 2 : 0;
+  dragger->start = minl(start, dragger->_len - dragger->vlen);
+  figure->force_update = true;
+}
+
+void figure_set_xlim(Figure *figure, double xminmax[2]) {
+  RC_ASSERT(figure->has_dragger, "call `set_dragger` first\n");
+  RC_ASSERT(xminmax[0] <= xminmax[1], "xmin is after xmax\n");
+  if (publish_set_xlim(figure, xminmax))
+    return;
+  size_t range[2];
+  if (figure_time_range(figure, xminmax[0], xminmax[1], range) == 0) {
+    RC_WARN("no bars between %f and %f, going to the next one\n", xminmax[0],
+            xminmax[1]);
+    figure_goto_time(figure, xminmax[0]);
+    return;
+  }
+  figure->dragger.start = range[0];
+  figure->dragger.vlen = range[1] - range[0];
+  figure->force_update = true;
+}
+
+void figure_set_xmapping(Figure *figure, XMapping xmapping) {
+  RC_ASSERT(figure->has_dragger, "call `set_dragger` first\n");
+  RC_ASSERT(xmapping == X_MAPPING_INDEX || xmapping == X_MAPPING_TIME);
+  if (publish_set_xmapping(figure, xmapping))
+    return;
+  figure->dragger.xmapping = xmapping;
+  figure->force_update = true;
+}
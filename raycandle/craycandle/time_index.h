@@ -0,0 +1,40 @@
+/*
+ * Time index
+ * ----------
+ * maps epochs to rows of the shared xdata and rows to pixels. `Dragger.xdata`
+ * is the index: set_dragger, figure_append_bar, feeds and bar files keep its
+ * timestamps increasing, so any epoch is found with a binary search of
+ * O(log n) probes (26 for 50M bars) and without memory of its own, which
+ * matters when the xdata is a mapped bar file column.
+ *
+ * Where a row is drawn depends on `Dragger.xmapping`. X_MAPPING_INDEX spaces
+ * the visible bars evenly, so overnight, weekend and halted-session gaps
+ * collapse. X_MAPPING_TIME puts a bar at its timestamp: the gaps are drawn as
+ * empty space, and the bars get the width of `timeframe` seconds.
+ */
+#ifndef __RAYCANDLE_TIME_INDEX__
+#define __RAYCANDLE_TIME_INDEX__
+
+#include <stddef.h>
+
+#include "raycandle.h"
+
+/**
+the first of the `len` increasing `xdata` at or after `epoch`, `len` if none
+*/
+size_t time_index_lower_bound(const double *xdata, size_t len, double epoch);
+/**
+the first of the `len` increasing `xdata` after `epoch`, `len` if none
+*/
+size_t time_index_upper_bound(const double *xdata, size_t len, double epoch);
+/**
+fills `dragger->xdata_shared` and `dragger->slot_fill` for the visible rows.
+Called by update_xlim once the x limits are set
+*/
+void time_index_map_slots(Dragger *dragger);
+/**
+the visible row drawn under the pixel column `pixel` of `axes`
+*/
+size_t time_index_row_at_pixel(Axes *axes, int pixel);
+
+#endif //__RAYCANDLE_TIME_INDEX__
@@ -1,3 +1,4 @@
+#include <math.h>
 #include <stdlib.h>
 
 #include "raycandle.h"
@@ -14,6 +15,7 @@
 #include "log.h"
 
 
+#include "time_index.h"
 #include "utils.h"
 
 
@@ -32,27 +34,6 @@ Color FadeToBlack(Color c, float amount) {
 }
 
 
-float align_text(Font font, const char *text, int width, int font_size,
-                 int spacing, Rc_Alignment alignment) {
-  float f = MeasureTextEx(font, text, font_size, spacing).x;
-  if (f == 0.f) {
-    f = MeasureText(text, font_size);
-  }
-  if ((float)width < f) {
-    return 0.f;
-  }
-  switch (alignment) {
-  case RC_ALIGNMENT_CENTER:
-    return (width - f) / 2;
-  case RC_ALIGNMENT_LEFT:
-    return 0.f;
-  case RC_ALIGNMENT_RIGHT:
-    return width - f;
-  }
-  RC_ERROR("non reachable condition\n");
-  return 0.f;
-}
-
 Color RC_faded_color_from(Color original) {
   uint8_t fade_amount = 70;
   Color faded;
@@ -75,9 +56,15 @@ Color axes_get_next_tableau_t10_color(Axes *axes) {
 }
 
 double RC_PIXEL_X_2_DATA(int pixel, Axes *axes) {
-  double a = ((pixel - axes->startX) / (double)axes->width) *
-                 axes->parent->dragger.vlen +
-             axes->parent->dragger.start;
-  return axes->parent->dragger.xdata[(size_t)a] +
-         (a - ((long int)a)) * axes->parent->dragger.timeframe;
+  Dragger *dragger = &axes->parent->dragger;
+  double ratio = (pixel - axes->startX) / (double)axes->width;
+  if (dragger->xmapping == X_MAPPING_TIME)
+    return dragger->locator.limit.limit_min + ratio * dragger->locator.limit.diff;
+  size_t row = time_index_row_at_pixel(axes, pixel);
+  double a = ratio * dragger->vlen + dragger->start;
+  // time within the bar, which ends at the next one when a gap does not
+  double span = dragger->timeframe;
+  if (row + 1 < dragger->_len)
+    span = fmin(span, dragger->xdata[row + 1] - dragger->xdata[row]);
+  return dragger->xdata[row] + fmin(fmax(a - row, 0), 1) * span;
 }
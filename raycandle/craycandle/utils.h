@@ -1,3 +1,6 @@
+#ifndef __RAYCANDLE_UTILS__
+#define __RAYCANDLE_UTILS__
+
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -69,11 +72,11 @@ typedef enum {
 } Rc_Alignment;
 
 
-float align_text(Font font, const char *text, int width, int font_size,int spacing,Rc_Alignment alignment); // returns startx for the text
-
 Color FadeToBlack(Color c, float amount);
 
 Color axes_get_next_tableau_t10_color(Axes *axes);
 
 /*some figure defaults*/
 #undef CUSM_PREFIX
+
+#endif //__RAYCANDLE_UTILS__
@@ -1,10 +1,14 @@
 from enum import Enum, unique
 
 __all__ = [
+    "Aggregation",
     "ArtistType",
+    "DataType",
     "FormatterType",
+    "IndicatorType",
     "LegendPosition",
     "LineType",
+    "XMapping",
 ]
 
 
@@ -25,6 +29,8 @@ class GeneralEnum(Enum):
 class ArtistType(GeneralEnum):
     LINE = 0
     CANDLE = 1
+    BAR = 2  # volumes, histograms
+    HEATMAP = 3  # depth behind prices
 
 
 class FormatterType(GeneralEnum):
@@ -44,3 +50,33 @@ class LineType(GeneralEnum):
     S_LINE = 0
     H_LINE = 1
     V_LINE = 2
+
+
+class XMapping(GeneralEnum):
+    INDEX = 0  # bars evenly spaced, gaps between sessions collapse
+    TIME = 1  # bars at their timestamps, gaps are empty space
+
+
+class IndicatorType(GeneralEnum):
+    SMA = 0  # params: window
+    EMA = 1  # params: span
+    RSI = 2  # params: period
+    BOLLINGER = 3  # params: window
+    STOCH = 4  # params: k, d, m
+    ADX = 5  # params: window
+    ATR = 6  # params: window
+
+
+class Aggregation(GeneralEnum):
+    LAST = 0  # value of the last bar of the bucket
+    FIRST = 1  # value of its first bar
+    MAX = 2
+    MIN = 3
+    SUM = 4  # volumes
+    OHLC = 5  # 4 columns: first, max, min and last, for candles
+
+
+class DataType(GeneralEnum):
+    FLOAT64 = 0
+    FLOAT32 = 1
+    INT64 = 2  # INT64_MIN reads as NaN
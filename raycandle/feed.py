@@ -0,0 +1,158 @@
+from typing import Any
+
+import numpy as np
+import pandas as pd
+from typing_extensions import override
+
+from .artists import Bar, Candle, Line
+from .figure import load_api
+
+__all__ = ["Feed", "FeedLine", "FeedCandle", "FeedBar"]
+
+
+class Feed:
+    """
+    a ring of bars in shared memory, written by a single producer process and
+    drawn by figures in other processes without copies or locks, see
+    `Figure.attach_feed`. Every bar has an epoch and `cols` values
+    """
+
+    def __init__(self, feed: Any, name: str) -> None:
+        self._api = load_api()
+        self._feed = feed
+        self.name = name
+
+    @classmethod
+    def create(cls, name: str, cols: int, capacity: int, timeframe: int) -> "Feed":
+        """
+        creates (or replaces) the feed `name` holding the last `capacity` bars
+        `timeframe` seconds apart, for the producer to publish into
+        """
+        api = load_api()
+        feed = api.lib.feed_create(api.cstr(name), cols, capacity, timeframe)
+        if feed == api.ffi.NULL:
+            raise OSError(f"cannot create feed '{name}'")
+        return cls(feed, name)
+
+    @classmethod
+    def open(cls, name: str) -> "Feed":
+        """
+        opens the feed `name` read only, for a figure to attach to
+        """
+        api = load_api()
+        feed = api.lib.feed_open(api.cstr(name))
+        if feed == api.ffi.NULL:
+            raise OSError(f"cannot open feed '{name}'")
+        return cls(feed, name)
+
+    @property
+    def cols(self) -> int:
+        return self._api.lib.feed_cols(self._feed)
+
+    @property
+    def published(self) -> int:
+        """
+        bars published so far
+        """
+        return self._api.lib.feed_published(self._feed)
+
+    def _values(self, values: Any) -> Any:
+        self._last = np.ascontiguousarray(values, dtype=np.float64).ravel()
+        if len(self._last) != self.cols:
+            raise Exception("length mismatch")
+        return self._api.ffi.cast("double*", self._last.ctypes.data)
+
+    def publish(self, x: float, values: Any) -> None:
+        """
+        publishes a bar at epoch `x`, after the previous one
+        """
+        self._api.lib.feed_publish(self._feed, float(x), self._values(values))
+
+    def update_last(self, values: Any) -> None:
+        """
+        rewrites the values of the last published bar
+        """
+        self._api.lib.feed_update_last(self._feed, self._values(values))
+
+    def close(self) -> None:
+        """
+        unmaps the feed. Figures attached to it must have been destroyed
+        """
+        self._api.lib.feed_close(self._feed)
+        self._feed = self._api.ffi.NULL
+
+    def unlink(self) -> None:
+        """
+        removes the name of the feed; mapped feeds stay valid
+        """
+        self._api.lib.feed_unlink(self._api.cstr(self.name))
+
+
+class FeedLine(Line):
+    """
+    a Line of value column `col` of the feed attached to the figure
+    """
+
+    def __init__(self, col: int, **kwargs):
+        super().__init__(pd.Series(dtype=np.float64), **kwargs)
+        self.__dict__.pop("xdata", None)  # the x-axis comes from the feed
+        self.col = col
+
+    def _gdata(self, cols: int) -> Any:
+        return self._rc_api.lib.figure_feed_gdata(
+            self._rc_api.fig, self.col, cols, self._label
+        )
+
+    @override
+    def _get_create_args(self) -> tuple[Any]:
+        args = super()._get_create_args()
+        return (args[0], self._gdata(1), *args[2:])
+
+    @override
+    def set_data(self, data: Any) -> None:
+        raise NotImplementedError("feed artists are updated by their feed")
+
+
+class FeedCandle(Candle):
+    """
+    a Candle of the value columns [col, col+4) of the feed attached to the
+    figure, in o,h,l,c order
+    """
+
+    def __init__(self, col: int = 0, **kwargs):
+        super().__init__(pd.DataFrame(columns=list("ohlc"), dtype=np.float64), **kwargs)
+        del self.xdata  # the x-axis comes from the feed
+        self.col = col
+
+    _gdata = FeedLine._gdata
+
+    @override
+    def _get_create_args(self) -> tuple[Any]:
+        args = super()._get_create_args()
+        return (args[0], self._gdata(4), *args[2:])
+
+    @override
+    def set_data(self, data: Any) -> None:
+        raise NotImplementedError("feed artists are updated by their feed")
+
+
+class FeedBar(Bar):
+    """
+    Bars of value column `col` of the feed attached to the figure, e.g volumes
+    """
+
+    def __init__(self, col: int, **kwargs):
+        super().__init__(pd.Series(dtype=np.float64), **kwargs)
+        del self.xdata  # the x-axis comes from the feed
+        self.col = col
+
+    _gdata = FeedLine._gdata
+
+    @override
+    def _get_create_args(self) -> tuple[Any]:
+        args = super()._get_create_args()
+        return (args[0], self._gdata(1), *args[2:])
+
+    @override
+    def set_data(self, data: Any) -> None:
+        raise NotImplementedError("feed artists are updated by their feed")
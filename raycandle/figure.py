@@ -1,3 +1,4 @@
+import contextlib
 import itertools
 import threading
 import warnings
@@ -18,6 +19,17 @@ FONT_PATH = "fonts/font.ttf"
 FPATH = os.path.dirname(__file__)
 
 
+def load_api() -> Type[_Api]:
+    """
+    loads the library once per process; figures and feeds share it
+    """
+    if not hasattr(_Api, "lib"):
+        _Api.ffi = cffi.FFI()
+        _Api.lib = _Api.ffi.dlopen(os.path.join(FPATH, LIB_NAME))
+        _Api.ffi.cdef(open(os.path.join(FPATH, CDEF_NAME)).read())
+    return _Api
+
+
 class Collector:
     def __init__(self, fig: RC_Figure, *args: RC_Artist):
         self._artists, self.__data_names__ = [], set()
@@ -46,11 +58,29 @@ class Collector:
             raise RuntimeError(
                 f"length mismatch; prev {self._fig.len_data} new {len(df)}"
             )
-        self._fig.set_xdata(df.index)
         if diff := self.__data_names__.difference(df.columns):
             raise ValueError(f"missing column names {diff}")
-        tuple(map(lambda x: x.set_data(df[x.__data_names__]), self._artists))
-        self._fig.update()
+        with self._fig.publish():
+            self._fig.set_xdata(df.index)
+            tuple(map(lambda x: x.set_data(df[x.__data_names__]), self._artists))
+            self._fig.update()
+
+    def update_last(self, row: pd.Series):
+        """
+        sets the last bar of every artist from `row` (indexed by column names)
+        """
+        if diff := self.__data_names__.difference(row.index):
+            raise ValueError(f"missing column names {diff}")
+        with self._fig.publish():
+            tuple(map(lambda x: x.update_last(row[x.__data_names__]), self._artists))
+
+    def append(self, x: float, row: pd.Series):
+        """
+        appends a new bar at epoch `x` and fills it from `row`
+        """
+        with self._fig.publish():
+            self._fig.append_bar(x)
+            self.update_last(row)
 
 
 class Figure(RC_Figure):
@@ -94,11 +124,8 @@ class Figure(RC_Figure):
         self._init()
 
     def _load_lib(self) -> None:
-        self._rc_api = _Api
+        self._rc_api = load_api()
         self._rc_api.is_window_closed = False
-        self._rc_api.ffi = cffi.FFI()
-        self._rc_api.lib = self._rc_api.ffi.dlopen(os.path.join(FPATH, LIB_NAME))
-        self._rc_api.ffi.cdef(open(os.path.join(FPATH, CDEF_NAME)).read())
 
     @property
     def is_window_closed(self) -> bool:
@@ -107,7 +134,7 @@ class Figure(RC_Figure):
     @property
     @window_not_closed
     def len_data(self) -> int:
-        return self._rc_api.fig.dragger._len
+        return self._rc_api.lib.figure_base_len(self._rc_api.fig)  # any timeframe
 
     def _init(self) -> None:
         self.axes = self.ax = [Axes(i, self) for i in range(self._rc_api.fig.axes_len)]
@@ -118,7 +145,7 @@ class Figure(RC_Figure):
         self._rc_api.lib.show(self._rc_api.fig)
         self._rc_api.is_window_closed = True
         # clean afterwards
-        self._rc_api.lib.cm_free_all_()
+        self._rc_api.lib.destroy_figure(self._rc_api.fig)
 
     def _wait_init(self) -> None:
         """
@@ -128,13 +155,15 @@ class Figure(RC_Figure):
         self._rc_api.lib.figure_wait_initialized(self._rc_api.fig)
 
     @window_not_closed
-    def show(self, block: bool = True) -> None:
+    def show(self, block: bool = True, appends: int = 0) -> None:
         """
         starts a game loop and draws artists on the screen.
 
         args
         ----
         block: whether to use a separate thead to run the game loop.
+        appends: bars expected to be appended while shown, reserved before the
+            window opens (see `reserve`)
 
         if False, this function will return immediately otherwise it will block until the window is closed
 
@@ -142,13 +171,96 @@ class Figure(RC_Figure):
         -----
         sending SIGINT will be ignored if `show` runs on the main thread i;e Ctrl-C won't work
         """
+        if appends > 0:
+            self.reserve(self.len_data + appends)
         if not block:
             threading.Thread(target=self._show).start()
             self._wait_init()
             return
         self._show()
-        self._wait_init()
-        self._rc_api.lib.cm_free_all_()
+
+    @window_not_closed
+    def destroy(self) -> None:
+        """
+        frees the figure with its axes and artists; it cannot be used afterwards.
+        A shown figure is destroyed when its window is closed
+        """
+        self._rc_api.is_window_closed = True
+        self._rc_api.lib.destroy_figure(self._rc_api.fig)
+
+    @window_not_closed
+    def render(self, path: str) -> None:
+        """
+        renders the figure without a window and writes it to `path`; a PNG if
+        `path` ends with '.png' otherwise raw RGBA. A rendered figure cannot be shown
+        """
+        if not self._rc_api.lib.figure_render_to_file(
+            self._rc_api.fig, self._rc_api.cstr(path)
+        ):
+            raise OSError(f"cannot write '{path}'")
+
+    @window_not_closed
+    def render_array(self) -> np.ndarray:
+        """
+        renders the figure without a window and returns the pixels as a
+        (height, width, 4) uint8 RGBA array
+        """
+        fig = self._rc_api.fig
+        pixels = np.empty((fig.height, fig.width, 4), dtype=np.uint8)
+        self._rc_api.lib.figure_render(
+            fig, self._rc_api.ffi.cast("uint8_t*", pixels.ctypes.data)
+        )
+        return pixels
+
+    @window_not_closed
+    def set_size(self, size: tuple[int, int]) -> None:
+        """
+        sets (width, height) of the next `render`
+        """
+        self._rc_api.lib.figure_set_size(self._rc_api.fig, *size)
+
+    @window_not_closed
+    def set_min_refresh(self, seconds: float) -> None:
+        """
+        while nothing changes `show` draws a frame every `seconds` (1 by default)
+        and sleeps in between; 0 draws at the target fps all the time
+        """
+        self._rc_api.lib.figure_set_min_refresh(self._rc_api.fig, seconds)
+
+    def enable_profiler(self, enable: bool = True, overlay: bool = False) -> None:
+        """
+        times each phase of the render loop. `overlay` shows the per phase
+        percentiles on screen; it can also be toggled with the key P
+        """
+        self._rc_api.lib.profiler_enable(enable)
+        self._rc_api.fig.show_profiler = enable and overlay
+
+    def profile(self, quantiles: tuple[float, ...] = (0.5, 0.9, 0.99)) -> dict:
+        """
+        returns {phase: [microseconds per frame at each quantile]} over the
+        recent frames in which the phase ran
+        """
+        lib, ffi = self._rc_api.lib, self._rc_api.ffi
+        return {
+            ffi.string(lib.profiler_phase_name(phase)).decode(): [
+                lib.profiler_percentile(phase, q) for q in quantiles
+            ]
+            for phase in range(lib.PROFILE_PHASE_LEN)
+            if lib.profiler_samples(phase) > 0
+        }
+
+    def trace_start(self, max_events: int = 100_000) -> None:
+        """
+        records every timed phase, keeping the last `max_events`
+        """
+        self._rc_api.lib.profiler_trace_start(max_events)
+
+    def trace_dump(self, path: str) -> None:
+        """
+        writes the recorded phases as Chrome trace event JSON (chrome://tracing, Perfetto)
+        """
+        if not self._rc_api.lib.profiler_trace_dump(self._rc_api.cstr(path)):
+            raise OSError(f"cannot write '{path}'")
 
     @window_not_closed
     def show_cursors(self) -> None:
@@ -160,9 +272,72 @@ class Figure(RC_Figure):
         sets the shared x-axis data. All artists plotted after this method is called
         shall be treated as using `xdata` for their xdata
         """
-        if len(self._xdata) != len(xdata):
+        if self.len_data != len(xdata):
             raise Exception("length mismatch")
-        self._xdata[0:] = xdata.astype(np.float64)
+        if np.any(np.diff(np.asarray(xdata, dtype=np.float64)) <= 0):
+            raise ValueError("xdata must be increasing")
+        published = self._xdata
+        self._xdata = np.ascontiguousarray(xdata, dtype=np.float64)
+        self._pxdata = self._rc_api.ffi.cast("double*", self._xdata.ctypes.data)
+        self._rc_api.lib.figure_set_xdata(self._rc_api.fig, self._pxdata)
+        # drawn until the next change is published; the one before it may still be
+        # drawn until figure_set_xdata returns
+        self._published_xdata = published
+
+    @contextlib.contextmanager
+    def publish(self):
+        """
+        changes made in the block (`set_xdata`, `set_data`, `update_last`, `append_bar`,
+        `update`) are drawn together: a figure shown with `show(block=False)` never
+        draws some of them without the others. Changes from another thread wait
+        until the block ends
+        """
+        self._rc_api.lib.figure_publish_begin(self._rc_api.fig)
+        try:
+            yield self
+        finally:
+            self._rc_api.lib.figure_publish_end(self._rc_api.fig)
+
+    @window_not_closed
+    def reserve(self, bars: int) -> None:
+        """
+        copies all data into buffers the figure owns holding `bars` bars, so that
+        appends up to `bars` never copy the history on a frame. Call it after
+        plotting, before `show`
+        """
+        self._rc_api.lib.figure_reserve(self._rc_api.fig, bars)
+
+    @window_not_closed
+    def append_bar(self, x: float) -> None:
+        """
+        appends a bar at epoch `x`. artists get a NaN bar that is filled with
+        `RC_Artist.update_last`. From the first call the figure owns copies of all data:
+        that call, and the ones doubling the copies, cost O(bars) unless `reserve`d
+        """
+        self._rc_api.lib.figure_append_bar(self._rc_api.fig, float(x))
+
+    @window_not_closed
+    def attach_feed(self, feed: Any) -> None:
+        """
+        draws the bars of `feed` (a `raycandle.Feed` with at least one bar); bars
+        published or updated by its producer show up on the next frame. Its columns
+        are plotted with `raycandle.FeedLine` and `raycandle.FeedCandle`
+        """
+        self._feed = feed  # keeps it mapped
+        self._rc_api.lib.figure_attach_feed(
+            self._rc_api.fig, feed._feed, self._xformatter_type, self._xlim_format
+        )
+
+    @window_not_closed
+    def attach_bar_file(self, file: Any) -> None:
+        """
+        draws the bars of `file` (a `raycandle.BarFile`) without loading them. Its
+        columns are plotted with `raycandle.BarFileLine` and `raycandle.BarFileCandle`
+        """
+        self._bar_file = file  # keeps it mapped
+        self._rc_api.lib.figure_attach_bar_file(
+            self._rc_api.fig, file._file, self._xformatter_type, self._xlim_format
+        )
 
     @window_not_closed
     def update_from_position(self, far_right_position: int):
@@ -192,6 +367,9 @@ class Figure(RC_Figure):
                 f"expects an attribute `xdata` to be set for {type(artist)}"
             )
         if self._xdata is None:
+            xdata = artist.xdata[~np.isnan(artist.xdata)]
+            if np.any(np.diff(xdata) <= 0):
+                raise ValueError("xdata must be increasing")
             timeframe = np.bincount(
                 [x for x in np.diff(artist.xdata) if not np.isnan(x)]
             ).argmax()
@@ -200,7 +378,8 @@ class Figure(RC_Figure):
                 != 1
             ):
                 warnings.warn(
-                    f"index spacing is not equal, the most occurrent spacing ({timeframe}) will be applied",
+                    f"index spacing is not equal, the most occurrent spacing ({timeframe}) will be "
+                    "the bar width; see Figure.set_xmapping to draw the gaps",
                     RuntimeWarning,
                 )
             self._xdata = artist.xdata.copy()
@@ -219,6 +398,64 @@ class Figure(RC_Figure):
                     "got different xdata; all artist must share x-axis"
                 )
 
+    @window_not_closed
+    def set_xlim(self, xlim: tuple[float, float]) -> None:
+        """
+        shows the bars whose epochs are in [xmin, xmax], or goes to the next bar if
+        there are none
+        """
+        self._rc_api.lib.figure_set_xlim(self._rc_api.fig, [float(x) for x in xlim])
+
+    @window_not_closed
+    def goto_time(self, epoch: float) -> None:
+        """
+        shows the bar at or after `epoch` (the last one if none) in the middle of
+        the window, keeping its width. A binary search: instant for any number of bars
+        """
+        self._rc_api.lib.figure_goto_time(self._rc_api.fig, float(epoch))
+
+    @window_not_closed
+    def time_range(self, start: float, end: float) -> tuple[int, int]:
+        """
+        returns the positions [first, last) of the bars whose epochs are in
+        [start, end]. Call it from the thread that changes the data
+        """
+        rows = self._rc_api.ffi.new("size_t[2]")
+        self._rc_api.lib.figure_time_range(
+            self._rc_api.fig, float(start), float(end), rows
+        )
+        return rows[0], rows[1]
+
+    @window_not_closed
+    def set_xmapping(self, xmapping: XMapping) -> None:
+        """
+        `XMapping.INDEX` (the default) spaces bars evenly so overnight and weekend
+        gaps collapse; `XMapping.TIME` draws bars at their timestamps with the gaps
+        as empty space
+        """
+        self._rc_api.lib.figure_set_xmapping(self._rc_api.fig, int(xmapping))
+
+    @window_not_closed
+    def resample(self, timeframe: int) -> None:
+        """
+        shows the bars aggregated to `timeframe` seconds, a multiple of the
+        timeframe of the data; that timeframe shows them as they are. Buckets are
+        aligned to UTC days and Monday weeks, candles take open/high/low/close and
+        other artists their `Aggregation`. Data changes keep applying to the
+        original bars
+        """
+        self._rc_api.lib.figure_resample(self._rc_api.fig, timeframe)
+
+    @window_not_closed
+    def set_timeframes(self, timeframes: list[int]) -> None:
+        """
+        the timeframes (seconds) the keys 1 to 9 show, see `resample`
+        """
+        if len(timeframes) > 9:
+            raise ValueError("at most 9 timeframes have keys")
+        keys = self._rc_api.ffi.new("size_t[]", list(timeframes))
+        self._rc_api.lib.figure_set_timeframes(self._rc_api.fig, keys, len(timeframes))
+
     @window_not_closed
     def set_timeframe(self, timeframe: int) -> None:
         self._rc_api.lib.update_timeframe(self._rc_api.fig, timeframe)
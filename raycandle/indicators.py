@@ -0,0 +1,101 @@
+"""
+indicators computed by the library, with the definitions of cmnfunc
+"""
+
+from typing import Optional, Union
+
+import numpy as np
+import pandas as pd
+
+from .defines import *
+
+__all__ = ["compute_indicator", "indicator_params", "indicator_names"]
+
+_DEFAULT_PARAMS = {  # by value, GeneralEnum members do not hash
+    IndicatorType.SMA.value: (10,),
+    IndicatorType.EMA.value: (10,),
+    IndicatorType.RSI.value: (14,),
+    IndicatorType.BOLLINGER.value: (30,),
+    IndicatorType.STOCH.value: (14, 3, 3),
+    IndicatorType.ADX.value: (14,),
+    IndicatorType.ATR.value: (14,),
+}
+
+_DEFAULT_NAMES = {
+    IndicatorType.SMA.value: ["sma"],
+    IndicatorType.EMA.value: ["ema"],
+    IndicatorType.RSI.value: ["rsi"],
+    IndicatorType.BOLLINGER.value: ["ub", "mb", "lb"],
+    IndicatorType.STOCH.value: ["k", "d"],
+    IndicatorType.ADX.value: ["+dmi", "-dmi", "adx"],
+    IndicatorType.ATR.value: ["avg_tr"],
+}
+
+
+def indicator_params(indicator: IndicatorType, params: tuple[int, ...]) -> list[int]:
+    """
+    `params` completed with the defaults of `indicator` (those of cmnfunc)
+    """
+    defaults = _DEFAULT_PARAMS[int(indicator)]
+    if len(params) > len(defaults):
+        raise ValueError(f"{indicator} takes at most {len(defaults)} parameters")
+    params = list(params) + list(defaults[len(params) :])
+    if any(int(p) <= 0 for p in params):
+        raise ValueError("indicator parameters must be positive")
+    return [int(p) for p in params] + [0] * (3 - len(params))
+
+
+def indicator_names(
+    indicator: IndicatorType, names: Optional[list[str]] = None
+) -> list[str]:
+    default = _DEFAULT_NAMES[int(indicator)]
+    if names is None:
+        return list(default)
+    if len(names) != len(default):
+        raise ValueError(f"{indicator} has {len(default)} outputs")
+    return list(names)
+
+
+def compute_indicator(
+    indicator: IndicatorType,
+    data: Union[pd.Series, pd.DataFrame],
+    *params: int,
+    names: Optional[list[str]] = None,
+) -> list[pd.Series]:
+    """
+    computes `indicator` over `data` in C, a candle DataFrame (o, h, l, c) or a
+    Series of closes, and returns one Series per output.
+
+    e.g `compute_indicator(IndicatorType.STOCH, df, 14, 3, 3)` is `cmnfunc.stoch(h, l, c)`
+    with its outputs in order (k, d)
+    """
+    from .figure import load_api  # the figure module imports this one
+
+    api = load_api()
+    ffi = api.ffi
+    params = indicator_params(indicator, params)
+    names = indicator_names(indicator, names)
+    if isinstance(data, pd.DataFrame):
+        if len(data.columns) != 4:
+            raise Exception("len of candle columns should be 4")
+        columns = [data.iloc[:, c].to_numpy(dtype=np.float64) for c in (1, 2, 3)]
+    else:
+        if indicator in (IndicatorType.STOCH, IndicatorType.ADX, IndicatorType.ATR):
+            raise TypeError(f"{indicator} needs a candle DataFrame")
+        columns = [None, None, data.to_numpy(dtype=np.float64)]
+    columns = [np.ascontiguousarray(c) if c is not None else None for c in columns]
+    outputs = [np.empty(len(data), dtype=np.float64) for _ in names]
+    hlc = ffi.new(
+        "double*[3]",
+        [
+            ffi.cast("double*", c.ctypes.data) if c is not None else ffi.NULL
+            for c in columns
+        ],
+    )
+    out = ffi.new(
+        "double*[3]", [ffi.cast("double*", o.ctypes.data) for o in outputs]
+    )
+    api.lib.indicator_compute(
+        int(indicator), ffi.new("size_t[3]", params), hlc, len(data), out
+    )
+    return [pd.Series(o, index=data.index, name=n) for o, n in zip(outputs, names)]